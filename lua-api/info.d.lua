@@ -234,6 +234,13 @@ function GetInfo(infoType) end
 ---| 304 # The current date/time
 ---| 306 # When this world was created/opened
 ---| 310 # Newlines received from the MUD (lines terminated by a newline)
+---| 311 # Output processing passes (batches of received output run through triggers)
+---| 315 # Image cache hits (images loaded without decoding, shared by all worlds)
+---| 316 # Image cache misses (images decoded from a file or memory)
+---| 317 # Memory used by cached images, in bytes
+---| 318 # Number of cached images
+---| 319 # Image format conversions performed (shared by all worlds)
+---| 320 # Image format conversions performed in the last second
 ---@return integer info
 function GetInfo(infoType) end
 
@@ -247,6 +254,9 @@ function GetInfo(infoType) end
 ---| 240 # The average width, in pixels, of a character in the output window, in the current output font. This figure is used when calculating how many characters would fit in the current width of the output window.
 ---| 241 # The height, in pixels, of a character in the output window, in the current output font.
 ---| 243 # Font size of fixed pitch font.
+---| 312 # Packets received per second
+---| 313 # Bytes received per second
+---| 314 # Output processing passes per second
 ---@return number info
 function GetInfo(infoType) end
 
@@ -468,10 +478,13 @@ function GetPluginTimerInfo(pluginID, timerName, infoType) end
 ---| 1 # The hour
 ---| 2 # The minute
 ---| 3 # The second
+---| 10 # Number of times fired
 ---| 11 # Date/time timer last fired
 ---| 12 # Date/time timer will fire next
 ---| 13 # Number of seconds until timer will fire next
 ---| 21 # User option value
+---| 27 # Average lateness in milliseconds
+---| 28 # Maximum lateness in milliseconds
 ---@return integer info
 ---
 ---@see GetTimerInfo - get information about a timer from the current plugin.
@@ -644,10 +657,13 @@ function GetTimerInfo(timerName, infoType) end
 ---| 1 # The hour
 ---| 2 # The minute
 ---| 3 # The second
+---| 10 # Number of times fired
 ---| 11 # Date/time timer last fired
 ---| 12 # Date/time timer will fire next
 ---| 13 # Number of seconds until timer will fire next
 ---| 21 # User option value
+---| 27 # Average lateness in milliseconds
+---| 28 # Maximum lateness in milliseconds
 ---@return integer info
 ---
 ---@see GetPluginTimerInfo - get information about a timer from another plugin.
@@ -900,6 +916,8 @@ function WindowInfo(windowName, infoType) end
 ---| 21 # Date/time the miniwindow was installed.
 ---| 22 # Z-Order of the miniwindow.
 ---| 23 # Plugin ID of the plugin that created this miniwindow (empty if none).
+---| 24 # Number of drawing operations in the last retained batch.
+---| 25 # Number of pixels redrawn by the last retained batch.
 ---@return integer info
 ---
 ---@see WindowFontInfo - get information about a miniwindow font.
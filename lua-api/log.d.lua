@@ -79,6 +79,26 @@ function SetLogNotes(log) end
 ---@see SetLogNotes
 function SetLogOutput(log) end
 
+---Starts recording the raw bytes received from the MUD to a file, along with when each packet arrived. Unlike a raw log, a recording keeps packet boundaries and timing, so it can be replayed later to reproduce a session. If a recording is already in progress, it is stopped first.
+---
+---Recordings are unaffected by the log file and its settings.
+---@param fileName string
+---@return error_code code #
+---`error_code.eOK`: Recording started.\
+---`error_code.eCouldNotOpenFile`: Unable to create the file.
+---
+---@see StopRecording - inverse.
+function StartRecording(fileName) end
+
+---Stops recording received bytes to a file.
+---@return error_code code #
+---`error_code.eOK`: Recording stopped.\
+---`error_code.eLogFileNotOpen`: No recording was in progress.\
+---`error_code.eLogFileBadWrite`: The end of the recording could not be written.
+---
+---@see StartRecording - inverse.
+function StopRecording() end
+
 ---This writes a message to the log file.
 ---
 ---A "newline" is appended to the line if there is not already one there.
@@ -32,18 +32,46 @@ function GetConnectDuration() end
 ---@param hostName string
 ---@return string[] addresses List of IP addresses.
 ---
+---@see GetHostAddressAsync - non-blocking version.
 ---@see GetHostName
 function GetHostAddress(hostName) end
 
+---Looks up the TCP/IP addresses for a host name without blocking, then calls a function in the current plugin with the results. Results are cached for several minutes, and the cache is shared with [`GetHostAddress`](lua://GetHostAddress).
+---
+---The callback is called as `callback(hostName, addresses)`, where `addresses` is an array of IP addresses, which is empty if the lookup failed. It is always called after this function returns, even if the result was already cached. If the plugin is removed before the lookup finishes, the callback is not called.
+---@param hostName string
+---@param callback string Name of the function to call with the results.
+---@return error_code code #
+---`error_code.eNoSuchRoutine`: The callback function does not exist.\
+---`error_code.eOK`: Lookup started.
+---
+---@see GetHostAddress - blocking version.
+---@see GetHostNameAsync
+function GetHostAddressAsync(hostName, callback) end
+
 ---This returns the name of the host which has a specified IP address, using DNS (Domain Name Server).
 ---
 ---Warning - because this function has to connect to a DNS server and await a response it may take some time to execute. It should not be used in a script where speed is the essence, or which is executed frequently. If you need to know the answer multiple times you should "cache" the result for future use.
 ---@param ipAddress string Address supplied as a "dotted decimal" string, like "66.36.226.56".
 ---@return string names Name corresponding to the supplied IP address, or an empty string if it could not be translated.
 ---
+---@see GetHostNameAsync - non-blocking version.
 ---@see GetHostAddress
 function GetHostName(ipAddress) end
 
+---Looks up the name of the host with a specified IP address without blocking, then calls a function in the current plugin with the result. Results are cached for several minutes, and the cache is shared with [`GetHostName`](lua://GetHostName).
+---
+---The callback is called as `callback(ipAddress, hostName)`. It is always called after this function returns, even if the result was already cached. If the plugin is removed before the lookup finishes, the callback is not called.
+---@param ipAddress string Address supplied as a "dotted decimal" string, like "66.36.226.56".
+---@param callback string Name of the function to call with the result.
+---@return error_code code #
+---`error_code.eNoSuchRoutine`: The callback function does not exist.\
+---`error_code.eOK`: Lookup started.
+---
+---@see GetHostName - blocking version.
+---@see GetHostAddressAsync
+function GetHostNameAsync(ipAddress, callback) end
+
 ---Returns a count of the number of bytes received from the world.
 ---@return integer bytes Byte count.
 ---
@@ -1,5 +1,28 @@
 ---@meta
 
+---@class OutputMatch
+---@field line integer Line number, as used by GetLineInfo.
+---@field column integer Column of the first character of the match.
+---@field length integer
+
+---@alias LineType
+---| 0 # Output from the MUD.
+---| 1 # Command input.
+---| 2 # Note.
+
+---@class OutputLine
+---@field text string
+---@field type LineType
+---@field time integer Time the line was received, in seconds since the epoch.
+---@field styles? StyleRun[] Only present if requested.
+
+---@class StyleRun
+---@field text string
+---@field length integer Length of `text` in bytes.
+---@field style integer Style flags, as in trigger style runs.
+---@field textcolour integer
+---@field backcolour integer
+
 ---Activates the main (first) window for this world.
 ---
 ---@see ActivateNotepad - activate a notepad window.
@@ -50,6 +73,17 @@ function GetEchoInput() end
 ---@return integer lines The number of lines received by this world.
 function GetLineCount() end
 
+---Returns lines from the output buffer, collected in a single pass. This is much faster than calling [`GetLineInfo`](lua://GetLineInfo) for each line.
+---
+---Each line is its own table, rather than being packed into one delimited string, so that lines can contain any character and their styles can be included. For just the text of recent lines from the MUD as one string, see [`GetRecentLines`](lua://GetRecentLines).
+---@param first? integer First line number, starting at 1. Default: `1`.
+---@param count? integer Number of lines. Default: every line from `first` to the end of the buffer.
+---@param styles? boolean Include style runs. Default: `false`.
+---@return OutputLine[] lines
+---
+---@see Lines - iterate over lines without building a table.
+function GetLines(first, count, styles) end
+
 ---This returns the number of lines in the output buffer (window) of this world.
 ---
 ---It will differ from [`GetLineCount`](lua://GetLineCount) once the number of lines received exceeds the size of the buffer (as early ones will be discarded).
@@ -83,6 +117,23 @@ function GetWorldWindowPosition() end
 ---@return string lines A string containing the nominated number of lines of recent MUD output, separated by the newline character (hex 0A).
 function GetRecentLines(count) end
 
+---Iterates over lines of the output buffer without collecting them into a table, for processing very large ranges.
+---
+---Each step moves on from the previous line without looking it up again. If lines are discarded from the start of the buffer during iteration, the next line is looked up by number instead, so later lines will be skipped.
+---
+---```lua
+---for line, text, type, time in Lines(1, 1000) do
+---  -- ...
+---end
+---```
+---@param first? integer First line number, starting at 1. Default: `1`.
+---@param last? integer Last line number. Default: the end of the buffer.
+---@param styles? boolean Include style runs as a fifth value. Default: `false`.
+---@return fun(): integer, string, LineType, integer, StyleRun[]? iterator
+---
+---@see GetLines - collect lines into a table.
+function Lines(first, last, styles) end
+
 ---Opens the URL you supply using the default web browser.
 ---@param url string
 ---@return error_code code #
@@ -98,7 +149,21 @@ function Pause(flag) end
 ---This closes any outstanding MXP and resets the output window colours to ANSI white on black. It also cancels underline, highlight, and inverse.
 function Reset() end
 
+---Finds every occurrence of text in the output window, from the oldest line to the newest.
+---
+---Searches use an index of the output buffer that is kept up to date as lines arrive, so only lines that could contain the text are examined. Matches do not span lines.
+---@param text string Text or regular expression to search for.
+---@param regex? boolean Treat `text` as a regular expression. Default: `false`.
+---@param matchCase? boolean Default: `true`.
+---@param limit? integer Maximum number of matches to return. Default: `0` (no limit).
+---@return OutputMatch[] matches
+---
+---@see GetLineInfo
+function SearchOutput(text, regex, matchCase, limit) end
+
 ---This sets a background image for output window. The text in the output window is drawn on top of this. If the image does not completely fill the window, the background colour is visible beneath it.
+---
+---The image is decoded in the background, so it appears shortly after this function returns. Only the file's header is checked beforehand, so if a file of a recognized type turns out to be corrupt, no image is shown.
 ---@param fileName string|nil Disk file to load the image from. The file name can be nil or an empty string, in which case any existing image will be removed.
 ---@param mode miniwin.pos See [`miniwin.pos`](lua://miniwin.pos).
 ---@return error_code code #
@@ -125,6 +190,8 @@ function SetEchoInput(echo) end
 
 ---This sets a foreground image for output window. The text in the output window is drawn under this.
 ---
+---The image is decoded in the background, so it appears shortly after this function returns. Only the file's header is checked beforehand, so if a file of a recognized type turns out to be corrupt, no image is shown.
+---
 ---With "stretching" or "tiling" modes, the text from the MUD will not be visible.
 ---@param fileName string|nil Disk file to load the image from. The file name can be nil or an empty string, in which case any existing image will be removed.
 ---@param mode miniwin.pos See [`miniwin.pos`](lua://miniwin.pos).
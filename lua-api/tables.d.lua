@@ -280,6 +280,7 @@ miniwin = {
     create_transparent = 4,
     create_ignore_mouse = 8,
     create_keep_hotspots = 16,
+    create_retained = 256,
 
     pen_solid = 0,
     pen_dash = 1,
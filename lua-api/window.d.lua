@@ -101,6 +101,27 @@ function FilterPixel(pixel, operation, options) end
 function FilterPixel(pixel, operation, options) end
 
 
+---Names a rectangle within a loaded image as a tile, so that the image can be used as a sprite sheet with [`WindowDrawTiles`](lua://WindowDrawTiles).
+---
+---`left`, `top`, `right`, `bottom` — the rectangle in the image. Zero or negative numbers for *right* and *bottom* represent an offset from the right or bottom edge of the image.
+---
+---Defining a tile again replaces it. Tiles are kept if the image is replaced, and removed if it is unloaded.
+---@param windowName string The name of an existing miniwindow.
+---@param imageID string ID of an image loaded into the miniwindow with [`WindowLoadImage`](lua://WindowLoadImage), [`WindowLoadImageMemory`](lua://WindowLoadImageMemory), or [`WindowImageFromWindow`](lua://WindowImageFromWindow).
+---@param tileID string Name of the tile.
+---@param left number
+---@param top number
+---@param right number
+---@param bottom number
+---@return error_code code #
+---`error_code.eNoSuchWindow`: No such miniwindow.\
+---`error_code.eImageNotInstalled`: That image was not loaded.\
+---`error_code.eOK`: Completed OK.
+---
+---@see WindowDrawTiles
+function WindowAddTile(windowName, imageID, tileID, left, top, right, bottom) end
+
+
 ---This draws an arc from `x1`,`y1` to `x2`,`y2` with the designated pen.
 ---
 ---`left`, `top`, `right`, `bottom` — describes the rectangle into which the arc must fit.
@@ -274,7 +295,8 @@ function WindowCircleOp(windowName, action, left, top, right, bottom, penColour,
 ---`miniwin.create_absolute_location` (2): Absolute location. If set, the miniwindow is not subject to auto positioning (so the *position* argument is ignored), and it is located exactly at the *left*, *top* position designated in the function call. By setting this bit you have absolute control over where the window will appear.\
 ---`miniwin.create_transparent` (4): Transparent. If set, whenever a pixel in the contents of the window matches the *backgroundColour*, it is not drawn, and the text underneath shows through. This lets you make odd-shape windows like stars or circles, by filling the outside (the part you don't want to see) with the background colour.\
 ---`miniwin.create_ignore_mouse` (8): Ignore mouse. If set, this miniwindow is not considered for mouse-over, mouse-down, mouse-up events. WARNING: If you set the "ignore mouse" flag then you cannot use hotspots, as mouse clicks and movement will not be detected.\
----`miniwin.create_keep_hotspots` (16): Keep existing hotspots. If set, hotspots are not deleted if you are recreating an existing miniwindow.
+---`miniwin.create_keep_hotspots` (16): Keep existing hotspots. If set, hotspots are not deleted if you are recreating an existing miniwindow.\
+---`miniwin.create_retained` (256): Retained drawing. If set, each batch of drawing operations is treated as a complete redraw of the window. When the script returns control to the client, the batch is compared with the previous one and only the areas that changed are redrawn. Operations that modify existing pixels, such as [`WindowFilter`](lua://WindowFilter) and [`WindowBlendImage`](lua://WindowBlendImage), cause the next batch to redraw the whole window.
 ---@param backgroundColour integer|string Integer BBGGRR colour code, string hex code, or string colour name for the colour that the window is initially filled with, and used when doing transparent drawing.
 ---@return error_code code #
 ---`error_code.eNoNameSpecified`: Miniwindow name must be specified.\
@@ -317,6 +339,34 @@ function WindowCreateImage(windowName, imageID, row8, row7, row6, row5, row4, ro
 function WindowDelete(windowName) end
 
 
+---Draws many primitives into a miniwindow in a single call. The commands are decoded up front and drawn with one painter, and the window is repainted once at the end, which is much faster than calling the individual functions for large numbers of small shapes, such as a mapper grid.
+---
+---Each command is an array whose first element names a drawing function without its `Window` prefix, followed by that function's arguments after *windowName*. The supported commands are:\
+---`{ "RectOp", action, left, top, right, bottom, colour1, colour2 }` - see [`WindowRectOp`](lua://WindowRectOp).\
+---`{ "CircleOp", action, left, top, right, bottom, penColour, penStyle, penWidth, brushColour, brushStyle, extra1, extra2 }` - see [`WindowCircleOp`](lua://WindowCircleOp).\
+---`{ "Line", x1, y1, x2, y2, penColour, penStyle, penWidth }` - see [`WindowLine`](lua://WindowLine).\
+---`{ "Gradient", left, top, right, bottom, startColour, endColour, mode }` - see [`WindowGradient`](lua://WindowGradient).\
+---`{ "DrawImage", imageID, left, top, right, bottom, mode, srcLeft, srcTop, srcRight, srcBottom }` - see [`WindowDrawImage`](lua://WindowDrawImage).\
+---`{ "Text", fontID, text, left, top, right, bottom, colour, unicode }` - see [`WindowText`](lua://WindowText).
+---
+---If a command has invalid arguments, nothing is drawn. If an argument has the wrong type, an error is raised that names the command and the argument, counting the command name as argument 1. If a command refers to an image or font that is not loaded, it is skipped and the rest are still drawn, and the first such failure is returned.
+---@param windowName string The name of an existing miniwindow.
+---@param commands any[][] The commands to draw, in order.
+---@return error_code code #
+---`error_code.eNoSuchWindow`: No such miniwindow.\
+---`error_code.eUnknownOption`: Unknown command name or action.\
+---`error_code.ePenStyleNotValid`: Invalid pen style.\
+---`error_code.eBrushStyleNotValid`: Invalid brush style.\
+---`error_code.eImageNotInstalled`: An image was not loaded.\
+---`error_code.eBadParameter`: A parameter was invalid, or a font was not loaded.\
+---`error_code.eOK`: Completed OK.
+---
+---@see WindowCircleOp
+---@see WindowRectOp
+---@see WindowText
+function WindowDrawBatch(windowName, commands) end
+
+
 ---This copies an image to the miniwindow. This function uses the entire image as its source rectangle.
 ---
 ---`left`, `top`, `right`, `bottom` — describes the rectangle to be drawn into.
@@ -403,6 +453,25 @@ function WindowDrawImageAlpha(windowName, imageID, left, top, right, bottom, opa
 function WindowDrawImageAlpha(windowName, imageID, left, top, right, bottom, opacity, srcLeft, srcTop) end
 
 
+---Draws many tiles from one image in a single pass, which is much faster than calling [`WindowDrawImage`](lua://WindowDrawImage) once per tile for things like map grids and inventory icons.
+---
+---Each tile is an array of `{ tileID, left, top }`, where *tileID* names a tile defined with [`WindowAddTile`](lua://WindowAddTile), and *left*, *top* is where its top-left corner is drawn. Tiles are drawn at their original size, in order, using the alpha channel of the image.
+---
+---If any tile is not defined, nothing is drawn.
+---@param windowName string The name of an existing miniwindow.
+---@param imageID string ID of an image loaded into the miniwindow with [`WindowLoadImage`](lua://WindowLoadImage), [`WindowLoadImageMemory`](lua://WindowLoadImageMemory), or [`WindowImageFromWindow`](lua://WindowImageFromWindow).
+---@param tiles [string, number, number][] The tiles to draw.
+---@param opacity? number Between 0 and 1. Defaults to 1.
+---@return error_code code #
+---`error_code.eNoSuchWindow`: No such miniwindow.\
+---`error_code.eImageNotInstalled`: That image was not loaded.\
+---`error_code.eBadParameter`: A tile was not defined, or opacity not in range 0 to 1.\
+---`error_code.eOK`: Completed OK.
+---
+---@see WindowAddTile
+function WindowDrawTiles(windowName, imageID, tiles, opacity) end
+
+
 ---This takes a copy of the specified rectangle in a miniwindow, filters it according to the operation specified with an *integer* option parameter, and replaces the filtered version back in place.
 ---
 ---`left`, `top`, `right`, `bottom` — describes the rectangle to be filtered.
@@ -675,10 +744,31 @@ function WindowList() end
 ---`error_code.eUnableToLoadImage`: Can't load image - perhaps it is not a recognized format.\
 ---`error_code.eOK`: Completed OK.
 ---
+---@see WindowLoadImageAsync - non-blocking version.
 ---@see WindowLoadImageMemory
 function WindowLoadImage(windowName, imageID, fileName) end
 
 
+---Like [`WindowLoadImage`](lua://WindowLoadImage), but decodes the image in the background instead of blocking until it is ready, then optionally calls a function in the current plugin.
+---
+---Until the image has loaded, *imageID* behaves as if no image is loaded: functions that draw it return `error_code.eImageNotInstalled` and draw nothing. If the same image ID is loaded or unloaded again before the image is ready, the most recent call wins.
+---
+---The callback is called as `callback(windowName, imageID, code)`, where `code` is `error_code.eOK` if the image was loaded, `error_code.eUnableToLoadImage` if it could not be decoded, or `error_code.eImageNotInstalled` if a later call replaced it. It is always called after this function returns, and is not called if the miniwindow or the plugin is removed first.
+---@param windowName string The name of an existing miniwindow.
+---@param imageID string The image ID to be associated with this particular image.
+---@param fileName string The disk file to load the image from.
+---@param callback? string Name of the function to call once the image is loaded.
+---@return error_code code #
+---`error_code.eNoSuchWindow`: No such miniwindow.\
+---`error_code.eNoSuchRoutine`: The callback function does not exist.\
+---`error_code.eFileNotFound`: Specified file was not found.\
+---`error_code.eOK`: Loading started.
+---
+---@see WindowLoadImage - blocking version.
+---@see WindowLoadImageMemoryAsync
+function WindowLoadImageAsync(windowName, imageID, fileName, callback) end
+
+
 ---This loads the specified image into the miniwindow from image data in memory, and remembers it by the nominated *imageID*. The image ID is later used for drawing this image.
 ---@param windowName string The name of an existing miniwindow.
 ---@param imageID string The image ID to be associated with this particular image.
@@ -687,9 +777,26 @@ function WindowLoadImage(windowName, imageID, fileName) end
 ---`error_code.eNoSuchWindow`: No such miniwindow.\
 ---`error_code.eUnableToLoadImage`: Can't load image - perhaps it is not a recognized format.\
 ---`error_code.eOK`: Completed OK.
+---
+---@see WindowLoadImageMemoryAsync - non-blocking version.
 function WindowLoadImageMemory(windowName, imageID, data) end
 
 
+---Like [`WindowLoadImageMemory`](lua://WindowLoadImageMemory), but decodes the image in the background instead of blocking until it is ready, then optionally calls a function in the current plugin. See [`WindowLoadImageAsync`](lua://WindowLoadImageAsync) for how the image ID behaves while loading, and how the callback is called.
+---@param windowName string The name of an existing miniwindow.
+---@param imageID string The image ID to be associated with this particular image.
+---@param data string Image file data, preferably in PNG format.
+---@param swapBlueAndAlpha? boolean Swap the blue and alpha channels after loading.
+---@param callback? string Name of the function to call once the image is loaded.
+---@return error_code code #
+---`error_code.eNoSuchWindow`: No such miniwindow.\
+---`error_code.eNoSuchRoutine`: The callback function does not exist.\
+---`error_code.eOK`: Loading started.
+---
+---@see WindowLoadImageMemory - blocking version.
+function WindowLoadImageMemoryAsync(windowName, imageID, data, swapBlueAndAlpha, callback) end
+
+
 ---This creates a pop-up menu inside a miniwindow. This is intended to let you click on an item (for example, a piece of inventory), and select "take/drop/equip/wield" and so on.
 ---
 ---The *x* and *y* position must be inside the miniwindow (ie. not negative, and not exceeding the miniwindow's defined width and height). Otherwise, an empty string is returned.
@@ -932,7 +1039,8 @@ function WindowPolygon(windowName, points, penColour, penStyle, penWidth, brushC
 ---`miniwin.create_absolute_location` (2): Absolute location. If set, the miniwindow is not subject to auto positioning (so the Position argument is ignored), and it is located exactly at the Left, Top position designated in the function call. By setting this bit you have absolute control over where the window will appear.\
 ---`miniwin.create_transparent` (4): Transparent. If set, whenever a pixel in the contents of the window matches the BackgroundColour, it is not drawn, and the text underneath shows through. This lets you make odd-shape windows like stars or circles, by filling the outside (the part you don't want to see) with the background colour.\
 ---`miniwin.create_ignore_mouse` (8): Ignore mouse. If set, this miniwindow is not considered for mouse-over, mouse-down, mouse-up events.\
----`miniwin.create_keep_hotspots` (16): Keep existing hotspots. If set, hotspots are not deleted if you are recreating an existing miniwindow (with [`WindowCreate`](lua://WindowCreate)).
+---`miniwin.create_keep_hotspots` (16): Keep existing hotspots. If set, hotspots are not deleted if you are recreating an existing miniwindow (with [`WindowCreate`](lua://WindowCreate)).\
+---`miniwin.create_retained` (256): Retained drawing. See [`WindowCreate`](lua://WindowCreate).
 ---@return error_code code #
 ---`error_code.eNoSuchWindow`: No such miniwindow.\
 ---`error_code.eOK`: Success.
@@ -1143,9 +1251,25 @@ function WindowText(windowName, fontID, text, left, top, right, bottom, colour,
 ----3: For Unicode, invalid UTF-8 sequence
 ---
 ---@see WindowText - draw text.
+---@see WindowTextWidths - measure several pieces of text at once.
 function WindowTextWidth(windowName, fontID, text, unicode) end
 
 
+---Like [`WindowTextWidth`](lua://WindowTextWidth), but measures an array of strings in one call, which is faster when laying out many labels at once.
+---@param windowName string The name of an existing miniwindow.
+---@param fontID string ID of a font loaded into the miniwindow with [`WindowFont`](lua://WindowFont).
+---@param texts string[] The pieces of text to measure.
+---@param unicode? boolean If `true`, the text is Unicode text in UTF-8 format. Default: `false`.
+---@return number[]|number widths If successful, the pixel width of each piece of text, in the same order as *texts*.
+---
+---If unsuccessful, returns a negative number as follows:\
+----1: That window name does not exist\
+----2: That font was not loaded
+---
+---@see WindowTextWidth
+function WindowTextWidths(windowName, fontID, texts, unicode) end
+
+
 ---This copies an image to the miniwindow. You specify effectively a "matrix" which is applied to each pixel position, so that the image can be rotated, scaled, reflected, sheared and translated.
 ---
 ---The position of each destination pixel (x' and y') is given by:
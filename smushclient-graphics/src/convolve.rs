@@ -1,7 +1,6 @@
-use std::ops::Range;
-
+use crate::casting::as_bytes_mut;
 use crate::channel::ColorChannel;
-use crate::dimensions::{StepSlice, StepSliceMut, SubpixelImage};
+use crate::parallel::{BAND_PIXELS, for_each_band, threads_for};
 
 #[derive(Copy, Clone, Debug, Default, PartialEq, Eq)]
 pub enum Directions {
@@ -11,50 +10,42 @@ pub enum Directions {
     Vertical,
 }
 
-#[inline(always)]
-const fn is_rgb_column(index: usize) -> bool {
-    index & 3 != ColorChannel::Alpha as usize
-}
-
-pub(crate) fn convolve(
-    column_pred: fn(usize) -> bool,
-    columns: Range<usize>,
+/// Convolves an ARGB32 image with a one-dimensional kernel in one or both directions.
+///
+/// Both passes operate on whole rows of interleaved subpixels: the vertical pass combines
+/// neighbouring rows, and the horizontal pass combines shifted views of a row that has been
+/// padded with copies of its edge pixels. The inner loops are contiguous and branch-free, so they
+/// vectorize, while each subpixel still goes through the same sequence of floating-point
+/// operations as a per-subpixel loop would, which keeps results identical across platforms.
+///
+/// Tap `i` of the kernel is applied to the sample at offset `i - (1 + kernel.len() / 2)`, with
+/// samples past the edges of the image clamped to the nearest edge.
+fn convolve(
     data: &mut [u32],
     width: usize,
     directions: Directions,
     kernel: &[f64],
+    alpha: bool,
+    threads: usize,
 ) {
     debug_assert!(kernel.len() % 2 == 1, "kernel length is even");
-
-    let mut input_buf = Vec::new();
-    let mut output = SubpixelImage::from_argb(data, width);
-    let mut input = output.encode_f64(&mut input_buf);
-    if directions != Directions::Horizontal {
-        for col in 0..output.width() {
-            if column_pred(col) {
-                convolve_line(&input.column(col), &mut output.column_mut(col), kernel);
-            }
-        }
+    if data.is_empty() || width == 0 {
+        return;
     }
-    if directions == Directions::Both {
-        input = output.encode_f64(&mut input_buf);
+    debug_assert_eq!(data.len() % width, 0, "invalid width");
+    let stride = width * 4;
+    let subpixels = as_bytes_mut(data);
+    if directions != Directions::Horizontal {
+        convolve_vertical(subpixels, stride, kernel, alpha, threads);
     }
     if directions != Directions::Vertical {
-        for row in 0..output.height() {
-            for ch in columns.start..columns.end {
-                convolve_line(&input.row(row, ch), &mut output.row_mut(row, ch), kernel);
-            }
-        }
+        convolve_horizontal(subpixels, stride, kernel, alpha, threads);
     }
 }
 
 pub(crate) fn convolve_rgb(data: &mut [u32], width: usize, directions: Directions, kernel: &[f64]) {
-    #[cfg(target_endian = "little")]
-    const RGB_CHANNELS: Range<usize> = 0..3;
-    #[cfg(target_endian = "big")]
-    const RGB_CHANNELS: Range<usize> = 1..4;
-
-    convolve(is_rgb_column, RGB_CHANNELS, data, width, directions, kernel);
+    let threads = threads_for(data.len());
+    convolve(data, width, directions, kernel, false, threads);
 }
 
 pub(crate) fn convolve_rgba(
@@ -63,53 +54,221 @@ pub(crate) fn convolve_rgba(
     directions: Directions,
     kernel: &[f64],
 ) {
-    convolve(|_| true, 0..4, data, width, directions, kernel);
+    let threads = threads_for(data.len());
+    convolve(data, width, directions, kernel, true, threads);
 }
 
-trait FloatConvert: Copy {
-    fn to_f64(self) -> f64;
-    fn from_f64(f: f64) -> Self;
+#[inline(always)]
+const fn kernel_origin(kernel: &[f64]) -> usize {
+    1 + kernel.len() / 2
 }
 
-impl FloatConvert for f64 {
-    #[inline(always)]
-    fn to_f64(self) -> f64 {
-        self
-    }
-    #[inline(always)]
-    fn from_f64(f: f64) -> Self {
-        f
+#[inline(always)]
+fn rows_per_band(stride: usize) -> usize {
+    (BAND_PIXELS * 4 / stride).max(1)
+}
+
+fn convolve_vertical(
+    subpixels: &mut [u8],
+    stride: usize,
+    kernel: &[f64],
+    alpha: bool,
+    threads: usize,
+) {
+    let source = subpixels.to_vec();
+    let last_row = subpixels.len() / stride - 1;
+    let origin = kernel_origin(kernel);
+    let band_rows = rows_per_band(stride);
+    for_each_band(subpixels, band_rows * stride, threads, |band, outputs| {
+        let mut totals = vec![0.0; stride];
+        let first_row = band * band_rows;
+        for (y, output) in outputs.chunks_exact_mut(stride).enumerate() {
+            totals.fill(0.0);
+            for (i, &weight) in kernel.iter().enumerate() {
+                let row = (first_row + y + i).saturating_sub(origin).min(last_row);
+                accumulate(
+                    &mut totals,
+                    &source[row * stride..(row + 1) * stride],
+                    weight,
+                );
+            }
+            store(output, &totals, alpha);
+        }
+    });
+}
+
+fn convolve_horizontal(
+    subpixels: &mut [u8],
+    stride: usize,
+    kernel: &[f64],
+    alpha: bool,
+    threads: usize,
+) {
+    let origin = kernel_origin(kernel);
+    let trailing = kernel.len().saturating_sub(origin);
+    let band_rows = rows_per_band(stride);
+    for_each_band(subpixels, band_rows * stride, threads, |_, outputs| {
+        let mut totals = vec![0.0; stride];
+        let mut padded = Vec::with_capacity(stride + kernel.len() * 4);
+        for output in outputs.chunks_exact_mut(stride) {
+            padded.clear();
+            let first = &output[..4];
+            let last = &output[stride - 4..];
+            for _ in 0..origin {
+                padded.extend_from_slice(first);
+            }
+            padded.extend_from_slice(output);
+            for _ in 0..trailing {
+                padded.extend_from_slice(last);
+            }
+            totals.fill(0.0);
+            for (i, &weight) in kernel.iter().enumerate() {
+                accumulate(&mut totals, &padded[i * 4..i * 4 + stride], weight);
+            }
+            store(output, &totals, alpha);
+        }
+    });
+}
+
+#[inline(always)]
+fn accumulate(totals: &mut [f64], input: &[u8], weight: f64) {
+    for (total, &subpixel) in totals.iter_mut().zip(input) {
+        *total += weight * f64::from(subpixel);
     }
 }
 
-impl FloatConvert for u8 {
-    #[inline(always)]
-    fn to_f64(self) -> f64 {
-        f64::from(self)
+#[inline(always)]
+#[allow(clippy::cast_possible_truncation, clippy::cast_sign_loss)]
+fn store(output: &mut [u8], totals: &[f64], alpha: bool) {
+    if alpha {
+        for (subpixel, &total) in output.iter_mut().zip(totals) {
+            *subpixel = total as u8;
+        }
+        return;
     }
-    #[inline(always)]
-    #[allow(clippy::cast_possible_truncation, clippy::cast_sign_loss)]
-    fn from_f64(f: f64) -> Self {
-        f as u8
+    for (pixel, totals) in output.chunks_exact_mut(4).zip(totals.chunks_exact(4)) {
+        for channel in 0..4 {
+            if channel != ColorChannel::Alpha as usize {
+                pixel[channel] = totals[channel] as u8;
+            }
+        }
     }
 }
 
-#[inline]
-fn convolve_line<I, O>(input: &StepSlice<I>, output: &mut StepSliceMut<O>, kernel: &[f64])
-where
-    I: FloatConvert,
-    O: FloatConvert,
-{
-    let midpoint = 1 + kernel.len() / 2;
-    for (position, subpixel) in output.into_iter().enumerate() {
-        let total = kernel
-            .iter()
-            .enumerate()
-            .map(|(i, weight)| {
-                let index = (position + i).saturating_sub(midpoint);
-                weight * input.get_clamped(index).to_f64()
-            })
-            .sum();
-        *subpixel = FloatConvert::from_f64(total);
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use smushclient_plugins::testing::time;
+
+    /// Straightforward per-subpixel convolution that the optimized passes must match exactly.
+    fn reference(
+        data: &mut [u32],
+        width: usize,
+        directions: Directions,
+        kernel: &[f64],
+        alpha: bool,
+    ) {
+        #[allow(clippy::cast_possible_truncation, clippy::cast_sign_loss)]
+        fn pass(bytes: &mut [u8], len: usize, index: impl Fn(usize) -> usize, kernel: &[f64]) {
+            let input: Vec<f64> = (0..len).map(|p| f64::from(bytes[index(p)])).collect();
+            let origin = kernel_origin(kernel);
+            for p in 0..len {
+                let total: f64 = kernel
+                    .iter()
+                    .enumerate()
+                    .map(|(i, weight)| weight * input[(p + i).saturating_sub(origin).min(len - 1)])
+                    .sum();
+                bytes[index(p)] = total as u8;
+            }
+        }
+
+        let stride = width * 4;
+        let height = data.len() / width;
+        let bytes = as_bytes_mut(data);
+        let channels = (0..4).filter(|&ch| alpha || ch != ColorChannel::Alpha as usize);
+        if directions != Directions::Horizontal {
+            for col in 0..stride {
+                if alpha || col & 3 != ColorChannel::Alpha as usize {
+                    pass(bytes, height, |y| y * stride + col, kernel);
+                }
+            }
+        }
+        if directions != Directions::Vertical {
+            for row in 0..height {
+                for ch in channels.clone() {
+                    pass(bytes, width, |x| row * stride + x * 4 + ch, kernel);
+                }
+            }
+        }
+    }
+
+    const KERNELS: &[(&[f64], bool)] = &[
+        (&[0.2, 0.2, 0.2, 0.2, 0.2], true),
+        (
+            &[-1.0 / 3.0, -1.0 / 3.0, 7.0 / 3.0, -1.0 / 3.0, -1.0 / 3.0],
+            false,
+        ),
+        (&[0.0, 2.5, -6.0, 2.5, 0.0], false),
+        (&[1.0, 2.0, 1.0, -1.0, -2.0], false),
+        (&[0.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, 0.0], true),
+        (&[0.0, 0.25, 0.5, 0.25, 0.0], true),
+    ];
+
+    #[test]
+    fn matches_reference() {
+        let mut rng = fastrand::Rng::with_seed(0x5eed);
+        for (width, height) in [(1, 1), (1, 7), (7, 1), (2, 3), (13, 11), (64, 9)] {
+            let image: Vec<u32> = (0..width * height).map(|_| rng.u32(..)).collect();
+            for &(kernel, alpha) in KERNELS {
+                for directions in [
+                    Directions::Both,
+                    Directions::Horizontal,
+                    Directions::Vertical,
+                ] {
+                    let mut expected = image.clone();
+                    reference(&mut expected, width, directions, kernel, alpha);
+                    let mut actual = image.clone();
+                    convolve(&mut actual, width, directions, kernel, alpha, 1);
+                    assert_eq!(
+                        actual, expected,
+                        "{width}x{height}, {kernel:?}, {directions:?}"
+                    );
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn output_is_independent_of_thread_count() {
+        let mut rng = fastrand::Rng::with_seed(0x5eed);
+        // Narrow enough that the image spans several bands.
+        let (width, height) = (BAND_PIXELS / 8, 37);
+        let image: Vec<u32> = (0..width * height).map(|_| rng.u32(..)).collect();
+        for &(kernel, alpha) in KERNELS {
+            let mut expected = image.clone();
+            convolve(&mut expected, width, Directions::Both, kernel, alpha, 1);
+            for threads in [2, 3, 16] {
+                let mut actual = image.clone();
+                convolve(&mut actual, width, Directions::Both, kernel, alpha, threads);
+                assert!(actual == expected, "{kernel:?}, {threads} threads");
+            }
+        }
+    }
+
+    #[test]
+    #[ignore = "benchmark"]
+    fn time_against_reference() {
+        let mut rng = fastrand::Rng::with_seed(0x5eed);
+        let (width, height) = (1024, 768);
+        let image: Vec<u32> = (0..width * height).map(|_| rng.u32(..)).collect();
+        for (i, &(kernel, alpha)) in KERNELS.iter().enumerate() {
+            let mut data = image.clone();
+            time(&format!("reference, kernel {i}"), 5, || {
+                reference(&mut data, width, Directions::Both, kernel, alpha);
+            });
+            time(&format!("convolve, kernel {i}"), 5, || {
+                convolve(&mut data, width, Directions::Both, kernel, alpha, 1);
+            });
+        }
     }
 }
@@ -3,7 +3,7 @@
     clippy::cast_lossless,
     clippy::cast_sign_loss
 )]
-use std::mem;
+use std::{array, mem};
 
 use crate::casting::{as_bytes_mut, as_pixels, as_pixels_mut};
 use crate::channel::ColorChannel;
@@ -12,29 +12,39 @@ use crate::iter::{
     adjust_pixels, adjust_pixels_with_state, adjust_subpixels, adjust_subpixels_cached,
     adjust_subpixels_with_state, channel_subpixels_mut,
 };
+use crate::parallel::{BAND_PIXELS, band_seeds, for_each_band, threads_for};
 use crate::pixel::Pixel;
 use crate::random::{DissolveRng, NoiseRng};
 
-#[inline(always)]
-const fn is_multiple_of_4(i: usize) -> bool {
-    i.trailing_zeros() >= 2
+pub fn noise(data: &mut [u32], threshold: f64) {
+    noise_seeded(data, threshold, fastrand::u64(..), threads_for(data.len()));
 }
 
-pub fn noise(data: &mut [u32], threshold: f64) {
-    let mut rng = NoiseRng::new(threshold);
-    adjust_subpixels_with_state(data, None, |sp| (sp as f64 + rng.next()) as u8);
+fn noise_seeded(data: &mut [u32], threshold: f64, seed: u64, threads: usize) {
+    let seeds = band_seeds(seed, data.len(), BAND_PIXELS);
+    for_each_band(data, BAND_PIXELS, threads, |i, band| {
+        let mut rng = NoiseRng::with_seed(threshold, seeds[i]);
+        adjust_subpixels_with_state(band, None, |sp| (sp as f64 + rng.next()) as u8);
+    });
 }
 
 pub fn mono_noise(data: &mut [u32], threshold: f64) {
-    let mut rng = NoiseRng::new(threshold);
-    adjust_pixels_with_state(data, |p| {
-        let noise = rng.next();
-        Pixel {
-            blue: (p.blue as f64 + noise) as u8,
-            green: (p.green as f64 + noise) as u8,
-            red: (p.red as f64 + noise) as u8,
-            alpha: p.alpha,
-        }
+    mono_noise_seeded(data, threshold, fastrand::u64(..), threads_for(data.len()));
+}
+
+fn mono_noise_seeded(data: &mut [u32], threshold: f64, seed: u64, threads: usize) {
+    let seeds = band_seeds(seed, data.len(), BAND_PIXELS);
+    for_each_band(data, BAND_PIXELS, threads, |i, band| {
+        let mut rng = NoiseRng::with_seed(threshold, seeds[i]);
+        adjust_pixels_with_state(band, |p| {
+            let noise = rng.next();
+            Pixel {
+                blue: (p.blue as f64 + noise) as u8,
+                green: (p.green as f64 + noise) as u8,
+                red: (p.red as f64 + noise) as u8,
+                alpha: p.alpha,
+            }
+        });
     });
 }
 
@@ -133,39 +143,217 @@ pub fn average(data: &mut [u32]) {
 }
 
 pub fn color_to_alpha(data: &mut [u32], color: Pixel) {
-    for pixel in as_pixels_mut(data).iter_mut() {
-        if *pixel == color {
-            *pixel = Pixel::transparent();
+    let threads = threads_for(data.len());
+    for_each_band(data, BAND_PIXELS, threads, |_, band| {
+        for pixel in as_pixels_mut(band).iter_mut() {
+            if *pixel == color {
+                *pixel = Pixel::transparent();
+            }
         }
-    }
+    });
 }
 
 pub fn dissolve(data: &mut [u32], opacity: f64) {
-    let mut rng = DissolveRng::new(opacity);
-    for subpixel in channel_subpixels_mut(data, ColorChannel::Alpha) {
-        if rng.erase() {
-            *subpixel = 0;
+    dissolve_seeded(data, opacity, fastrand::u64(..), threads_for(data.len()));
+}
+
+fn dissolve_seeded(data: &mut [u32], opacity: f64, seed: u64, threads: usize) {
+    let seeds = band_seeds(seed, data.len(), BAND_PIXELS);
+    for_each_band(data, BAND_PIXELS, threads, |i, band| {
+        let mut rng = DissolveRng::with_seed(opacity, seeds[i]);
+        for subpixel in channel_subpixels_mut(band, ColorChannel::Alpha) {
+            if rng.erase() {
+                *subpixel = 0;
+            }
         }
-    }
+    });
+}
+
+/// Like [`dissolve`], but for premultiplied data, where erasing a pixel must clear its color
+/// channels along with its alpha. Erases the same pixels as [`dissolve`] would for the same seed.
+pub fn dissolve_premultiplied(data: &mut [u32], opacity: f64) {
+    dissolve_premultiplied_seeded(data, opacity, fastrand::u64(..), threads_for(data.len()));
+}
+
+fn dissolve_premultiplied_seeded(data: &mut [u32], opacity: f64, seed: u64, threads: usize) {
+    let seeds = band_seeds(seed, data.len(), BAND_PIXELS);
+    for_each_band(data, BAND_PIXELS, threads, |i, band| {
+        let mut rng = DissolveRng::with_seed(opacity, seeds[i]);
+        for pixel in band.iter_mut() {
+            if rng.erase() {
+                *pixel = 0;
+            }
+        }
+    });
+}
+
+/// Returns true if every pixel has full alpha, in which case premultiplied and straight ARGB32
+/// representations of the data are identical.
+pub fn is_opaque(data: &[u32]) -> bool {
+    // Folding each band without an early exit lets the inner loop vectorize.
+    data.chunks(BAND_PIXELS).all(|band| {
+        as_pixels(band)
+            .iter()
+            .fold(u8::MAX, |alpha, pixel| alpha & pixel.alpha)
+            == u8::MAX
+    })
 }
 
-pub fn mask_premultiplied(data: &mut [u32], mask: &[u8], opacity: f64) -> bool {
-    if data.len() != mask.len() * 4 {
+/// Scales each pixel of premultiplied ARGB32 data by the corresponding byte of an 8-bit grayscale
+/// mask, where 255 keeps the pixel and 0 erases it, and by `opacity`.
+///
+/// `width` is the number of pixels in each row of the data. Rows of the mask may be padded, so
+/// each is `mask_stride` bytes long. Returns false if the mask has fewer rows than the data.
+pub fn mask_premultiplied(
+    data: &mut [u32],
+    width: usize,
+    mask: &[u8],
+    mask_stride: usize,
+    opacity: f64,
+) -> bool {
+    if data.is_empty() {
+        return true;
+    }
+    if width == 0 || mask_stride < width || !data.len().is_multiple_of(width) {
         return false;
     }
-    let mut mask_iter = mask.iter();
-    let mut mask = 0.0;
-    for (i, c) in as_bytes_mut(data).iter_mut().enumerate() {
-        if is_multiple_of_4(i) {
-            mask = f64::from(*mask_iter.next().unwrap()) * opacity;
-        }
-        *c = (f64::from(*c) * mask) as u8;
+    let rows = data.len() / width;
+    if mask.len() < (rows - 1) * mask_stride + width {
+        return false;
     }
+    let factors: [f64; 256] = array::from_fn(|i| f64::from(i as u8) * opacity / 255.0);
+    let threads = threads_for(data.len());
+    let band_rows = BAND_PIXELS.div_ceil(width);
+    for_each_band(data, band_rows * width, threads, |i, band| {
+        for (row, pixels) in band.chunks_exact_mut(width).enumerate() {
+            let start = (i * band_rows + row) * mask_stride;
+            let mask = &mask[start..start + width];
+            for (pixel, &mask) in as_bytes_mut(pixels).chunks_exact_mut(4).zip(mask) {
+                let factor = factors[usize::from(mask)];
+                for c in pixel {
+                    *c = (f64::from(*c) * factor) as u8;
+                }
+            }
+        }
+    });
     true
 }
 
 pub fn swap_blue_and_alpha(data: &mut [u32]) {
-    for pixel in as_pixels_mut(data).iter_mut() {
+    adjust_pixels(data, |mut pixel| {
         mem::swap(&mut pixel.blue, &mut pixel.alpha);
+        pixel
+    });
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use smushclient_plugins::testing::time;
+
+    fn image(len: usize) -> Vec<u32> {
+        let mut rng = fastrand::Rng::with_seed(0x5eed);
+        (0..len).map(|_| rng.u32(..)).collect()
+    }
+
+    #[test]
+    fn random_filters_are_independent_of_thread_count() {
+        let source = image(BAND_PIXELS * 3 + 17);
+        let filters: [fn(&mut [u32], u64, usize); 3] = [
+            |data, seed, threads| noise_seeded(data, 50.0, seed, threads),
+            |data, seed, threads| mono_noise_seeded(data, 50.0, seed, threads),
+            |data, seed, threads| dissolve_seeded(data, 0.5, seed, threads),
+        ];
+        for filter in filters {
+            let mut expected = source.clone();
+            filter(&mut expected, 1234, 1);
+            assert!(expected != source);
+            for threads in [2, 4, 16] {
+                let mut actual = source.clone();
+                filter(&mut actual, 1234, threads);
+                assert!(actual == expected, "{threads} threads");
+            }
+        }
+    }
+
+    #[test]
+    fn dissolve_premultiplied_erases_same_pixels() {
+        // Opaque, so that a pixel is erased exactly when the straight filter changes it.
+        let source: Vec<u32> = image(BAND_PIXELS * 2 + 5)
+            .into_iter()
+            .map(|pixel| pixel | 0xFF00_0000)
+            .collect();
+        let mut straight = source.clone();
+        dissolve_seeded(&mut straight, 0.5, 1234, 1);
+        let mut premultiplied = source.clone();
+        dissolve_premultiplied_seeded(&mut premultiplied, 0.5, 1234, 3);
+        for ((&straight, &premultiplied), &source) in
+            straight.iter().zip(&premultiplied).zip(&source)
+        {
+            if straight == source {
+                assert_eq!(premultiplied, source);
+            } else {
+                assert_eq!(premultiplied, 0);
+            }
+        }
+    }
+
+    #[test]
+    fn opacity_checks_every_band() {
+        let mut data = vec![0xFF10_2030; BAND_PIXELS * 2 + 1];
+        assert!(is_opaque(&data));
+        assert!(is_opaque(&[]));
+        data[BAND_PIXELS + 7] = 0xFE10_2030;
+        assert!(!is_opaque(&data));
+    }
+
+    #[test]
+    fn mask_scales_each_pixel() {
+        let width = 1000;
+        let mut data = vec![0x8040_2010; width * (BAND_PIXELS / width + 2)];
+        // Rows padded to 4 bytes, like a QImage.
+        let stride = width + 3;
+        let mut mask = vec![0xEE; stride * (data.len() / width)];
+        for row in mask.chunks_mut(stride) {
+            row[..width].fill(255);
+        }
+        let last_row = data.len() - width;
+        mask[stride * (last_row / width) + 1] = 128;
+        mask[stride * (last_row / width) + 2] = 0;
+        assert!(mask_premultiplied(&mut data, width, &mask, stride, 1.0));
+        assert_eq!(data[0], 0x8040_2010);
+        assert_eq!(data[last_row], 0x8040_2010);
+        assert_eq!(data[last_row + 1], 0x4020_1008);
+        assert_eq!(data[last_row + 2], 0);
+        assert!(mask_premultiplied(&mut data, width, &mask, stride, 0.5));
+        assert_eq!(data[0], 0x4020_1008);
+        assert_eq!(data[last_row + 1], 0x1008_0402);
+    }
+
+    #[test]
+    fn mask_must_cover_every_row() {
+        let mut data = vec![0x8040_2010; 12];
+        // The last row does not need to be padded.
+        let mask = vec![255; 4 * 3 + 3];
+        assert!(mask_premultiplied(&mut data, 3, &mask, 4, 1.0));
+        assert!(!mask_premultiplied(&mut data, 3, &mask[1..], 4, 1.0));
+        assert!(!mask_premultiplied(&mut data, 5, &mask, 5, 1.0));
+        assert!(!mask_premultiplied(&mut data, 3, &mask, 2, 1.0));
+        assert!(mask_premultiplied(&mut [], 0, &[], 0, 1.0));
+    }
+
+    #[test]
+    #[ignore = "benchmark"]
+    fn time_thread_scaling() {
+        let source = image(2048 * 2048);
+        for threads in [1, 2, 4, 8] {
+            let mut data = source.clone();
+            time(&format!("noise, {threads} threads"), 5, || {
+                noise_seeded(&mut data, 50.0, 1234, threads);
+            });
+            time(&format!("dissolve, {threads} threads"), 5, || {
+                dissolve_seeded(&mut data, 0.5, 1234, threads);
+            });
+        }
     }
 }
@@ -5,6 +5,7 @@ use bytetable::ByteTable;
 
 use crate::casting::{as_bytes_mut, as_pixels_mut};
 use crate::channel::ColorChannel;
+use crate::parallel::{BAND_PIXELS, for_each_band, threads_for};
 use crate::pixel::Pixel;
 
 #[inline(always)]
@@ -22,9 +23,12 @@ pub(crate) fn channel_subpixels_mut(
 
 pub(crate) fn adjust_subpixels<F>(data: &mut [u32], channel: Option<ColorChannel>, f: F)
 where
-    F: Fn(u8) -> u8,
+    F: Fn(u8) -> u8 + Sync,
 {
-    adjust_subpixels_with_state(data, channel, f);
+    let threads = threads_for(data.len());
+    for_each_band(data, BAND_PIXELS, threads, |_, band| {
+        adjust_subpixels_with_state(band, channel, &f);
+    });
 }
 
 pub(crate) fn adjust_subpixels_with_state<F>(
@@ -52,7 +56,7 @@ pub(crate) fn adjust_subpixels_with_state<F>(
 
 pub(crate) fn adjust_subpixels_cached<F>(data: &mut [u32], channel: Option<ColorChannel>, f: F)
 where
-    F: Fn(u8) -> u8,
+    F: Fn(u8) -> u8 + Sync,
 {
     let cache = ByteTable::generate(f);
     adjust_subpixels(data, channel, |sp| cache[sp]);
@@ -60,9 +64,12 @@ where
 
 pub(crate) fn adjust_pixels<F>(data: &mut [u32], f: F)
 where
-    F: Fn(Pixel) -> Pixel,
+    F: Fn(Pixel) -> Pixel + Sync,
 {
-    adjust_pixels_with_state(data, f);
+    let threads = threads_for(data.len());
+    for_each_band(data, BAND_PIXELS, threads, |_, band| {
+        adjust_pixels_with_state(band, &f);
+    });
 }
 
 pub(crate) fn adjust_pixels_with_state<F>(data: &mut [u32], mut f: F)
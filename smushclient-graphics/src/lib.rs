@@ -6,12 +6,12 @@ pub use channel::ColorChannel;
 mod convolve;
 pub use convolve::Directions;
 
-mod dimensions;
-
 pub mod filter;
 
 mod iter;
 
+mod parallel;
+
 mod pixel;
 pub use pixel::Pixel;
 
@@ -0,0 +1,88 @@
+use std::num::NonZero;
+use std::sync::Mutex;
+use std::thread;
+
+/// Images with fewer pixels than this are filtered on the calling thread. Below roughly 512x512,
+/// spawning workers costs more than it saves.
+const PARALLEL_THRESHOLD: usize = 512 * 512;
+
+/// Number of pixels in each band of work. Bands have a fixed size, independent of the number of
+/// threads, so that anything derived from band indices (such as random number streams) produces
+/// the same output no matter how many threads are used.
+pub(crate) const BAND_PIXELS: usize = 64 * 1024;
+
+/// Upper bound on worker threads, no matter how many CPUs are available.
+const MAX_THREADS: usize = 16;
+
+/// Returns the number of threads to use for filtering an image with the given number of pixels.
+pub(crate) fn threads_for(pixels: usize) -> usize {
+    if pixels < PARALLEL_THRESHOLD {
+        1
+    } else {
+        thread::available_parallelism()
+            .map_or(1, NonZero::get)
+            .min(MAX_THREADS)
+    }
+}
+
+/// Calls `f` on consecutive bands of `band_len` elements from `data`, along with each band's
+/// index, spreading the bands across up to `threads` threads.
+///
+/// Workers take the next unprocessed band whenever they finish one, so a band that takes longer
+/// than the others does not hold up the rest.
+pub(crate) fn for_each_band<T, F>(data: &mut [T], band_len: usize, threads: usize, f: F)
+where
+    T: Send,
+    F: Fn(usize, &mut [T]) + Sync,
+{
+    let band_len = band_len.max(1);
+    let threads = threads.min(data.len().div_ceil(band_len));
+    if threads <= 1 {
+        data.chunks_mut(band_len)
+            .enumerate()
+            .for_each(|(i, band)| f(i, band));
+        return;
+    }
+    let bands = Mutex::new(data.chunks_mut(band_len).enumerate());
+    let next_band = || bands.lock().unwrap_or_else(|e| e.into_inner()).next();
+    thread::scope(|scope| {
+        for _ in 1..threads {
+            scope.spawn(|| {
+                while let Some((i, band)) = next_band() {
+                    f(i, band);
+                }
+            });
+        }
+        while let Some((i, band)) = next_band() {
+            f(i, band);
+        }
+    });
+}
+
+/// Generates one seed per band from a single source, so that each band gets its own random
+/// number stream regardless of which thread processes it.
+pub(crate) fn band_seeds(seed: u64, len: usize, band_len: usize) -> Vec<u64> {
+    let mut rng = fastrand::Rng::with_seed(seed);
+    (0..len.div_ceil(band_len.max(1)))
+        .map(|_| rng.u64(..))
+        .collect()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn visits_every_band_once() {
+        for threads in [1, 2, 3, 8] {
+            let mut data = vec![0usize; 1000];
+            for_each_band(&mut data, 64, threads, |i, band| {
+                for value in band {
+                    *value += i + 1;
+                }
+            });
+            let expected: Vec<usize> = (0..1000).map(|n| n / 64 + 1).collect();
+            assert_eq!(data, expected, "threads: {threads}");
+        }
+    }
+}
@@ -4,9 +4,9 @@ pub(crate) struct DissolveRng {
 }
 
 impl DissolveRng {
-    pub fn new(opacity: f64) -> Self {
+    pub fn with_seed(opacity: f64, seed: u64) -> Self {
         Self {
-            inner: fastrand::Rng::new(),
+            inner: fastrand::Rng::with_seed(seed),
             opacity,
         }
     }
@@ -25,10 +25,10 @@ pub(crate) struct NoiseRng {
 }
 
 impl NoiseRng {
-    pub fn new(threshold: f64) -> Self {
+    pub fn with_seed(threshold: f64, seed: u64) -> Self {
         let threshold = threshold / 100.0;
         Self {
-            inner: fastrand::Rng::new(),
+            inner: fastrand::Rng::with_seed(seed),
             offset: 128.0 * threshold,
             scale: 256.0 * threshold,
         }
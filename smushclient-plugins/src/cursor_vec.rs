@@ -1,9 +1,18 @@
 use std::cell::{Cell, Ref, RefCell, RefMut};
 use std::cmp::Ordering;
+use std::collections::HashMap;
 use std::iter::FusedIterator;
+use std::ops::Deref;
+#[cfg(not(feature = "send"))]
+use std::rc::Rc;
+#[cfg(feature = "send")]
+use std::sync::Arc as Rc;
 
 use serde::{Deserialize, Deserializer, Serialize, Serializer};
 
+use crate::regex::{Regex, literal_prefix};
+use crate::send::{Reaction, Sender};
+
 #[derive(Clone, Debug, PartialEq, Eq, PartialOrd, Ord)]
 pub struct CursorVec<T> {
     inner: RefCell<Vec<T>>,
@@ -11,6 +20,7 @@ pub struct CursorVec<T> {
     unsorted: Cell<bool>,
     evaluating: Cell<bool>,
     scan_id: Cell<u8>,
+    cache: Cache,
 }
 
 impl<T> CursorVec<T> {
@@ -21,8 +31,16 @@ impl<T> CursorVec<T> {
             unsorted: Cell::new(false),
             evaluating: Cell::new(false),
             scan_id: Cell::new(0),
+            cache: Cache::new(),
         }
     }
+
+    /// Discards everything derived from the items, after items may have moved or changed.
+    fn invalidate(&self) {
+        self.cache.index.take();
+        self.cache.matchers.take();
+        self.cache.generation.update(|n| n.wrapping_add(1));
+    }
 }
 
 impl<T: Ord> CursorVec<T> {
@@ -39,6 +57,7 @@ impl<T: Ord> CursorVec<T> {
     }
 
     pub fn borrow_mut(&self) -> RefMut<'_, Vec<T>> {
+        self.invalidate();
         self.inner.borrow_mut()
     }
 
@@ -54,6 +73,7 @@ impl<T: Ord> CursorVec<T> {
         if self.evaluating.get() {
             self.unsorted.set(true);
         } else {
+            self.invalidate();
             self.inner.borrow_mut().sort_unstable();
         }
     }
@@ -81,11 +101,13 @@ impl<T: Ord> CursorVec<T> {
         }
         self.scan_id.update(|n| n.wrapping_add(1));
         if self.unsorted.replace(false) {
+            self.invalidate();
             self.inner.borrow_mut().sort_unstable();
         }
     }
 
     pub fn insert(&self, item: T) -> Ref<'_, T> {
+        self.invalidate();
         let pos = {
             let mut inner = self.inner.borrow_mut();
             match inner.binary_search(&item) {
@@ -113,6 +135,7 @@ impl<T: Ord> CursorVec<T> {
     }
 
     fn do_replace(&self, i: usize, item: T) -> usize {
+        self.invalidate();
         let mut inner = self.inner.borrow_mut();
         let mut pos = match inner.binary_search(&item) {
             Ok(pos) | Err(pos) => pos,
@@ -138,6 +161,7 @@ impl<T: Ord> CursorVec<T> {
 
     pub fn remove(&self, i: usize) -> bool {
         if !self.evaluating.get() {
+            self.invalidate();
             self.inner.borrow_mut().remove(i);
             return true;
         }
@@ -147,6 +171,7 @@ impl<T: Ord> CursorVec<T> {
             Ordering::Equal => return false,
             Ordering::Greater => (),
         }
+        self.invalidate();
         self.inner.borrow_mut().remove(i);
         true
     }
@@ -159,6 +184,7 @@ impl<T: Ord> CursorVec<T> {
     }
 
     pub fn find_mut<P: FnMut(&T) -> bool>(&self, mut pred: P) -> Option<RefMut<'_, T>> {
+        self.invalidate();
         RefMut::filter_map(self.inner.borrow_mut(), |inner| {
             inner.iter_mut().find(|item| pred(item))
         })
@@ -171,13 +197,15 @@ impl<T: Ord> CursorVec<T> {
 
     pub fn retain<P: FnMut(&T) -> bool>(&self, mut pred: P) -> usize {
         let mut inner = self.inner.borrow_mut();
+        let len = inner.len();
         if !self.evaluating.get() {
-            let len = inner.len();
             inner.retain(pred);
+            if inner.len() != len {
+                self.invalidate();
+            }
             return len - inner.len();
         }
         let mut cursor = self.cursor.get();
-        let len = inner.len();
         let mut i = 0;
         inner.retain(|item| {
             // can't remove current sender
@@ -191,10 +219,337 @@ impl<T: Ord> CursorVec<T> {
             false
         });
         self.cursor.set(cursor);
+        if inner.len() != len {
+            self.invalidate();
+        }
         len - inner.len()
     }
 }
 
+impl<T: Ord + AsRef<Sender>> CursorVec<T> {
+    fn with_index<R, F: FnOnce(&SenderIndex) -> R>(&self, f: F) -> R {
+        let mut index = self.cache.index.borrow_mut();
+        f(index.get_or_insert_with(|| SenderIndex::new(&self.inner.borrow())))
+    }
+
+    /// Returns the position of the first item with a label. Items with non-empty labels are
+    /// looked up in an index, which is rebuilt after items are added, removed, or mutably
+    /// borrowed.
+    pub fn position_by_label(&self, label: &str) -> Option<usize> {
+        if label.is_empty() {
+            return self.position(|item| item.as_ref().label.is_empty());
+        }
+        self.with_index(|index| index.labels.get(label).copied())
+    }
+
+    pub fn find_by_label(&self, label: &str) -> Option<Ref<'_, T>> {
+        let pos = self.position_by_label(label)?;
+        self.get(pos)
+    }
+
+    pub fn find_by_label_mut(&self, label: &str) -> Option<RefMut<'_, T>> {
+        let pos = self.position_by_label(label)?;
+        self.invalidate();
+        RefMut::filter_map(self.inner.borrow_mut(), |inner| inner.get_mut(pos)).ok()
+    }
+
+    /// Returns the number of items in a group.
+    pub fn group_len(&self, group: &str) -> usize {
+        self.with_index(|index| index.groups.get(group).map_or(0, Vec::len))
+    }
+
+    /// Removes every item in a group, except the item currently being evaluated. Returns the
+    /// number of items removed.
+    pub fn remove_group(&self, group: &str) -> usize {
+        if self.group_len(group) == 0 {
+            return 0;
+        }
+        self.retain(|item| item.as_ref().group != group)
+    }
+}
+
+impl<T: Ord + AsRef<Sender> + AsMut<Sender>> CursorVec<T> {
+    /// Enables or disables the item with a label. Returns `false` if there is no such item.
+    ///
+    /// Unlike mutably borrowing the item, this keeps the label and group index.
+    pub fn set_enabled_by_label(&self, label: &str, enabled: bool) -> bool {
+        let Some(pos) = self.position_by_label(label) else {
+            return false;
+        };
+        self.cache.matchers.take();
+        self.inner.borrow_mut()[pos].as_mut().enabled = enabled;
+        true
+    }
+
+    /// Enables or disables every item in a group. Returns the number of items in the group.
+    ///
+    /// Unlike mutably borrowing the items, this keeps the label and group index, so it only
+    /// visits the items in the group.
+    pub fn set_group_enabled(&self, group: &str, enabled: bool) -> usize {
+        self.with_index(|index| {
+            let Some(positions) = index.groups.get(group) else {
+                return 0;
+            };
+            self.cache.matchers.take();
+            let mut inner = self.inner.borrow_mut();
+            for &pos in positions {
+                inner[pos].as_mut().enabled = enabled;
+            }
+            positions.len()
+        })
+    }
+}
+
+impl<T: Ord + AsRef<Reaction>> CursorVec<T> {
+    /// Returns the patterns of the enabled items, in order. The list is shared and rebuilt only
+    /// after items are added, removed, enabled, disabled, or mutably borrowed, so matching text
+    /// against it does not need to borrow any items.
+    pub fn matchers(&self) -> Matchers {
+        let mut matchers = self.cache.matchers.borrow_mut();
+        matchers
+            .get_or_insert_with(|| {
+                let inner = self.inner.borrow();
+                let enabled = inner
+                    .iter()
+                    .map(AsRef::as_ref)
+                    .enumerate()
+                    .filter(|(_, reaction)| reaction.enabled);
+                Matchers {
+                    generation: self.cache.generation.get(),
+                    list: Rc::new(MatcherList::new(enabled)),
+                }
+            })
+            .clone()
+    }
+}
+
+/// Snapshot of the patterns of the enabled items in a [`CursorVec`].
+#[derive(Clone, Debug)]
+pub struct Matchers {
+    generation: u64,
+    list: Rc<MatcherList>,
+}
+
+impl Matchers {
+    /// Returns `true` if two snapshots are the same list. A snapshot is reused until the list it
+    /// was taken from changes, so this tells whether anything relevant changed in between.
+    pub fn ptr_eq(this: &Self, other: &Self) -> bool {
+        Rc::ptr_eq(&this.list, &other.list)
+    }
+
+    /// Returns the matchers that may match a subject, in order, along with their indices. Patterns
+    /// anchored to literal text are looked up by the first character of that text and skipped if
+    /// the subject does not start with it, without running them.
+    pub fn candidates<'a>(&'a self, subject: &'a str) -> Candidates<'a> {
+        self.candidates_from(subject, 0)
+    }
+
+    /// Like [`candidates`](Self::candidates), but skips the matchers before index `start`.
+    pub fn candidates_from<'a>(&'a self, subject: &'a str, start: usize) -> Candidates<'a> {
+        let indexed = match subject.as_bytes().first() {
+            Some(first) => self
+                .list
+                .by_first
+                .get(&first.to_ascii_lowercase())
+                .map_or(&[][..], Vec::as_slice),
+            None => &[],
+        };
+        let unindexed = self.list.unindexed.as_slice();
+        Candidates {
+            matchers: &self.list.matchers,
+            indexed: &indexed[indexed.partition_point(|&i| i < start)..],
+            unindexed: &unindexed[unindexed.partition_point(|&i| i < start)..],
+            subject,
+        }
+    }
+}
+
+impl Deref for Matchers {
+    type Target = [Matcher];
+
+    fn deref(&self) -> &Self::Target {
+        &self.list.matchers
+    }
+}
+
+#[derive(Debug)]
+struct MatcherList {
+    matchers: Box<[Matcher]>,
+    /// Indices of matchers with a prefix, by its first character in lowercase.
+    by_first: HashMap<u8, Vec<usize>>,
+    /// Indices of matchers without a prefix, which have to be tried on every subject.
+    unindexed: Vec<usize>,
+}
+
+impl MatcherList {
+    fn new<'a, I>(items: I) -> Self
+    where
+        I: Iterator<Item = (usize, &'a Reaction)>,
+    {
+        let matchers: Box<[Matcher]> = items
+            .map(|(pos, reaction)| Matcher {
+                pos,
+                prefix: literal_prefix(reaction.regex.as_str()).into(),
+                ignore_case: reaction.ignore_case,
+                regex: reaction.regex.clone(),
+            })
+            .collect();
+        let mut by_first: HashMap<u8, Vec<usize>> = HashMap::new();
+        let mut unindexed = Vec::new();
+        for (i, matcher) in matchers.iter().enumerate() {
+            match matcher.prefix.as_bytes().first() {
+                Some(first) => by_first
+                    .entry(first.to_ascii_lowercase())
+                    .or_default()
+                    .push(i),
+                None => unindexed.push(i),
+            }
+        }
+        Self {
+            matchers,
+            by_first,
+            unindexed,
+        }
+    }
+}
+
+/// The pattern of an item, along with where to find the item.
+#[derive(Clone, Debug)]
+pub struct Matcher {
+    pos: usize,
+    /// ASCII text that every match starts with.
+    prefix: Box<str>,
+    ignore_case: bool,
+    regex: Rc<Regex>,
+}
+
+impl Matcher {
+    pub fn regex(&self) -> &Regex {
+        &self.regex
+    }
+
+    /// Returns `false` if the pattern cannot match a subject, because the subject does not start
+    /// with the literal text the pattern is anchored to.
+    pub fn may_match(&self, subject: &str) -> bool {
+        let prefix = self.prefix.as_bytes();
+        let Some(start) = subject.as_bytes().get(..prefix.len()) else {
+            return false;
+        };
+        if self.ignore_case {
+            start.eq_ignore_ascii_case(prefix)
+        } else {
+            start == prefix
+        }
+    }
+}
+
+/// Iterator returned by [`Matchers::candidates`].
+#[derive(Clone, Debug)]
+pub struct Candidates<'a> {
+    matchers: &'a [Matcher],
+    indexed: &'a [usize],
+    unindexed: &'a [usize],
+    subject: &'a str,
+}
+
+impl<'a> Iterator for Candidates<'a> {
+    type Item = (usize, &'a Matcher);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        loop {
+            // Merge the two lists, which are both in order.
+            let list = match (self.indexed.first(), self.unindexed.first()) {
+                (Some(a), Some(b)) if a < b => &mut self.indexed,
+                (_, Some(_)) => &mut self.unindexed,
+                (Some(_), None) => &mut self.indexed,
+                (None, None) => return None,
+            };
+            let (&i, rest) = list.split_first()?;
+            *list = rest;
+            let matcher = &self.matchers[i];
+            if matcher.may_match(self.subject) {
+                return Some((i, matcher));
+            }
+        }
+    }
+}
+
+impl FusedIterator for Candidates<'_> {}
+
+/// Positions of items by label and by group.
+#[derive(Clone, Debug, Default)]
+struct SenderIndex {
+    /// Position of the first item with each non-empty label.
+    labels: HashMap<String, usize>,
+    /// Positions of the items in each group, in order.
+    groups: HashMap<String, Vec<usize>>,
+}
+
+impl SenderIndex {
+    fn new<T: AsRef<Sender>>(items: &[T]) -> Self {
+        let mut index = Self::default();
+        for (pos, item) in items.iter().enumerate() {
+            let sender = item.as_ref();
+            if !sender.label.is_empty() && !index.labels.contains_key(&sender.label) {
+                index.labels.insert(sender.label.clone(), pos);
+            }
+            if let Some(positions) = index.groups.get_mut(&sender.group) {
+                positions.push(pos);
+            } else {
+                index.groups.insert(sender.group.clone(), vec![pos]);
+            }
+        }
+        index
+    }
+}
+
+/// Lazily built data derived entirely from the items, so it is ignored by comparisons and not
+/// cloned.
+#[derive(Debug, Default)]
+struct Cache {
+    index: RefCell<Option<SenderIndex>>,
+    matchers: RefCell<Option<Matchers>>,
+    /// Incremented whenever items may have moved, so that [`Matchers`] taken earlier can tell
+    /// whether the positions they recorded are still accurate.
+    generation: Cell<u64>,
+}
+
+impl Cache {
+    const fn new() -> Self {
+        Self {
+            index: RefCell::new(None),
+            matchers: RefCell::new(None),
+            generation: Cell::new(0),
+        }
+    }
+}
+
+impl Clone for Cache {
+    fn clone(&self) -> Self {
+        Self::default()
+    }
+}
+
+impl PartialEq for Cache {
+    fn eq(&self, _other: &Self) -> bool {
+        true
+    }
+}
+
+impl Eq for Cache {}
+
+impl PartialOrd for Cache {
+    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl Ord for Cache {
+    fn cmp(&self, _other: &Self) -> Ordering {
+        Ordering::Equal
+    }
+}
+
 impl<T> From<Vec<T>> for CursorVec<T> {
     fn from(value: Vec<T>) -> Self {
         Self {
@@ -264,6 +619,35 @@ impl<'a, T: Ord> Iterator for CursorVecScan<'a, T> {
 
 impl<T: Ord> FusedIterator for CursorVecScan<'_, T> {}
 
+impl<'a, T: Ord + AsRef<Reaction>> CursorVecScan<'a, T> {
+    /// Moves the scan to the item a matcher was taken from, as an alternative to visiting every
+    /// item in turn. Returns `None` if items have moved since the snapshot was taken, in which
+    /// case [`resume`](Self::resume) provides a new one, or if another scan has started.
+    pub fn seek(&self, matchers: &Matchers, matcher: &Matcher) -> Option<CursorVecRef<'a, T>> {
+        if self.vec.scan_id.get() != self.scan_id
+            || matchers.generation != self.vec.cache.generation.get()
+        {
+            return None;
+        }
+        self.vec.cursor.set(matcher.pos);
+        Some(CursorVecRef { vec: self.vec })
+    }
+
+    /// Returns a new snapshot if items have been added, removed, enabled, disabled, or mutably
+    /// borrowed since `matchers` was taken, along with the index in it of the first matcher after
+    /// the current item. Scanning the new snapshot from there visits the remaining items as they
+    /// are now, the same as stepping through them one at a time would.
+    pub fn resume(&self, matchers: &Matchers) -> Option<(Matchers, usize)> {
+        let current = self.vec.matchers();
+        if Matchers::ptr_eq(matchers, &current) {
+            return None;
+        }
+        let cursor = self.vec.cursor.get();
+        let start = current.partition_point(|matcher| matcher.pos <= cursor);
+        Some((current, start))
+    }
+}
+
 #[derive(Debug)]
 pub struct CursorVecRef<'a, T> {
     vec: &'a CursorVec<T>,
@@ -277,6 +661,151 @@ impl<T: Ord> CursorVecRef<'_, T> {
 
     pub fn borrow_mut(&self) -> RefMut<'_, T> {
         let cursor = self.vec.cursor.get();
+        self.vec.invalidate();
         RefMut::map(self.vec.inner.borrow_mut(), |vec| &mut vec[cursor])
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::Trigger;
+    use crate::testing::{timer, timers, trigger, triggers};
+
+    #[test]
+    fn index_tracks_insertions() {
+        let timers = timers();
+        assert_eq!(timers.group_len("a"), 2);
+        timers.insert(timer("a", "w"));
+        assert_eq!(timers.group_len("a"), 3);
+        let pos = timers.position_by_label("w").unwrap();
+        assert_eq!(timers.borrow()[pos].label, "w");
+    }
+
+    #[test]
+    fn set_group_enabled_only_changes_group() {
+        let timers = timers();
+        assert_eq!(timers.set_group_enabled("a", false), 2);
+        let enabled: Vec<bool> = timers.borrow().iter().map(|timer| timer.enabled).collect();
+        let expected: Vec<bool> = timers
+            .borrow()
+            .iter()
+            .map(|timer| timer.group != "a")
+            .collect();
+        assert_eq!(enabled, expected);
+        assert_eq!(timers.set_group_enabled("missing", false), 0);
+    }
+
+    #[test]
+    fn index_is_rebuilt_after_mutable_borrow() {
+        let timers = timers();
+        assert!(timers.find_by_label("x").is_some());
+        timers.borrow_mut()[0].send.label = "renamed".to_owned();
+        let renamed = timers.find_by_label("renamed").unwrap();
+        assert_eq!(renamed.label, "renamed");
+        drop(renamed);
+        assert_eq!(timers.remove_group("a"), 2);
+        assert_eq!(timers.group_len("a"), 0);
+        assert!(timers.find_by_label("y").is_some());
+    }
+
+    #[test]
+    fn matchers_are_shared_until_enabled_items_change() {
+        let triggers = triggers();
+        let matchers = triggers.matchers();
+        assert!(Rc::ptr_eq(&matchers.list, &triggers.matchers().list));
+        triggers.set_enabled_by_label("y", false);
+        let matchers = triggers.matchers();
+        let patterns: Vec<&str> = matchers.iter().map(|m| m.regex().as_str()).collect();
+        assert_eq!(patterns, ["a", "c"]);
+    }
+
+    #[test]
+    fn seek_requires_current_snapshot() {
+        let triggers = triggers();
+        let matchers = triggers.matchers();
+        let scan = triggers.scan();
+        assert_eq!(
+            scan.seek(&matchers, &matchers[1]).unwrap().borrow().label,
+            "y"
+        );
+        assert!(triggers.remove(0));
+        assert!(scan.seek(&matchers, &matchers[2]).is_none());
+        let (matchers, _) = scan.resume(&matchers).unwrap();
+        assert_eq!(
+            scan.seek(&matchers, &matchers[1]).unwrap().borrow().label,
+            "z"
+        );
+        drop(scan);
+        let stale = triggers.scan();
+        drop(triggers.scan());
+        assert!(stale.seek(&matchers, &matchers[1]).is_none());
+    }
+
+    #[test]
+    fn resume_continues_after_current_item() {
+        let triggers = triggers();
+        let matchers = triggers.matchers();
+        let scan = triggers.scan();
+        scan.seek(&matchers, &matchers[0]).unwrap();
+        assert!(scan.resume(&matchers).is_none());
+        let labels = |matchers: &Matchers, start| -> Vec<String> {
+            matchers
+                .candidates_from("", start)
+                .map(|(_, matcher)| triggers.borrow()[matcher.pos].label.clone())
+                .collect()
+        };
+
+        triggers.set_enabled_by_label("y", false);
+        let (matchers, start) = scan.resume(&matchers).unwrap();
+        assert_eq!(labels(&matchers, start), ["z"]);
+
+        triggers.set_enabled_by_label("y", true);
+        let (matchers, start) = scan.resume(&matchers).unwrap();
+        assert_eq!(labels(&matchers, start), ["y", "z"]);
+
+        assert!(triggers.remove(2));
+        let (matchers, start) = scan.resume(&matchers).unwrap();
+        assert_eq!(labels(&matchers, start), ["y"]);
+    }
+
+    #[test]
+    fn candidates_skip_other_prefixes_in_order() {
+        let triggers: CursorVec<Trigger> = [
+            trigger("a", "^north$"),
+            trigger("b", "(.*)"),
+            trigger("c", "^kill (.*)$"),
+            trigger("d", "^n(.*)$"),
+            trigger("e", "^Nor"),
+        ]
+        .into_iter()
+        .collect();
+        triggers
+            .find_by_label_mut("e")
+            .unwrap()
+            .set_ignore_case(true)
+            .unwrap();
+        let matchers = triggers.matchers();
+        let candidates =
+            |subject| -> Vec<usize> { matchers.candidates(subject).map(|(i, _)| i).collect() };
+        assert_eq!(candidates("north"), [0, 1, 3, 4]);
+        assert_eq!(candidates("NORTH"), [1, 4]);
+        assert_eq!(candidates("kill rat"), [1, 2]);
+        assert_eq!(candidates("kil"), [1]);
+        assert_eq!(candidates(""), [1]);
+    }
+
+    #[test]
+    fn candidates_scale_with_matching_prefixes() {
+        let aliases: CursorVec<Trigger> = (0..1000)
+            .map(|i| {
+                let first = char::from(b'a' + u8::try_from(i % 26).unwrap());
+                trigger(&i.to_string(), &format!("^{first}{i} (.*)$"))
+            })
+            .collect();
+        let matchers = aliases.matchers();
+        assert_eq!(matchers.candidates("x").count(), 0);
+        let candidates: Vec<usize> = matchers.candidates("c54 foo").map(|(i, _)| i).collect();
+        assert_eq!(candidates, [54]);
+    }
+}
@@ -1,5 +1,5 @@
 pub mod cursor_vec;
-pub use cursor_vec::{CursorVec, CursorVecRef, CursorVecScan};
+pub use cursor_vec::{Candidates, CursorVec, CursorVecRef, CursorVecScan, Matcher, Matchers};
 
 mod error;
 pub use error::{ImportError, LoadError, SenderAccessError};
@@ -8,6 +8,9 @@ pub mod hmsn;
 
 pub mod newline;
 
+#[cfg(any(test, feature = "testing"))]
+pub mod testing;
+
 mod plugin;
 pub use plugin::{Plugin, PluginIndex, PluginLoadError, PluginMetadata, PluginSender};
 
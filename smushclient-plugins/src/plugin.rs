@@ -81,7 +81,7 @@ pub trait PluginSender:
         if label.is_empty() {
             return Ok(());
         }
-        match senders.position(|sender| sender.as_ref().label == label) {
+        match senders.position_by_label(label) {
             None => Ok(()),
             Some(pos) => Err(pos),
         }
@@ -15,6 +15,9 @@ pub use captures::{CaptureMatches, Captures, Match};
 mod error;
 pub use error::RegexError;
 
+mod prefix;
+pub(crate) use prefix::literal_prefix;
+
 /// A wrapper around [`pcre2::bytes::Regex`] providing additional trait implementations.
 #[derive(Clone)]
 pub struct Regex(pub(super) pcre2::bytes::Regex);
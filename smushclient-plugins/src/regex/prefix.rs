@@ -0,0 +1,66 @@
+/// Returns ASCII text that every match of a pattern must start with, if the pattern is anchored
+/// to the start of the subject. Returns an empty string if there is no such text, or if the
+/// pattern is too complicated to tell.
+///
+/// Patterns with alternation are not analyzed, since an alternative may not be anchored.
+/// Non-ASCII characters end the prefix, so that it can be compared case-insensitively byte by
+/// byte.
+pub(crate) fn literal_prefix(pattern: &str) -> String {
+    let mut prefix = String::new();
+    let Some(source) = pattern.strip_prefix('^') else {
+        return prefix;
+    };
+    if source.contains('|') {
+        return prefix;
+    }
+    let mut chars = source.chars().peekable();
+    while let Some(c) = chars.next() {
+        let c = match c {
+            '\\' => match chars.next() {
+                Some(c) if c.is_ascii() && !c.is_ascii_alphanumeric() => c,
+                _ => break,
+            },
+            '.' | '[' | ']' | '(' | ')' | '{' | '}' | '^' | '$' | '*' | '+' | '?' => break,
+            c if c.is_ascii() => c,
+            _ => break,
+        };
+        match chars.peek() {
+            // The character is optional.
+            Some('?' | '*' | '{') => break,
+            // The character is required, but may be followed by more of itself.
+            Some('+') => {
+                prefix.push(c);
+                break;
+            }
+            _ => prefix.push(c),
+        }
+    }
+    prefix
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn literal_prefixes() {
+        let cases = [
+            ("^north$", "north"),
+            ("^kill (.*)$", "kill "),
+            (r"^say \.\.\.(.*)$", "say ..."),
+            ("^ab?c", "a"),
+            ("^ab+c", "ab"),
+            ("^ab{2}", "a"),
+            (r"^a\x41", "a"),
+            (r"^a\d", "a"),
+            ("^café", "caf"),
+            ("^(?i)north", ""),
+            ("north", ""),
+            ("^north|south", ""),
+            ("^[ns]", ""),
+        ];
+        for (pattern, prefix) in cases {
+            assert_eq!(literal_prefix(pattern), prefix, "pattern: {pattern:?}");
+        }
+    }
+}
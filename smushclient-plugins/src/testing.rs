@@ -0,0 +1,85 @@
+//! Senders and timing helpers for tests, shared with dependent crates through the `testing`
+//! feature.
+
+use std::hint::black_box;
+use std::time::{Duration, Instant};
+
+use crate::{Alias, CursorVec, Timer, Trigger};
+
+/// Returns an alias with a wildcard pattern, where `*` matches anything.
+pub fn alias(label: &str, pattern: &str) -> Alias {
+    let mut alias = Alias::default();
+    alias.send.label = label.to_owned();
+    alias.set_pattern(pattern.to_owned()).unwrap();
+    alias
+}
+
+pub fn timer(group: &str, label: &str) -> Timer {
+    let mut timer = Timer::default();
+    timer.send.group = group.to_owned();
+    timer.send.label = label.to_owned();
+    timer
+}
+
+/// Timers `x` and `z` in group `a`, and `y` in group `b`.
+pub fn timers() -> CursorVec<Timer> {
+    let timers: CursorVec<Timer> = [timer("a", "x"), timer("b", "y"), timer("a", "z")]
+        .into_iter()
+        .collect();
+    timers.request_sort();
+    timers
+}
+
+/// Returns a trigger with a regular expression pattern.
+pub fn trigger(label: &str, pattern: &str) -> Trigger {
+    let mut trigger = wildcard_trigger(label, pattern);
+    trigger.set_is_regex(true).unwrap();
+    trigger
+}
+
+/// Returns a trigger with a wildcard pattern, where `*` matches anything.
+pub fn wildcard_trigger(label: &str, pattern: &str) -> Trigger {
+    let mut trigger = Trigger::default();
+    trigger.send.label = label.to_owned();
+    trigger.set_pattern(pattern.to_owned()).unwrap();
+    trigger
+}
+
+/// Triggers `x`, `y` and `z`, matching `a`, `b` and `c`.
+pub fn triggers() -> CursorVec<Trigger> {
+    [trigger("x", "a"), trigger("y", "b"), trigger("z", "c")]
+        .into_iter()
+        .collect()
+}
+
+/// 40 plugins with 20 triggers each, labeled `t0` to `t19`, mixing regular expressions and
+/// wildcards. Each trigger matches a number below 97 as a word.
+pub fn plugins() -> Vec<CursorVec<Trigger>> {
+    (0..40)
+        .map(|plugin| {
+            (0..20)
+                .map(|i| {
+                    let n = (plugin * 20 + i) % 97;
+                    let label = format!("t{i}");
+                    if i % 2 == 0 {
+                        trigger(&label, &format!(r"\b{n}\b"))
+                    } else {
+                        wildcard_trigger(&label, &format!("* {n} *"))
+                    }
+                })
+                .collect()
+        })
+        .collect()
+}
+
+/// Runs `f` `iterations` times and prints the average time per call. Used by timing tests, which
+/// are ignored by default and run with `cargo test --release -- --ignored --nocapture`.
+pub fn time<R, F: FnMut() -> R>(label: &str, iterations: u32, mut f: F) -> Duration {
+    let started = Instant::now();
+    for _ in 0..iterations {
+        black_box(f());
+    }
+    let per_call = started.elapsed() / iterations;
+    println!("{label}: {per_call:?} per call ({iterations} calls)");
+    per_call
+}
@@ -1,41 +1,52 @@
 #include "timekeeper.h"
 #include "../client.h"
-#include "../scripting/scriptapi.h"
-#include "../timermap.h"
+#include <algorithm>
+#include <limits>
 
 using std::chrono::milliseconds;
-using std::chrono::seconds;
 
 Timekeeper::Timekeeper(SmushClient& client, QObject* parent)
   : AbstractTimekeeper(parent)
-  , pollTimer(new QTimer(this))
-  , queue(new TimerMap<Timekeeper::Item, SmushClient>(client,
-                                                      &SmushClient::finishTimer,
-                                                      this))
+  , client(client)
+  , wakeTimer(new QTimer(this))
 {
-  connect(pollTimer, &QTimer::timeout, &client, &SmushClient::onTimersPolled);
+  wakeTimer->setSingleShot(true);
+  wakeTimer->setTimerType(Qt::TimerType::PreciseTimer);
+  connect(wakeTimer, &QTimer::timeout, this, &Timekeeper::onWakeup);
 }
 
 void
-Timekeeper::beginPolling(milliseconds interval, Qt::TimerType timerType)
+Timekeeper::cancelTimers(const QSet<uint16_t>& timerIds)
 {
-  pollTimer->setInterval(interval);
-  pollTimer->setTimerType(timerType);
-  pollTimer->start();
+  client.removeTimers(timerIds);
+  rearm();
 }
 
 void
-Timekeeper::cancelTimers(const QSet<uint16_t>& timerIds)
+Timekeeper::rearm() const
 {
-  queue->erase_if([timerIds](const Timekeeper::Item& item) {
-    return timerIds.contains(item.timerId);
-  });
+  client.armTimekeeper(*this);
 }
 
 // Public overrides
 
 void
-Timekeeper::startSendTimer(size_t index, uint16_t timerId, uint millis) const
+Timekeeper::armTimer(int64_t millis) const
+{
+  if (millis < 0) {
+    wakeTimer->stop();
+    return;
+  }
+  // QTimer intervals are limited to int milliseconds. A deadline further away
+  // than that wakes up early, polls nothing, and rearms.
+  constexpr int64_t maxInterval = std::numeric_limits<int>::max();
+  wakeTimer->start(milliseconds{ std::min(millis, maxInterval) });
+}
+
+// Private slots
+
+void
+Timekeeper::onWakeup()
 {
-  queue->start(milliseconds{ millis }, { .index = index, .timerId = timerId });
+  client.pollTimers(*this);
 }
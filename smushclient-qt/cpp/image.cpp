@@ -4,19 +4,75 @@
 #include <QtGui/QBitmap>
 #include <QtGui/QImage>
 #include <QtGui/QPainter>
+#include <chrono>
+#include <mutex>
+
+using std::chrono::steady_clock;
+using namespace std::chrono_literals;
 
 // Private utils
 
 namespace {
+// Images are decoded on worker threads, so conversions may be counted from any
+// thread.
+class ConversionCounter
+{
+public:
+  void add()
+  {
+    const std::lock_guard lock(mutex);
+    roll(steady_clock::now());
+    ++total;
+    ++current;
+  }
+
+  image::ConversionStats stats()
+  {
+    const std::lock_guard lock(mutex);
+    roll(steady_clock::now());
+    return { .total = total, .lastSecond = previous };
+  }
+
+private:
+  void roll(steady_clock::time_point now) noexcept
+  {
+    const steady_clock::duration elapsed = now - windowStart;
+    if (elapsed < 1s) {
+      return;
+    }
+    previous = elapsed < 2s ? current : 0;
+    current = 0;
+    windowStart = now;
+  }
+
+private:
+  std::mutex mutex;
+  uint64_t total = 0;
+  uint64_t current = 0;
+  uint64_t previous = 0;
+  steady_clock::time_point windowStart = steady_clock::now();
+};
+
+ConversionCounter conversionCounter;
+
 QImage
 dissolve(const QPixmap& source, const QRect& rect, qreal opacity)
 {
   QImage image = image::crop(source, rect);
-  image.convertTo(QImage::Format::Format_ARGB32);
-  ffi::filter::dissolve(image::asPixelsMut(image), opacity);
+  image::convert(image, image::canonicalFormat);
+  ffi::filter::dissolve_premultiplied(image::asPixelsMut(image), opacity);
   return image;
 }
 
+void
+reinterpretIfOpaque(QImage& image, QImage::Format format)
+{
+  if (ffi::filter::is_opaque(image::asPixels(image)) &&
+      image.reinterpretAsFormat(format)) {
+    return;
+  }
+  image::convert(image, format);
+}
 } // namespace
 
 // Public functions
@@ -109,21 +165,39 @@ colorPixel(const QColor& color)
 void
 colorToAlpha(QImage& image, const QColor& color)
 {
-  image.convertTo(QImage::Format::Format_ARGB32_Premultiplied);
+  convert(image, canonicalFormat);
   ffi::filter::color_to_alpha(asPixelsMut(image), color);
 }
 
+void
+convert(QImage& image, QImage::Format format)
+{
+  if (image.format() == format || image.isNull()) {
+    return;
+  }
+  image.convertTo(format);
+  conversionCounter.add();
+}
+
+ConversionStats
+conversionStats()
+{
+  return conversionCounter.stats();
+}
+
 QImage
 crop(const QPixmap& pixmap, const QRect& rect)
 {
-  return rect == pixmap.rect() ? pixmap.toImage() : pixmap.copy(rect).toImage();
+  // For raster pixmaps, toImage shares data instead of copying it.
+  const QImage image = pixmap.toImage();
+  return rect == image.rect() ? image : image.copy(rect);
 }
 
 QBitmap
 invertBitmap(const QPixmap& base)
 {
   QImage image = base.toImage();
-  image.convertTo(bitmapFormat);
+  convert(image, bitmapFormat);
   std::span<unsigned char> bytes(image.bits(), image.sizeInBytes());
   for (unsigned char& byte : bytes) {
     byte = ~byte;
@@ -134,10 +208,43 @@ invertBitmap(const QPixmap& base)
 bool
 mask(QImage& image, QImage& mask, qreal opacity)
 {
-  image.convertTo(QImage::Format::Format_ARGB32_Premultiplied);
-  mask.convertTo(QImage::Format::Format_Grayscale8);
-  return ffi::filter::mask_premultiplied(
-    asPixelsMut(image), asBytes(mask), opacity);
+  convert(image, canonicalFormat);
+  convert(mask, QImage::Format::Format_Grayscale8);
+  // Grayscale8 rows are padded to 4 bytes.
+  return ffi::filter::mask_premultiplied(asPixelsMut(image),
+                                         image.width(),
+                                         asBytes(mask),
+                                         mask.bytesPerLine(),
+                                         opacity);
+}
+
+void
+normalize(QImage& image)
+{
+  switch (image.format()) {
+    case canonicalFormat:
+      return;
+    case QImage::Format::Format_RGB32:
+      // RGB32 pixels are stored with full alpha.
+      if (image.reinterpretAsFormat(canonicalFormat)) {
+        return;
+      }
+      break;
+    case QImage::Format::Format_ARGB32:
+      reinterpretIfOpaque(image, canonicalFormat);
+      return;
+    default:
+      break;
+  }
+  convert(image, canonicalFormat);
+}
+
+QPixmap
+normalizedPixmap(const QSize& size)
+{
+  // QPixmap(size) would pick an opaque format, which must be converted when
+  // drawn with transparency.
+  return QPixmap::fromImage(QImage(size, canonicalFormat));
 }
 
 QRgb
@@ -155,6 +262,26 @@ topLeftPixel(const QPixmap& pixmap)
   if (pixmap.size().isEmpty()) {
     return QRgb();
   }
-  return pixmap.copy(QRect(0, 0, 1, 1)).toImage().pixel(0, 0);
+  return pixmap.toImage().pixel(0, 0);
+}
+
+void
+unpremultiply(QImage& image)
+{
+  switch (image.format()) {
+    case QImage::Format::Format_ARGB32:
+      return;
+    case QImage::Format::Format_RGB32:
+      if (image.reinterpretAsFormat(QImage::Format::Format_ARGB32)) {
+        return;
+      }
+      break;
+    case canonicalFormat:
+      reinterpretIfOpaque(image, QImage::Format::Format_ARGB32);
+      return;
+    default:
+      break;
+  }
+  convert(image, QImage::Format::Format_ARGB32);
 }
 } // namespace image
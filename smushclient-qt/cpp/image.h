@@ -10,6 +10,17 @@ const QImage::Format bitmapFormat = std::endian::native == std::endian::little
                                       ? QImage::Format::Format_MonoLSB
                                       : QImage::Format::Format_Mono;
 
+// Format that miniwindow images and backing stores are kept in, so that
+// drawing and filtering them does not require conversions.
+const QImage::Format canonicalFormat =
+  QImage::Format::Format_ARGB32_Premultiplied;
+
+struct ConversionStats
+{
+  uint64_t total;
+  uint64_t lastSecond;
+};
+
 inline rust::Slice<const uint8_t>
 asBytes(const QImage& image) noexcept
 {
@@ -60,6 +71,14 @@ colorPixel(const QColor& color);
 void
 colorToAlpha(QImage& image, const QColor& color);
 
+// Converts an image to a format, unless it is already in that format. Every
+// conversion is counted in conversionStats.
+void
+convert(QImage& image, QImage::Format format);
+
+ConversionStats
+conversionStats();
+
 QImage
 crop(const QPixmap& pixmap, const QRect& rect);
 
@@ -69,9 +88,24 @@ invertBitmap(const QPixmap& base);
 bool
 mask(QImage& image, QImage& mask, qreal opacity);
 
+// Puts a 32-bit image in canonicalFormat. Opaque images are reinterpreted in
+// place rather than converted.
+void
+normalize(QImage& image);
+
+// Creates a pixmap in canonicalFormat.
+QPixmap
+normalizedPixmap(const QSize& size);
+
 QRgb
 topLeftPixel(const QImage& image);
 
 QRgb
 topLeftPixel(const QPixmap& pixmap);
+
+// Puts a 32-bit image in straight ARGB32, for filters that operate on
+// unpremultiplied channels. Opaque images are reinterpreted in place rather
+// than converted.
+void
+unpremultiply(QImage& image);
 } // namespace image
@@ -54,9 +54,7 @@ AbstractSenderModel::addItem(QWidget* parent)
     return false;
   }
 
-  beginResetModel();
-  *needsRefresh = true;
-  endResetModel();
+  sync();
   return true;
 }
 
@@ -82,6 +80,8 @@ AbstractSenderModel::editItem(const QModelIndex& modelIndex, QWidget* parent)
   const int newIndex = edit(index, parent);
 
   if (newIndex == index) {
+    // Views filter the row again when its data changes.
+    map->refreshSender(client, index);
     emit dataChanged(modelIndex.siblingAtColumn(0),
                      modelIndex.siblingAtColumn(numColumns - 1),
                      { Qt::DisplayRole });
@@ -89,9 +89,7 @@ AbstractSenderModel::editItem(const QModelIndex& modelIndex, QWidget* parent)
   }
 
   if (newIndex == static_cast<int>(ReplaceSenderResult::GroupChanged)) {
-    beginResetModel();
-    *needsRefresh = true;
-    endResetModel();
+    sync();
     return true;
   }
 
@@ -127,6 +125,29 @@ AbstractSenderModel::editItem(const QModelIndex& modelIndex, QWidget* parent)
   return true;
 }
 
+bool
+AbstractSenderModel::filterAcceptsRow(int row, const QModelIndex& parent) const
+{
+  if (filter.isEmpty()) {
+    return true;
+  }
+
+  if (row < 0) {
+    return false;
+  }
+
+  if (!parent.isValid()) {
+    return map->groupFilterAccepts(row);
+  }
+
+  const rust::String* group = map->groupName(parent.row());
+  if (group == nullptr) {
+    return false;
+  }
+
+  return map->filterAccepts(*group, row);
+}
+
 QString
 AbstractSenderModel::tryExportXml() const
 {
@@ -136,10 +157,10 @@ AbstractSenderModel::tryExportXml() const
 ParseResult
 AbstractSenderModel::importXml(const QString& xml)
 {
-  beginResetModel();
   const ParseResult result = import(xml);
-  *needsRefresh = result.code > 0;
-  endResetModel();
+  if (result.code > 0) {
+    sync();
+  }
   return result;
 }
 
@@ -187,6 +208,15 @@ AbstractSenderModel::senderIndex(const QModelIndex& index) const
   return map->senderIndex(*group, row);
 }
 
+void
+AbstractSenderModel::setFilter(const QString& newFilter)
+{
+  filter = newFilter;
+  // Matches are computed here, once, so that filterAcceptsRow only reads them.
+  refresh();
+  map->setFilter(client, filter, numColumns);
+}
+
 // Public overrides
 
 int
@@ -420,7 +450,45 @@ AbstractSenderModel::removeRowsInternal(int row,
   prepareRemove(*map, *group, row, count);
   beginRemoveRows(parent, row, row + count - 1);
   const bool succeeded = map->remove(client, *group, row, count);
+  // Refresh now, so that later syncs start from what views were told.
   *needsRefresh = true;
+  refresh();
   endRemoveRows();
   return succeeded;
 }
+
+void
+AbstractSenderModel::sync()
+{
+  refresh();
+  const size_t edits = map->stage(client);
+  for (size_t i = 0; i < edits; ++i) {
+    const SenderMapEdit edit = map->stagedEdit(i);
+    const int last = edit.first + edit.count - 1;
+    switch (edit.kind) {
+      case SenderMapEditKind::InsertGroup:
+        beginInsertRows(QModelIndex(), edit.group, edit.group);
+        map->applyStagedEdit(i);
+        endInsertRows();
+        break;
+      case SenderMapEditKind::RemoveGroup:
+        beginRemoveRows(QModelIndex(), edit.group, edit.group);
+        map->applyStagedEdit(i);
+        endRemoveRows();
+        break;
+      case SenderMapEditKind::InsertRows:
+        beginInsertRows(createIndex(edit.group, 0), edit.first, last);
+        map->applyStagedEdit(i);
+        endInsertRows();
+        break;
+      case SenderMapEditKind::RemoveRows:
+        beginRemoveRows(createIndex(edit.group, 0), edit.first, last);
+        map->applyStagedEdit(i);
+        endRemoveRows();
+        break;
+      default:
+        break;
+    }
+  }
+  map->unstage();
+}
@@ -19,10 +19,14 @@ public:
                       QObject* parent = nullptr);
   bool addItem(QWidget* parent = nullptr);
   bool editItem(const QModelIndex& index, QWidget* parent = nullptr);
+  // Returns true if a row matches the filter set by setFilter. Group rows only
+  // match if their name does.
+  bool filterAcceptsRow(int row, const QModelIndex& parent) const;
   QString tryExportXml() const;
   ParseResult importXml(const QString& xml);
   bool removeSelection(const QItemSelection& selection);
   int senderIndex(const QModelIndex& index) const;
+  void setFilter(const QString& filter);
   int columnCount(const QModelIndex& index = {}) const override;
   QVariant data(const QModelIndex& index,
                 int role = Qt::DisplayRole) const override;
@@ -59,9 +63,13 @@ protected:
 private:
   void refresh() const;
   bool removeRowsInternal(int row, int count, const QModelIndex& parent = {});
+  // Updates the model to match the client's senders, notifying views of each
+  // group and row that was inserted or removed.
+  void sync();
 
 private:
   SenderKind kind;
+  QString filter;
   SenderMap* map;
   std::unique_ptr<bool> needsRefresh;
 };
@@ -6,6 +6,7 @@ extern "C"
 }
 
 using qlua::push;
+using qlua::pushList;
 
 // Abstract
 
@@ -167,6 +168,31 @@ TimerCallback::pushArguments(lua_State* L) const
   return 1;
 }
 
+int
+HostAddressCallback::pushArguments(lua_State* L) const
+{
+  push(L, hostName);
+  pushList(L, addresses);
+  return 2;
+}
+
+int
+HostNameCallback::pushArguments(lua_State* L) const
+{
+  push(L, address);
+  push(L, hostName);
+  return 2;
+}
+
+int
+ImageLoadedCallback::pushArguments(lua_State* L) const
+{
+  push(L, windowName);
+  push(L, imageID);
+  push(L, code);
+  return 3;
+}
+
 namespace {
 QByteArray
   emptyByteArray; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
@@ -1,6 +1,7 @@
 #pragma once
 #include "../scriptenums.h"
 #include "key.h"
+#include <QtNetwork/QHostAddress>
 
 struct lua_State;
 
@@ -418,3 +419,72 @@ public:
 private:
   const QByteArrayView label;
 };
+
+class HostAddressCallback : public DynamicPluginCallback
+{
+public:
+  HostAddressCallback(PluginCallbackKey callback,
+                      const QString& hostName,
+                      const QList<QHostAddress>& addresses) noexcept
+    : DynamicPluginCallback(callback)
+    , hostName(hostName)
+    , addresses(addresses)
+  {
+  }
+  constexpr ActionSource source() const noexcept override
+  {
+    return ActionSource::Unknown;
+  }
+  int pushArguments(lua_State* L) const override;
+
+private:
+  const QString& hostName;
+  const QList<QHostAddress>& addresses;
+};
+
+class HostNameCallback : public DynamicPluginCallback
+{
+public:
+  HostNameCallback(PluginCallbackKey callback,
+                   const QString& address,
+                   const QString& hostName) noexcept
+    : DynamicPluginCallback(callback)
+    , address(address)
+    , hostName(hostName)
+  {
+  }
+  constexpr ActionSource source() const noexcept override
+  {
+    return ActionSource::Unknown;
+  }
+  int pushArguments(lua_State* L) const override;
+
+private:
+  const QString& address;
+  const QString& hostName;
+};
+
+class ImageLoadedCallback : public DynamicPluginCallback
+{
+public:
+  ImageLoadedCallback(PluginCallbackKey callback,
+                      std::string_view windowName,
+                      std::string_view imageID,
+                      ApiCode code) noexcept
+    : DynamicPluginCallback(callback)
+    , windowName(windowName)
+    , imageID(imageID)
+    , code(code)
+  {
+  }
+  constexpr ActionSource source() const noexcept override
+  {
+    return ActionSource::Unknown;
+  }
+  int pushArguments(lua_State* L) const override;
+
+private:
+  std::string_view windowName;
+  std::string_view imageID;
+  ApiCode code;
+};
@@ -0,0 +1,87 @@
+#include "hostcache.h"
+#include <QtCore/QTimer>
+
+using std::chrono::seconds;
+
+// Private utils
+
+namespace {
+// QHostInfo does not expose record TTLs, so results are kept for a fixed time.
+// Failures are cached briefly so a script polling an unreachable host does not
+// flood the resolver.
+constexpr seconds successTtl(300);
+constexpr seconds failureTtl(30);
+constexpr qsizetype maxEntries = 256;
+} // namespace
+
+// Public static methods
+
+HostCache&
+HostCache::global()
+{
+  static HostCache cache;
+  return cache;
+}
+
+// Public methods
+
+QHostInfo
+HostCache::lookup(const QString& name)
+{
+  if (const QHostInfo* cached = find(name)) {
+    return *cached;
+  }
+  return insert(name, QHostInfo::fromName(name));
+}
+
+void
+HostCache::lookupAsync(const QString& name,
+                       const QObject* context,
+                       Callback&& callback)
+{
+  if (const QHostInfo* cached = find(name)) {
+    QTimer::singleShot(
+      0, context, [info = *cached, callback = std::move(callback)] {
+        callback(info);
+      });
+    return;
+  }
+  QHostInfo::lookupHost(
+    name,
+    context,
+    [this, name, callback = std::move(callback)](const QHostInfo& info) {
+      callback(insert(name, info));
+    });
+}
+
+// Private methods
+
+const QHostInfo*
+HostCache::find(const QString& name)
+{
+  auto iter = entries.find(name);
+  if (iter == entries.end()) {
+    return nullptr;
+  }
+  if (iter->expiry.hasExpired()) {
+    entries.erase(iter);
+    return nullptr;
+  }
+  return &iter->info;
+}
+
+const QHostInfo&
+HostCache::insert(const QString& name, const QHostInfo& info)
+{
+  if (entries.size() >= maxEntries) {
+    entries.removeIf([](const auto& item) {
+      return item.value().expiry.hasExpired();
+    });
+    if (entries.size() >= maxEntries) {
+      entries.clear();
+    }
+  }
+  const seconds ttl =
+    info.error() == QHostInfo::NoError ? successTtl : failureTtl;
+  return entries.insert(name, { info, QDeadlineTimer(ttl) })->info;
+}
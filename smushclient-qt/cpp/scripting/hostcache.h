@@ -0,0 +1,36 @@
+#pragma once
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QHash>
+#include <QtNetwork/QHostInfo>
+#include <functional>
+
+class HostCache
+{
+public:
+  using Callback = std::function<void(const QHostInfo& info)>;
+
+  static HostCache& global();
+
+  void clear() { entries.clear(); }
+  // Resolves from the cache if possible, otherwise blocks on a lookup.
+  QHostInfo lookup(const QString& name);
+  // Invokes callback with the result once it is available. The callback is
+  // always invoked asynchronously, even when the result is already cached, and
+  // is discarded if context is destroyed first.
+  void lookupAsync(const QString& name,
+                   const QObject* context,
+                   Callback&& callback);
+
+private:
+  struct Entry
+  {
+    QHostInfo info;
+    QDeadlineTimer expiry;
+  };
+
+  const QHostInfo* find(const QString& name);
+  const QHostInfo& insert(const QString& name, const QHostInfo& info);
+
+private:
+  QHash<QString, Entry> entries;
+};
@@ -1,5 +1,7 @@
 #include "api.h"
+#include "../../casting.h"
 #include "../../image.h"
+#include "../../spans.h"
 #include "../miniwindow/imagefilters.h"
 #include "../qlua.h"
 #include "../scriptapi.h"
@@ -7,6 +9,12 @@
 #include "smushclient_qt/src/ffi/client.cxxqt.h"
 #include <QtCore/QElapsedTimer>
 #include <QtCore/QPointer>
+#include <QtCore/QRegularExpression>
+#include <QtGui/QTextBlock>
+#include <cmath>
+#include <limits>
+#include <new>
+#include <type_traits>
 extern "C"
 {
 #include "lauxlib.h"
@@ -47,6 +55,7 @@ using qlua::getQRectF;
 using qlua::getQSize;
 using qlua::getQString;
 using qlua::getString;
+using qlua::getStrings;
 using qlua::isScriptName;
 using qlua::push;
 using qlua::pushEntry;
@@ -157,6 +166,26 @@ convertVolume(lua_Number decibels) noexcept
   return static_cast<float>(1.0 / pow(2, decibels / -3.0));
 }
 
+void
+pushStyles(lua_State* L, const QTextBlock& block)
+{
+  const QString text = block.text();
+  const QList<QTextLayout::FormatRange> ranges = block.textFormats();
+  lua_createtable(L, static_cast<int>(ranges.size()), 0);
+  lua_Integer i = 0;
+  for (const QTextLayout::FormatRange& range : ranges) {
+    const QByteArray utf8 =
+      QStringView(text).sliced(range.start, range.length).toUtf8();
+    lua_createtable(L, 0, 5);
+    pushEntry(L, "textcolour", range.format.foreground().color());
+    pushEntry(L, "backcolour", range.format.background().color());
+    pushEntry(L, "text", utf8);
+    pushEntry(L, "length", static_cast<lua_Integer>(utf8.size()));
+    pushEntry(L, "style", spans::getStyles(range.format).toInt());
+    lua_rawseti(L, -2, ++i);
+  }
+}
+
 void
 pushVariable(lua_State* L, string_view variable)
 {
@@ -1120,6 +1149,22 @@ L_SetLogOutput(lua_State* L)
   return 0;
 }
 
+int
+L_StartRecording(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 1);
+  return returnCode(L, getApi(L).StartRecording(getString(L, 1)));
+}
+
+int
+L_StopRecording(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 0);
+  return returnCode(L, getApi(L).StopRecording());
+}
+
 int
 L_WriteLog(lua_State* L)
 {
@@ -1163,6 +1208,16 @@ L_GetHostAddress(lua_State* L)
   return 1;
 }
 
+int
+L_GetHostAddressAsync(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 2);
+  return returnCode(L,
+                    getApi(L).GetHostAddressAsync(
+                      getPluginIndex(L), getQString(L, 1), getString(L, 2)));
+}
+
 int
 L_GetHostName(lua_State* L)
 {
@@ -1172,6 +1227,16 @@ L_GetHostName(lua_State* L)
   return 1;
 }
 
+int
+L_GetHostNameAsync(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 2);
+  return returnCode(L,
+                    getApi(L).GetHostNameAsync(
+                      getPluginIndex(L), getQString(L, 1), getString(L, 2)));
+}
+
 int
 L_GetReceivedBytes(lua_State* L)
 {
@@ -1648,6 +1713,35 @@ L_GetLineCount(lua_State* L)
   return 1;
 }
 
+int
+L_GetLines(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 3);
+  const int first = std::max(getInt(L, 1, 1), 1) - 1;
+  const int count = getInt(L, 2, -1);
+  const bool withStyles = getBool(L, 3, false);
+  const ScriptApi& api = getApi(L);
+  const int available = std::max(api.GetLinesInBufferCount() - first, 0);
+  const int size = count < 0 ? available : std::min(count, available);
+  lua_createtable(L, size, 0);
+  QTextBlock block = api.outputBlock(first);
+  for (int i = 1; i <= size && block.isValid(); ++i) {
+    lua_createtable(L, 0, withStyles ? 4 : 3);
+    const LineType lineType = spans::getLineType(block.charFormat());
+    pushEntry(L, "text", block.text());
+    pushEntry(L, "type", static_cast<int>(lineType));
+    pushEntry(L, "time", spans::getTimestamp(block.blockFormat()));
+    if (withStyles) {
+      pushStyles(L, block);
+      lua_setfield(L, -2, "styles");
+    }
+    lua_rawseti(L, -2, i);
+    block = block.next();
+  }
+  return 1;
+}
+
 int
 L_GetLinesInBufferCount(lua_State* L)
 {
@@ -1688,6 +1782,77 @@ L_GetWorldWindowPosition(lua_State* L)
   return 1;
 }
 
+// State of a Lines loop, kept in a userdata upvalue of the iterator. It has no
+// finalizer, so it must not own anything.
+struct LinesState
+{
+  // The line returned by the previous step, or an invalid block before the
+  // first step.
+  QTextBlock block;
+  lua_Integer line;
+  // ScriptApi::outputRemovals when block was found.
+  uint64_t removals;
+  lua_Integer last;
+  bool withStyles;
+};
+static_assert(std::is_trivially_destructible_v<LinesState>);
+
+// Iterator for Lines. The control variable is the previous line number. Steps
+// to the next block from the previous one, unless text has been removed from
+// the output since, in which case the previous block may be gone and the line
+// is looked up by number instead, as it is if the iterator is called out of
+// order.
+int
+L_LinesNext(lua_State* L)
+{
+  auto& state =
+    *static_cast<LinesState*>(lua_touserdata(L, lua_upvalueindex(1)));
+  const lua_Integer line = lua_tointeger(L, 2) + 1;
+  if (line > state.last) {
+    return 0;
+  }
+  const ScriptApi& api = getApi(L);
+  const uint64_t removals = api.outputRemovals();
+  if (state.block.isValid() && state.line == line - 1 &&
+      state.removals == removals) {
+    state.block = state.block.next();
+  } else {
+    state.block = api.outputBlock(clamped_cast<int>(line - 1));
+    state.removals = removals;
+  }
+  state.line = line;
+  const QTextBlock& block = state.block;
+  if (!block.isValid()) {
+    return 0;
+  }
+  push(L, line);
+  push(L, block.text());
+  push(L, static_cast<int>(spans::getLineType(block.charFormat())));
+  push(L, spans::getTimestamp(block.blockFormat()));
+  if (!state.withStyles) {
+    return 4;
+  }
+  pushStyles(L, block);
+  return 5;
+}
+
+int
+L_Lines(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 3);
+  const lua_Integer first = std::max(getInteger(L, 1, 1), lua_Integer(1));
+  const lua_Integer last =
+    getInteger(L, 2, std::numeric_limits<lua_Integer>::max());
+  const bool withStyles = getBool(L, 3, false);
+  new (lua_newuserdatauv(L, sizeof(LinesState), 0))
+    LinesState{ QTextBlock(), 0, 0, last, withStyles };
+  lua_pushcclosure(L, L_LinesNext, 1);
+  lua_pushnil(L);
+  push(L, first - 1);
+  return 3;
+}
+
 int
 L_OpenBrowser(lua_State* L)
 {
@@ -1714,6 +1879,41 @@ L_Reset(lua_State* L)
   return 0;
 }
 
+int
+L_SearchOutput(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 4);
+  const QString text = getQString(L, 1);
+  const bool isRegex = getBool(L, 2, false);
+  const bool matchCase = getBool(L, 3, true);
+  const lua_Integer limit = getInteger(L, 4, 0);
+  const qsizetype maxMatches = limit > 0 ? static_cast<qsizetype>(limit) : -1;
+  const ScriptApi& api = getApi(L);
+  QList<SearchIndex::Match> matches;
+  if (isRegex) {
+    const QRegularExpression pattern(
+      text,
+      matchCase ? QRegularExpression::NoPatternOption
+                : QRegularExpression::CaseInsensitiveOption);
+    luaL_argcheck(L, pattern.isValid(), 1, "invalid regular expression");
+    matches = api.SearchOutput(pattern, maxMatches);
+  } else {
+    matches = api.SearchOutput(
+      text, matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive, maxMatches);
+  }
+  lua_createtable(L, static_cast<int>(matches.size()), 0);
+  lua_Integer i = 0;
+  for (const SearchIndex::Match& match : matches) {
+    lua_createtable(L, 0, 3);
+    pushEntry(L, "line", match.line + 1);
+    pushEntry(L, "column", match.column + 1);
+    pushEntry(L, "length", match.length);
+    lua_rawseti(L, -2, ++i);
+  }
+  return 1;
+}
+
 int
 L_SetBackgroundImage(lua_State* L)
 {
@@ -2832,6 +3032,18 @@ L_FilterPixel(lua_State* L)
   }
 }
 
+int
+L_WindowAddTile(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 7);
+  return returnCode(L,
+                    getApi(L).WindowAddTile(getString(L, 1),
+                                            getString(L, 2),
+                                            getString(L, 3),
+                                            getQRectF(L, 4, 5, 6, 7)));
+}
+
 int
 L_WindowArc(lua_State* L)
 {
@@ -2960,6 +3172,200 @@ L_WindowDelete(lua_State* L)
   return returnCode(L, getApi(L).WindowDelete(getString(L, 1)));
 }
 
+// Decodes a WindowDrawBatch command whose n elements are the arguments on the
+// stack. The command name takes the place of the window name, so arguments are
+// read at the same positions as in the corresponding Window* function.
+ApiCode
+getDrawCommand(lua_State* L, int n, std::vector<draw::Command>& commands)
+{
+  const string_view name = getString(L, 1);
+  if (name == "RectOp") {
+    const optional<RectOp> action = getEnum<RectOp>(L, 2);
+    const QRectF rect = getQRectF(L, 3, 4, 5, 6);
+    if (!action) [[unlikely]] {
+      return ApiCode::UnknownOption;
+    }
+    switch (*action) {
+      case RectOp::Frame:
+        commands.emplace_back(draw::Rect{ rect, getQColor(L, 7), {} });
+        return ApiCode::OK;
+      case RectOp::Fill:
+        commands.emplace_back(draw::Rect{ rect, QPen(), getQColor(L, 7) });
+        return ApiCode::OK;
+      case RectOp::Invert:
+        commands.emplace_back(draw::Invert{ rect.toRect() });
+        return ApiCode::OK;
+      case RectOp::Frame3D:
+        commands.emplace_back(
+          draw::Frame{ rect,
+                       getQColor(L, 7),
+                       getQColor(L, 8, Qt::GlobalColor::black) });
+        return ApiCode::OK;
+      case RectOp::Edge3D:
+        if (optional<ButtonFrame> frame = getEnum<ButtonFrame>(L, 7)) {
+          commands.emplace_back(draw::Button{
+            rect.toRect(),
+            *frame,
+            getQFlags<MiniWindow::ButtonFlag>(L, 8) });
+          return ApiCode::OK;
+        }
+        return ApiCode::BadParameter;
+      case RectOp::FloodFillBorder:
+      case RectOp::FloodFillSurface:
+        return ApiCode::OK;
+    }
+  }
+  if (name == "CircleOp") {
+    const optional<CircleOp> action = getEnum<CircleOp>(L, 2);
+    const QRectF rect = getQRectF(L, 3, 4, 5, 6);
+    const lua_Number xRadius = getNumber(L, 12, 0.0);
+    const lua_Number yRadius = getNumber(L, 13, 0.0);
+    const optional<QPen> pen = getQPen(L, 7, 8, 9);
+    const optional<QBrush> brush =
+      getQBrush(L, 10, 11, Qt::BrushStyle::SolidPattern);
+    if (!action) [[unlikely]] {
+      return ApiCode::UnknownOption;
+    }
+    if (!pen) [[unlikely]] {
+      return ApiCode::PenStyleNotValid;
+    }
+    if (!brush) [[unlikely]] {
+      return ApiCode::BrushStyleNotValid;
+    }
+    switch (*action) {
+      case CircleOp::Ellipse:
+        commands.emplace_back(draw::Ellipse{ rect, *pen, *brush });
+        return ApiCode::OK;
+      case CircleOp::Rectangle:
+        commands.emplace_back(draw::Rect{ rect, *pen, *brush });
+        return ApiCode::OK;
+      case CircleOp::RoundedRectangle:
+        commands.emplace_back(
+          draw::RoundedRect{ rect, xRadius, yRadius, *pen, *brush });
+        return ApiCode::OK;
+      case CircleOp::Chord:
+      case CircleOp::Pie:
+        return ApiCode::OK;
+    }
+  }
+  if (name == "Line") {
+    const QLineF line = getQLineF(L, 2, 3, 4, 5);
+    const optional<QPen> pen = getQPen(L, 6, 7, 8);
+    if (!pen) [[unlikely]] {
+      return ApiCode::PenStyleNotValid;
+    }
+    commands.emplace_back(draw::Line{ line, *pen });
+    return ApiCode::OK;
+  }
+  if (name == "Gradient") {
+    const QRectF rect = getQRectF(L, 2, 3, 4, 5);
+    const QColor color1 = getQColor(L, 6);
+    const QColor color2 = getQColor(L, 7);
+    const optional<Qt::Orientation> mode =
+      getEnum<Qt::Orientation>(L, 8);
+    if (!mode) [[unlikely]] {
+      return ApiCode::UnknownOption;
+    }
+    commands.emplace_back(draw::Gradient{ rect, color1, color2, *mode });
+    return ApiCode::OK;
+  }
+  if (name == "DrawImage") {
+    const string_view imageID = getString(L, 2);
+    const QRectF rect = getQRectF(L, 3, 4, 5, 6);
+    const optional<DrawImageMode> mode =
+      getEnum(L, 7, DrawImageMode::Copy);
+    const QRectF sourceRect =
+      n > 7 ? getQRectF(L, 8, 9, 10, 11) : QRectF();
+    if (!mode) [[unlikely]] {
+      return ApiCode::BadParameter;
+    }
+    commands.emplace_back(
+      draw::Image{ string(imageID), rect, *mode, sourceRect });
+    return ApiCode::OK;
+  }
+  if (name == "Text") {
+    const string_view fontID = getString(L, 2);
+    const string_view text = getString(L, 3);
+    const QRectF rect = getQRectF(L, 4, 5, 6, 7);
+    const QColor color = getQColor(L, 8);
+    const bool unicode = getBool(L, 9, false);
+    commands.emplace_back(
+      draw::Text{ string(fontID), string(text), rect, color, unicode });
+    return ApiCode::OK;
+  }
+  return ApiCode::UnknownOption;
+}
+
+int
+L_decodeDrawCommand(lua_State* L)
+{
+  auto& commands = *static_cast<std::vector<draw::Command>*>(
+    lua_touserdata(L, lua_upvalueindex(1)));
+  push(L, getDrawCommand(L, lua_gettop(L), commands));
+  return 1;
+}
+
+// Decodes the commands in the table at index 2 and draws them. Each command is
+// decoded in a protected call, so that argument errors unwind to here instead
+// of past the vector. Returns 0 with the result code on top of the stack, or
+// the number of the command that failed with its error on top of the stack.
+lua_Integer
+drawBatch(lua_State* L, string_view windowName)
+{
+  const auto len = static_cast<lua_Integer>(lua_rawlen(L, 2));
+  std::vector<draw::Command> commands;
+  commands.reserve(static_cast<size_t>(len));
+  lua_pushlightuserdata(L, &commands);
+  lua_pushcclosure(L, L_decodeDrawCommand, 1);
+  for (lua_Integer i = 1; i <= len; ++i) {
+    lua_pushvalue(L, 3);
+    if (lua_rawgeti(L, 2, i) != LUA_TTABLE) [[unlikely]] {
+      lua_pushstring(L, "table expected");
+      return i;
+    }
+    const int n = static_cast<int>(lua_rawlen(L, 5));
+    if (!lua_checkstack(L, n)) [[unlikely]] {
+      lua_pushstring(L, "too many arguments");
+      return i;
+    }
+    for (int j = 1; j <= n; ++j) {
+      lua_rawgeti(L, 5, j);
+    }
+    lua_remove(L, 5);
+    if (lua_pcall(L, n, 1, 0) != LUA_OK) [[unlikely]] {
+      return i;
+    }
+    const auto code = static_cast<ApiCode>(lua_tointeger(L, -1));
+    lua_settop(L, 3);
+    if (code != ApiCode::OK) [[unlikely]] {
+      push(L, code);
+      return 0;
+    }
+  }
+  push(L, getApi(L).WindowDrawBatch(windowName, commands));
+  return 0;
+}
+
+int
+L_WindowDrawBatch(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 2);
+  const string_view windowName = getString(L, 1);
+  luaL_checktype(L, 2, LUA_TTABLE);
+  const lua_Integer failed = drawBatch(L, windowName);
+  if (failed == 0) [[likely]] {
+    return 1;
+  }
+  if (lua_type(L, -1) != LUA_TSTRING) [[unlikely]] {
+    return lua_error(L);
+  }
+  // The decoder is anonymous, so its errors name the function '?'.
+  const char* message = luaL_gsub(L, lua_tostring(L, -1), " to '?'", "");
+  return luaL_argerror(
+    L, 2, lua_pushfstring(L, "command %I: %s", failed, message));
+}
+
 int
 L_WindowDrawImage(lua_State* L)
 {
@@ -2993,6 +3399,49 @@ L_WindowDrawImageAlpha(lua_State* L)
     getApi(L).WindowDrawImageAlpha(windowName, imageID, rect, opacity, origin));
 }
 
+int
+L_WindowDrawTiles(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 4);
+  const string_view windowName = getString(L, 1);
+  const string_view imageID = getString(L, 2);
+  luaL_checktype(L, 3, LUA_TTABLE);
+  const lua_Number opacity = getNumber(L, 4, 1.0);
+  if (opacity < 0 || opacity > 1) {
+    return returnCode(L, ApiCode::BadParameter);
+  }
+  lua_settop(L, 4);
+  const auto len = static_cast<lua_Integer>(lua_rawlen(L, 3));
+  // Every tile is checked before the vector is allocated, because raising a
+  // Lua error skips its destructor. Metamethods are ignored, so reading the
+  // tiles again below gives the same values.
+  for (lua_Integer i = 1; i <= len; ++i) {
+    if (lua_rawgeti(L, 3, i) != LUA_TTABLE ||
+        lua_rawgeti(L, 5, 1) != LUA_TSTRING ||
+        lua_rawgeti(L, 5, 2) != LUA_TNUMBER ||
+        lua_rawgeti(L, 5, 3) != LUA_TNUMBER ||
+        !std::isfinite(lua_tonumber(L, 7)) ||
+        !std::isfinite(lua_tonumber(L, 8))) [[unlikely]] {
+      luaL_typeerror(L, 3, "array of {tileID, x, y}"); // exits function
+    }
+    lua_settop(L, 4);
+  }
+  std::vector<draw::Tile> tiles;
+  tiles.reserve(static_cast<size_t>(len));
+  for (lua_Integer i = 1; i <= len; ++i) {
+    lua_rawgeti(L, 3, i);
+    lua_rawgeti(L, 5, 1);
+    lua_rawgeti(L, 5, 2);
+    lua_rawgeti(L, 5, 3);
+    tiles.push_back({ string(lua_tostr(L, 6)),
+                      QPointF(lua_tonumber(L, 7), lua_tonumber(L, 8)) });
+    lua_settop(L, 4);
+  }
+  return returnCode(
+    L, getApi(L).WindowDrawTiles(windowName, imageID, tiles, opacity));
+}
+
 struct FilterParams
 {
   lua_State* L;
@@ -3251,6 +3700,19 @@ L_WindowLoadImage(lua_State* L)
                     getApi(L).WindowLoadImage(windowName, imageID, filename));
 }
 
+int
+L_WindowLoadImageAsync(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 4);
+  return returnCode(L,
+                    getApi(L).WindowLoadImageAsync(getPluginIndex(L),
+                                                   getString(L, 1),
+                                                   getString(L, 2),
+                                                   getQString(L, 3),
+                                                   getString(L, 4, "")));
+}
+
 int
 L_WindowLoadImageMemory(lua_State* L)
 {
@@ -3262,6 +3724,21 @@ L_WindowLoadImageMemory(lua_State* L)
       getString(L, 1), getString(L, 2), getBytes(L, 3), getBool(L, 4, false)));
 }
 
+int
+L_WindowLoadImageMemoryAsync(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 5);
+  return returnCode(
+    L,
+    getApi(L).WindowLoadImageMemoryAsync(getPluginIndex(L),
+                                         getString(L, 1),
+                                         getString(L, 2),
+                                         getBytes(L, 3).toByteArray(),
+                                         getBool(L, 4, false),
+                                         getString(L, 5, "")));
+}
+
 int
 L_WindowMenu(lua_State* L)
 {
@@ -3437,6 +3914,35 @@ L_WindowTextWidth(lua_State* L)
   return 1;
 }
 
+int
+L_WindowTextWidths(lua_State* L)
+{
+  BENCHMARK
+  expectMaxArgs(L, 4);
+  const string_view windowName = getString(L, 1);
+  const string_view fontID = getString(L, 2);
+  const bool unicode = getBool(L, 4, false);
+  luaL_checktype(L, 3, LUA_TTABLE);
+  lua_settop(L, 4);
+  // Raising a Lua error skips C++ destructors, so the result table is created
+  // before the vectors, and filled without allocating.
+  lua_createtable(L, static_cast<int>(lua_rawlen(L, 3)), 0);
+  const std::vector<string_view> texts = getStrings(L, 3);
+  std::vector<qreal> widths;
+  const qreal result =
+    getApi(L).WindowTextWidths(windowName, fontID, texts, unicode, widths);
+  if (result < 0) [[unlikely]] {
+    push(L, result);
+    return 1;
+  }
+  lua_Integer i = 0;
+  for (const qreal width : widths) {
+    push(L, width);
+    lua_rawseti(L, 5, ++i);
+  }
+  return 1;
+}
+
 int
 L_WindowTransformImage(lua_State* L)
 {
@@ -3708,13 +4214,17 @@ static constexpr const struct luaL_Reg worldlib[]{
   { "SetLogInput", L_SetLogInput },
   { "SetLogNotes", L_SetLogNotes },
   { "SetLogOutput", L_SetLogOutput },
+  { "StartRecording", L_StartRecording },
+  { "StopRecording", L_StopRecording },
   { "WriteLog", L_WriteLog },
   // network
   { "Connect", L_Connect },
   { "Disconnect", L_Disconnect },
   { "GetConnectDuration", L_GetConnectDuration },
   { "GetHostAddress", L_GetHostAddress },
+  { "GetHostAddressAsync", L_GetHostAddressAsync },
   { "GetHostName", L_GetHostName },
+  { "GetHostNameAsync", L_GetHostNameAsync },
   { "GetReceivedBytes", L_GetReceivedBytes },
   { "GetSentBytes", L_GetSentBytes },
   { "IsConnected", L_IsConnected },
@@ -3769,13 +4279,16 @@ static constexpr const struct luaL_Reg worldlib[]{
   { "FixupHTML", L_FixupHTML },
   { "GetEchoInput", L_GetEchoInput },
   { "GetLineCount", L_GetLineCount },
+  { "GetLines", L_GetLines },
   { "GetLinesInBufferCount", L_GetLinesInBufferCount },
   { "GetMainWindowPosition", L_GetMainWindowPosition },
   { "GetRecentLines", L_GetRecentLines },
   { "GetWorldWindowPosition", L_GetWorldWindowPosition },
+  { "Lines", L_Lines },
   { "OpenBrowser", L_OpenBrowser },
   { "Pause", L_Pause },
   { "Reset", L_Reset },
+  { "SearchOutput", L_SearchOutput },
   { "SetBackgroundImage", L_SetBackgroundImage },
   { "SetCursor", L_SetCursor },
   { "SetEchoInput", L_SetEchoInput },
@@ -3865,6 +4378,7 @@ static constexpr const struct luaL_Reg worldlib[]{
   // window
   { "BlendPixel", L_BlendPixel },
   { "FilterPixel", L_FilterPixel },
+  { "WindowAddTile", L_WindowAddTile },
   { "WindowArc", L_WindowArc },
   { "WindowBezier", L_WindowBezier },
   { "WindowBlendImage", L_WindowBlendImage },
@@ -3872,8 +4386,10 @@ static constexpr const struct luaL_Reg worldlib[]{
   { "WindowCreate", L_WindowCreate },
   { "WindowCreateImage", L_WindowCreateImage },
   { "WindowDelete", L_WindowDelete },
+  { "WindowDrawBatch", L_WindowDrawBatch },
   { "WindowDrawImage", L_WindowDrawImage },
   { "WindowDrawImageAlpha", L_WindowDrawImageAlpha },
+  { "WindowDrawTiles", L_WindowDrawTiles },
   { "WindowFilter", L_WindowFilter },
   { "WindowFont", L_WindowFont },
   { "WindowFontList", L_WindowFontList },
@@ -3887,7 +4403,9 @@ static constexpr const struct luaL_Reg worldlib[]{
   { "WindowImageOp", L_WindowImageOp },
   { "WindowList", L_WindowList },
   { "WindowLoadImage", L_WindowLoadImage },
+  { "WindowLoadImageAsync", L_WindowLoadImageAsync },
   { "WindowLoadImageMemory", L_WindowLoadImageMemory },
+  { "WindowLoadImageMemoryAsync", L_WindowLoadImageMemoryAsync },
   { "WindowMenu", L_WindowMenu },
   { "WindowPolygon", L_WindowPolygon },
   { "WindowPosition", L_WindowPosition },
@@ -3898,6 +4416,7 @@ static constexpr const struct luaL_Reg worldlib[]{
   { "WindowShow", L_WindowShow },
   { "WindowText", L_WindowText },
   { "WindowTextWidth", L_WindowTextWidth },
+  { "WindowTextWidths", L_WindowTextWidths },
   { "WindowTransformImage", L_WindowTransformImage },
   { "Windowrite", L_WindowWrite },
   // window hotspot
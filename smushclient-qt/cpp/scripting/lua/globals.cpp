@@ -244,6 +244,7 @@ static const TableEntry miniwin[]{
   { "create_transparent", MiniWindow::Flag::Transparent },
   { "create_ignore_mouse", MiniWindow::Flag::IgnoreMouse },
   { "create_keep_hotspots", MiniWindow::Flag::KeepHotspots },
+  { "create_retained", MiniWindow::Flag::Retained },
 
   { "pen_solid", ScriptPen::Style::SolidLine },
   { "pen_dash", ScriptPen::Style::DashLine },
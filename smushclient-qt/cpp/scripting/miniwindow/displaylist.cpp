@@ -0,0 +1,73 @@
+#include "displaylist.h"
+#include <algorithm>
+#include <iterator>
+
+// Public methods
+
+void
+DisplayList::append(const QRect& bounds, QByteArray&& key, Paint&& paint)
+{
+  if (bounds.isEmpty()) {
+    return;
+  }
+  items.push_back({ bounds, std::move(key), std::move(paint) });
+}
+
+QRegion
+DisplayList::bounds() const
+{
+  QRegion region;
+  for (const Item& item : items) {
+    region += item.bounds;
+  }
+  return region;
+}
+
+QRegion
+DisplayList::diff(const DisplayList& previous) const
+{
+  QRegion region;
+  const size_t common = std::min(items.size(), previous.items.size());
+  for (size_t i = 0; i < common; ++i) {
+    const Item& item = items[i];
+    const Item& oldItem = previous.items[i];
+    if (item.bounds == oldItem.bounds && item.key == oldItem.key) {
+      continue;
+    }
+    region += item.bounds;
+    region += oldItem.bounds;
+  }
+  for (size_t i = common, end = items.size(); i < end; ++i) {
+    region += items[i].bounds;
+  }
+  for (size_t i = common, end = previous.items.size(); i < end; ++i) {
+    region += previous.items[i].bounds;
+  }
+  return region;
+}
+
+void
+DisplayList::extend(DisplayList&& other)
+{
+  if (items.empty()) {
+    items.swap(other.items);
+    return;
+  }
+  items.insert(items.end(),
+               std::make_move_iterator(other.items.begin()),
+               std::make_move_iterator(other.items.end()));
+  other.items.clear();
+}
+
+void
+DisplayList::paint(QPainter& painter, const QRegion& region) const
+{
+  for (const Item& item : items) {
+    if (!region.intersects(item.bounds)) {
+      continue;
+    }
+    painter.save();
+    item.paint(painter);
+    painter.restore();
+  }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <QtCore/QDataStream>
+#include <QtGui/QPainter>
+#include <QtGui/QRegion>
+#include <functional>
+#include <vector>
+
+// Primitives recorded by a miniwindow in retained mode. Each item keeps the
+// bounds it can touch, a key that identifies everything that affects its
+// output, and a function that draws it.
+class DisplayList
+{
+public:
+  using Paint = std::function<void(QPainter& painter)>;
+
+  enum class Primitive : quint8
+  {
+    Arc,
+    Button,
+    Ellipse,
+    Frame,
+    Gradient,
+    Image,
+    Line,
+    Path,
+    Polygon,
+    Polyline,
+    Rect,
+    RoundedRect,
+    Text,
+    Tiles,
+    TransformedImage,
+  };
+
+  // Serializes a primitive and its arguments into an item key.
+  template<typename... Args>
+  static QByteArray key(Primitive primitive, const Args&... args)
+  {
+    QByteArray key;
+    QDataStream stream(&key, QIODevice::WriteOnly);
+    stream << static_cast<quint8>(primitive);
+    (stream << ... << args);
+    return key;
+  }
+
+  void append(const QRect& bounds, QByteArray&& key, Paint&& paint);
+  // Returns the union of the bounds of every item.
+  QRegion bounds() const;
+  void clear() noexcept { items.clear(); }
+  // Returns the area that must be redrawn to turn the output of a previous
+  // list into the output of this one. Items are compared by position in the
+  // list, so inserting or removing an item dirties everything after it.
+  QRegion diff(const DisplayList& previous) const;
+  bool empty() const noexcept { return items.empty(); }
+  // Moves the items of another list onto the end of this one.
+  void extend(DisplayList&& other);
+  // Replays every item that intersects a region. The painter should already
+  // be clipped to the region.
+  void paint(QPainter& painter, const QRegion& region) const;
+  size_t size() const noexcept { return items.size(); }
+  void swap(DisplayList& other) noexcept { items.swap(other.items); }
+
+private:
+  struct Item
+  {
+    QRect bounds;
+    QByteArray key;
+    Paint paint;
+  };
+
+  std::vector<Item> items;
+};
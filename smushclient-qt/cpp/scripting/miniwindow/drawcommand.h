@@ -0,0 +1,103 @@
+#pragma once
+#include "../scriptenums.h"
+#include "miniwindow.h"
+#include <QtGui/QBrush>
+#include <QtGui/QPen>
+#include <string>
+#include <variant>
+
+// Decoded miniwindow drawing operations, for submitting many primitives to a
+// window at once. Each command mirrors the arguments of a Window* function.
+namespace draw {
+struct Button
+{
+  QRect rect;
+  ButtonFrame frame;
+  MiniWindow::ButtonFlags flags;
+};
+
+struct Ellipse
+{
+  QRectF rect;
+  QPen pen;
+  QBrush brush;
+};
+
+struct Frame
+{
+  QRectF rect;
+  QColor color1;
+  QColor color2;
+};
+
+struct Gradient
+{
+  QRectF rect;
+  QColor color1;
+  QColor color2;
+  Qt::Orientation direction;
+};
+
+struct Image
+{
+  std::string imageID;
+  QRectF rect;
+  DrawImageMode mode;
+  QRectF sourceRect;
+};
+
+struct Invert
+{
+  QRect rect;
+};
+
+struct Line
+{
+  QLineF line;
+  QPen pen;
+};
+
+struct Rect
+{
+  QRectF rect;
+  QPen pen;
+  QBrush brush;
+};
+
+struct RoundedRect
+{
+  QRectF rect;
+  qreal xRadius;
+  qreal yRadius;
+  QPen pen;
+  QBrush brush;
+};
+
+struct Text
+{
+  std::string fontID;
+  std::string text;
+  QRectF rect;
+  QColor color;
+  bool unicode;
+};
+
+// A named tile of an image, drawn by WindowDrawTiles rather than as a
+// Command, since every tile in a call comes from the same image.
+struct Tile
+{
+  std::string tileID;
+  QPointF position;
+};
+
+using Command = std::variant<Button,
+                             Ellipse,
+                             Frame,
+                             Gradient,
+                             Image,
+                             Invert,
+                             Line,
+                             Rect,
+                             RoundedRect,
+                             Text>;
+} // namespace draw
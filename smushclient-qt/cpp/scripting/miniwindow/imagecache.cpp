@@ -0,0 +1,219 @@
+#include "imagecache.h"
+#include "../../image.h"
+#include "../../settings.h"
+#include "imagefilters.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+#include <QtCore/QFuture>
+#include <QtCore/QPromise>
+#include <QtCore/QThreadPool>
+#include <QtCore/QTimer>
+
+using Qt::StringLiterals::operator""_L1;
+
+// Private utils
+
+namespace {
+constexpr qsizetype bytesPerMegabyte = 1024 * 1024;
+
+qsizetype
+imageBytes(const QPixmap& image)
+{
+  return static_cast<qsizetype>(image.width()) * image.height() *
+         image.depth() / 8;
+}
+
+QString
+fileKey(const QFileInfo& info)
+{
+  // Including the modification time means an image that is rewritten on disk
+  // is decoded again, while the stale entry ages out of the cache.
+  return "file:%1:%2:%3"_L1.arg(
+    QString::number(info.lastModified().toMSecsSinceEpoch()),
+    QString::number(info.size()),
+    info.canonicalFilePath());
+}
+
+QString
+dataKey(QByteArrayView data, bool swapBlueAndAlpha)
+{
+  return (swapBlueAndAlpha ? "data:swap:"_L1 : "data:"_L1) +
+         QString::fromLatin1(
+           QCryptographicHash::hash(data, QCryptographicHash::Algorithm::Sha1)
+             .toHex());
+}
+
+// QImage, unlike QPixmap, can be decoded outside the GUI thread. Decoded images
+// are normalized here so that the conversion happens off the GUI thread and
+// only once per decode, rather than every time the image is drawn.
+QImage
+decode(QByteArrayView data, bool swapBlueAndAlpha)
+{
+  QImage image = QImage::fromData(data, "PNG");
+  if (image.isNull()) [[unlikely]] {
+    image = QImage::fromData(data);
+    if (image.isNull()) [[unlikely]] {
+      return image;
+    }
+  }
+  if (swapBlueAndAlpha) {
+    ImageFilter::SwapBlueAndAlpha().apply(image);
+  }
+  image::normalize(image);
+  return image;
+}
+
+QImage
+decodeFile(const QString& path)
+{
+  QImage image(path);
+  image::normalize(image);
+  return image;
+}
+} // namespace
+
+// Public static methods
+
+ImageCache&
+ImageCache::global()
+{
+  static ImageCache cache(Settings().getImageCacheSize() * bytesPerMegabyte);
+  // The cache is static, so it outlives the QApplication, but pixmaps must be
+  // released while the application still exists.
+  static const QMetaObject::Connection clearOnQuit =
+    QObject::connect(QCoreApplication::instance(),
+                     &QCoreApplication::aboutToQuit,
+                     [] { cache.clear(); });
+  return cache;
+}
+
+// Public methods
+
+ImageCache::ImageCache(qsizetype maxBytes)
+  : entries(maxBytes)
+{
+}
+
+QPixmap
+ImageCache::load(const QString& filename)
+{
+  const QFileInfo info(filename);
+  if (!info.exists()) {
+    return QPixmap();
+  }
+  const QString key = fileKey(info);
+  if (const QPixmap* cached = find(key)) {
+    return *cached;
+  }
+  return insert(key, QPixmap::fromImage(decodeFile(info.canonicalFilePath())));
+}
+
+void
+ImageCache::loadAsync(const QString& filename,
+                      QObject* context,
+                      Callback&& callback)
+{
+  const QFileInfo info(filename);
+  if (!info.exists()) {
+    QTimer::singleShot(0, context, [callback = std::move(callback)] {
+      callback(QPixmap());
+    });
+    return;
+  }
+  decodeAsync(
+    fileKey(info),
+    [path = info.canonicalFilePath()] { return decodeFile(path); },
+    context,
+    std::move(callback));
+}
+
+QPixmap
+ImageCache::loadFromData(QByteArrayView data, bool swapBlueAndAlpha)
+{
+  const QString key = dataKey(data, swapBlueAndAlpha);
+  if (const QPixmap* cached = find(key)) {
+    return *cached;
+  }
+  return insert(key, QPixmap::fromImage(decode(data, swapBlueAndAlpha)));
+}
+
+void
+ImageCache::loadFromDataAsync(const QByteArray& data,
+                              bool swapBlueAndAlpha,
+                              QObject* context,
+                              Callback&& callback)
+{
+  decodeAsync(
+    dataKey(data, swapBlueAndAlpha),
+    [data, swapBlueAndAlpha] { return decode(data, swapBlueAndAlpha); },
+    context,
+    std::move(callback));
+}
+
+ImageCache::Stats
+ImageCache::stats() const noexcept
+{
+  return {
+    .hits = hits,
+    .misses = misses,
+    .bytes = entries.totalCost(),
+    .images = entries.size(),
+  };
+}
+
+// Private methods
+
+void
+ImageCache::decodeAsync(const QString& key,
+                        std::function<QImage()>&& decode,
+                        QObject* context,
+                        Callback&& callback)
+{
+  if (const QPixmap* cached = find(key)) {
+    QTimer::singleShot(
+      0, context, [image = *cached, callback = std::move(callback)] {
+        callback(image);
+      });
+    return;
+  }
+  auto promise = std::make_shared<QPromise<QImage>>();
+  QFuture<QImage> future = promise->future();
+  QThreadPool::globalInstance()->start(
+    [promise, decode = std::move(decode)] {
+      promise->start();
+      promise->addResult(decode());
+      promise->finish();
+    });
+  // Pixmaps can only be created on the GUI thread, so conversion happens in
+  // the continuation rather than on the worker.
+  future.then(context,
+              [this, key, callback = std::move(callback)](const QImage& image) {
+                callback(insert(key, QPixmap::fromImage(image)));
+              });
+}
+
+const QPixmap*
+ImageCache::find(const QString& key)
+{
+  // QCache::object marks the entry as most recently used.
+  const QPixmap* cached = entries.object(key);
+  if (cached == nullptr) {
+    ++misses;
+    return nullptr;
+  }
+  ++hits;
+  return cached;
+}
+
+QPixmap
+ImageCache::insert(const QString& key, const QPixmap& image)
+{
+  // Windows hold implicitly shared copies, so evicting an entry only releases
+  // the pixel data once no window is using it.
+  if (!image.isNull()) {
+    entries.insert(key, new QPixmap(image), imageBytes(image));
+  }
+  return image;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <QtCore/QCache>
+#include <QtGui/QPixmap>
+#include <functional>
+
+class ImageCache
+{
+public:
+  using Callback = std::function<void(const QPixmap& image)>;
+
+  struct Stats
+  {
+    int64_t hits;
+    int64_t misses;
+    qsizetype bytes;
+    qsizetype images;
+  };
+
+  static ImageCache& global();
+
+  explicit ImageCache(qsizetype maxBytes);
+
+  void clear() { entries.clear(); }
+  // Decodes an image file, or shares a previous decode of it if the file has
+  // not been modified since. Returns a null pixmap if the file cannot be read.
+  QPixmap load(const QString& filename);
+  // Like load, but decodes on a worker thread. The callback is always invoked
+  // asynchronously on context's thread, and is discarded if context is
+  // destroyed first.
+  void loadAsync(const QString& filename, QObject* context, Callback&& callback);
+  // Decodes image data, or shares a previous decode of identical data. Returns
+  // a null pixmap if the data is not a supported image format.
+  QPixmap loadFromData(QByteArrayView data, bool swapBlueAndAlpha);
+  // Like loadFromData, but decodes on a worker thread.
+  void loadFromDataAsync(const QByteArray& data,
+                         bool swapBlueAndAlpha,
+                         QObject* context,
+                         Callback&& callback);
+  qsizetype maxBytes() const noexcept { return entries.maxCost(); }
+  void setMaxBytes(qsizetype maxBytes) { entries.setMaxCost(maxBytes); }
+  Stats stats() const noexcept;
+
+private:
+  void decodeAsync(const QString& key,
+                   std::function<QImage()>&& decode,
+                   QObject* context,
+                   Callback&& callback);
+  const QPixmap* find(const QString& key);
+  QPixmap insert(const QString& key, const QPixmap& image);
+
+private:
+  QCache<QString, QPixmap> entries;
+  int64_t hits = 0;
+  int64_t misses = 0;
+};
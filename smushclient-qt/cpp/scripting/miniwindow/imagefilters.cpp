@@ -17,8 +17,9 @@ ImageFilter::apply(const QPixmap& pixmap) const noexcept
 void
 ImageFilter::PixelFilter::apply(QImage& image) const noexcept
 {
-  image.convertTo(QImage::Format::Format_ARGB32);
+  image::unpremultiply(image);
   apply(image::asPixelsMut(image));
+  image::normalize(image);
 }
 
 QImage
@@ -33,8 +34,9 @@ ImageFilter::PixelFilter::apply(const QPixmap& pixmap) const noexcept
 void
 ImageFilter::ConvolveFilter::apply(QImage& image) const noexcept
 {
-  image.convertTo(QImage::Format::Format_ARGB32);
+  image::unpremultiply(image);
   apply(image::asPixelsMut(image), image.width(), directions);
+  image::normalize(image);
 }
 
 // Protected methods
@@ -4,6 +4,7 @@
 #include "geometry.h"
 #include "hotspot.h"
 #include "imagefilters.h"
+#include <QtCore/QTimer>
 #include <QtGui/QPaintEvent>
 #include <QtGui/QPainter>
 #include <QtWidgets/QFrame>
@@ -13,10 +14,13 @@
 #include <cmath>
 
 using std::string_view;
+using Primitive = DisplayList::Primitive;
 
 // Private utils
 
 namespace {
+constexpr qsizetype transparentImageCacheBytes = 16 * 1024 * 1024;
+
 constexpr std::span<const char>
 trim(const std::string& s) noexcept
 {
@@ -94,6 +98,27 @@ buildMenu(QMenu& menu, string_view text)
   }
   return returnsNumber;
 }
+
+// Returns an area that contains everything a pen can touch when stroking a
+// shape. Joins and antialiasing can reach past half the pen width, so this
+// errs on the side of caution.
+QRectF
+strokeBounds(const QRectF& rect, const QPen& pen)
+{
+  const qreal margin =
+    pen.style() == Qt::PenStyle::NoPen ? 1 : std::max(pen.widthF(), 1.0) + 1;
+  return rect.normalized().adjusted(-margin, -margin, margin, margin);
+}
+
+int64_t
+regionArea(const QRegion& region)
+{
+  int64_t area = 0;
+  for (const QRect& rect : region) {
+    area += static_cast<int64_t>(rect.width()) * rect.height();
+  }
+  return area;
+}
 } // namespace
 
 // Painter
@@ -147,6 +172,7 @@ MiniWindow::MiniWindow(const QPoint& location,
   , location(location)
   , pluginID(pluginID)
   , position(position)
+  , transparentImages(transparentImageCacheBytes)
 {
   setAttribute(Qt::WA_OpaquePaintEvent);
   pixmap.setDevicePixelRatio(devicePixelRatio());
@@ -185,9 +211,24 @@ MiniWindow::addHotspot(string_view hotspotID,
   return hotspot;
 }
 
+bool
+MiniWindow::addTile(string_view imageID,
+                    string_view tileID,
+                    const QRectF& rect)
+{
+  const QPixmap* image = findImage(imageID);
+  if (image == nullptr) {
+    return false;
+  }
+  tiles[imageID][tileID] =
+    geometry::normalize(rect, image->size()) & image->rect().toRectF();
+  return true;
+}
+
 void
 MiniWindow::applyFilter(const ImageFilter& filter, const QRect& rectBase)
 {
+  beginDirectDraw();
   const QRect rect = normalize(rectBase);
   if (rectBase == pixmap.rect()) {
     pixmap.convertFromImage(filter.apply(pixmap));
@@ -198,6 +239,14 @@ MiniWindow::applyFilter(const ImageFilter& filter, const QRect& rectBase)
     .drawImage(rect.topLeft(), filter.apply(section));
 }
 
+void
+MiniWindow::beginBatch()
+{
+  if (batchPainter == nullptr && !flags.testFlag(Flag::Retained)) {
+    batchPainter = std::make_unique<Painter>(this);
+  }
+}
+
 void
 MiniWindow::blendImage(BlendMode mode,
                        const QPixmap& image,
@@ -205,7 +254,7 @@ MiniWindow::blendImage(BlendMode mode,
                        qreal opacity,
                        const QRectF& sourceRectBase)
 {
-
+  beginDirectDraw();
   const QRectF rect = normalize(rectBase);
   QRectF sourceRect = geometry::normalize(sourceRectBase, image.size());
   const QSizeF size = rect.size().boundedTo(sourceRect.size());
@@ -248,8 +297,18 @@ MiniWindow::drawArc(const QRectF& rect,
   if (std::isnan(endArc)) {
     return;
   }
-  Painter(this, pen).drawArc(
-    rect, static_cast<int>(startArc), static_cast<int>(endArc));
+  const int startAngle = static_cast<int>(startArc);
+  const int endAngle = static_cast<int>(endArc);
+  record(
+    strokeBounds(rect, pen),
+    [&] {
+      return DisplayList::key(
+        Primitive::Arc, rect, startAngle, endAngle, pen);
+    },
+    [=](QPainter& painter) {
+      painter.setPen(pen);
+      painter.drawArc(rect, startAngle, endAngle);
+    });
 }
 
 void
@@ -258,53 +317,70 @@ MiniWindow::drawButton(const QRect& rectBase,
                        ButtonFlags buttonFlags)
 {
   const QRect rect = normalize(rectBase);
-  QFrame frame;
-  frame.setFixedSize(rect.size());
-  if (!buttonFlags.testFlag(ButtonFlag::Fill)) {
-    frame.setAttribute(Qt::WA_NoSystemBackground);
-    frame.setAttribute(Qt::WA_TranslucentBackground);
-  }
-  switch (frameType) {
-    case ButtonFrame::Raised:
-      frame.setFrameShape(QFrame::Shape::Panel);
-      frame.setFrameShadow(QFrame::Shadow::Sunken);
-      break;
-    case ButtonFrame::Etched:
-      frame.setFrameShape(QFrame::Shape::Box);
-      frame.setFrameShadow(QFrame::Shadow::Raised);
-      break;
-    case ButtonFrame::Bump:
-      frame.setFrameShape(QFrame::Shape::Box);
-      frame.setFrameShadow(QFrame::Shadow::Sunken);
-      break;
-    case ButtonFrame::Sunken:
-      frame.setFrameShape(QFrame::Shape::Panel);
-      frame.setFrameShadow(QFrame::Shadow::Raised);
-      break;
-  }
-  if (buttonFlags.testAnyFlags(
-        ButtonFlags(ButtonFlag::Flat | ButtonFlag::Monochrome))) {
-    frame.setFrameShadow(QFrame::Shadow::Plain);
-  }
+  record(
+    rect,
+    [&] {
+      return DisplayList::key(Primitive::Button,
+                              rect,
+                              static_cast<int>(frameType),
+                              buttonFlags.toInt());
+    },
+    [=](QPainter& painter) {
+      QFrame frame;
+      frame.setFixedSize(rect.size());
+      if (!buttonFlags.testFlag(ButtonFlag::Fill)) {
+        frame.setAttribute(Qt::WA_NoSystemBackground);
+        frame.setAttribute(Qt::WA_TranslucentBackground);
+      }
+      switch (frameType) {
+        case ButtonFrame::Raised:
+          frame.setFrameShape(QFrame::Shape::Panel);
+          frame.setFrameShadow(QFrame::Shadow::Sunken);
+          break;
+        case ButtonFrame::Etched:
+          frame.setFrameShape(QFrame::Shape::Box);
+          frame.setFrameShadow(QFrame::Shadow::Raised);
+          break;
+        case ButtonFrame::Bump:
+          frame.setFrameShape(QFrame::Shape::Box);
+          frame.setFrameShadow(QFrame::Shadow::Sunken);
+          break;
+        case ButtonFrame::Sunken:
+          frame.setFrameShape(QFrame::Shape::Panel);
+          frame.setFrameShadow(QFrame::Shadow::Raised);
+          break;
+      }
+      if (buttonFlags.testAnyFlags(
+            ButtonFlags(ButtonFlag::Flat | ButtonFlag::Monochrome))) {
+        frame.setFrameShadow(QFrame::Shadow::Plain);
+      }
 
-  if (buttonFlags.testFlag(ButtonFlag::Flat)) {
-    frame.setLineWidth(1);
-  } else if (buttonFlags.testFlag(ButtonFlag::Soft)) {
-    frame.setLineWidth(2);
-  } else {
-    frame.setLineWidth(3);
-  }
+      if (buttonFlags.testFlag(ButtonFlag::Flat)) {
+        frame.setLineWidth(1);
+      } else if (buttonFlags.testFlag(ButtonFlag::Soft)) {
+        frame.setLineWidth(2);
+      } else {
+        frame.setLineWidth(3);
+      }
 
-  Painter painter(this);
-  frame.render(&painter, rect.topLeft());
+      frame.render(&painter, rect.topLeft());
+    });
 }
 
 void
-MiniWindow::drawEllipse(const QRectF& rect,
+MiniWindow::drawEllipse(const QRectF& rectBase,
                         const QPen& pen,
                         const QBrush& brush)
 {
-  Painter(this, pen, brush).drawEllipse(normalize(rect));
+  const QRectF rect = normalize(rectBase);
+  record(
+    strokeBounds(rect, pen),
+    [&] { return DisplayList::key(Primitive::Ellipse, rect, pen, brush); },
+    [=](QPainter& painter) {
+      painter.setPen(pen);
+      painter.setBrush(brush);
+      painter.drawEllipse(rect);
+    });
 }
 
 void
@@ -313,19 +389,27 @@ MiniWindow::drawFrame(const QRectF& rectBase,
                       const QColor& color2)
 {
   const QRectF rect = normalize(rectBase);
-  Painter painter(this);
-  painter.setPen(color1);
-  painter.drawLine(rect.bottomLeft(), rect.topLeft());
-  painter.drawLine(rect.topLeft(), rect.topRight());
-  painter.setPen(color2);
-  painter.drawLine(rect.topRight(), rect.bottomRight());
-  painter.drawLine(rect.bottomRight(), rect.bottomLeft());
+  record(
+    strokeBounds(rect, QPen()),
+    [&] { return DisplayList::key(Primitive::Frame, rect, color1, color2); },
+    [=](QPainter& painter) {
+      painter.setPen(color1);
+      painter.drawLine(rect.bottomLeft(), rect.topLeft());
+      painter.drawLine(rect.topLeft(), rect.topRight());
+      painter.setPen(color2);
+      painter.drawLine(rect.topRight(), rect.bottomRight());
+      painter.drawLine(rect.bottomRight(), rect.bottomLeft());
+    });
 }
 
 void
 MiniWindow::drawGradient(const QRectF& rect, const QGradient& gradient)
 {
-  Painter(this).fillRect(rect, gradient);
+  const QBrush brush(gradient);
+  record(
+    rect,
+    [&] { return DisplayList::key(Primitive::Gradient, rect, brush); },
+    [=](QPainter& painter) { painter.fillRect(rect, brush); });
 }
 
 void
@@ -335,27 +419,51 @@ MiniWindow::drawImage(const QPixmap& image,
                       qreal opacity,
                       DrawImageMode mode)
 {
-  Painter painter(this);
-  if (opacity < 1) {
-    painter.setOpacity(opacity);
-  }
   const QRectF rect = normalize(rectBase);
   const QRectF sourceRect = geometry::normalize(sourceRectBase, image.size());
+  QImage cropped;
+  QRectF bounds;
   switch (mode) {
     case DrawImageMode::Copy:
-      painter.drawPixmap(rect.topLeft(), image, sourceRect);
-      return;
+      bounds = QRectF(rect.topLeft(), sourceRect.size());
+      break;
     case DrawImageMode::Stretch:
-      painter.drawPixmap(rect, image, sourceRect);
-      return;
+      bounds = rect;
+      break;
     case DrawImageMode::CopyTransparent:
       if (sourceRect.isNull()) {
         return;
       }
-      QImage cropped = image::crop(image, sourceRect.toRect());
-      image::colorToAlpha(cropped, image::topLeftPixel(image));
-      Painter(this).drawImage(rect.topLeft(), cropped);
+      cropped = transparentImage(image, sourceRect.toRect());
+      bounds = QRectF(rect.topLeft(), cropped.size());
+      break;
   }
+  record(
+    bounds,
+    [&] {
+      return DisplayList::key(Primitive::Image,
+                              image.cacheKey(),
+                              rect,
+                              sourceRect,
+                              opacity,
+                              static_cast<int>(mode));
+    },
+    [=](QPainter& painter) {
+      if (opacity < 1) {
+        painter.setOpacity(opacity);
+      }
+      switch (mode) {
+        case DrawImageMode::Copy:
+          painter.drawPixmap(rect.topLeft(), image, sourceRect);
+          return;
+        case DrawImageMode::Stretch:
+          painter.drawPixmap(rect, image, sourceRect);
+          return;
+        case DrawImageMode::CopyTransparent:
+          painter.drawImage(rect.topLeft(), cropped);
+          return;
+      }
+    });
 }
 
 void
@@ -364,26 +472,45 @@ MiniWindow::drawImage(const QPixmap& image,
                       qreal opacity,
                       MergeMode mode)
 {
-  Painter painter(this);
-  if (opacity < 1) {
-    painter.setOpacity(opacity);
-  }
-  painter.setTransform(transform);
-  switch (mode) {
-    case MergeMode::Straight:
-      painter.drawPixmap(QPointF(), image);
-      return;
-    case MergeMode::Transparent:
-      QImage masked = image.toImage();
-      image::colorToAlpha(masked, image::topLeftPixel(masked));
-      Painter(this).drawImage(QPointF(), masked);
+  QImage masked;
+  if (mode == MergeMode::Transparent) {
+    masked = transparentImage(image, image.rect());
   }
+  record(
+    transform.mapRect(QRectF(image.rect())),
+    [&] {
+      return DisplayList::key(Primitive::TransformedImage,
+                              image.cacheKey(),
+                              transform,
+                              opacity,
+                              static_cast<int>(mode));
+    },
+    [=](QPainter& painter) {
+      if (opacity < 1) {
+        painter.setOpacity(opacity);
+      }
+      painter.setTransform(transform);
+      switch (mode) {
+        case MergeMode::Straight:
+          painter.drawPixmap(QPointF(), image);
+          return;
+        case MergeMode::Transparent:
+          painter.drawImage(QPointF(), masked);
+          return;
+      }
+    });
 }
 
 void
 MiniWindow::drawLine(const QLineF& line, const QPen& pen)
 {
-  Painter(this, pen).drawLine(line);
+  record(
+    strokeBounds(QRectF(line.p1(), line.p2()), pen),
+    [&] { return DisplayList::key(Primitive::Line, line, pen); },
+    [=](QPainter& painter) {
+      painter.setPen(pen);
+      painter.drawLine(line);
+    });
 }
 
 void
@@ -391,7 +518,14 @@ MiniWindow::drawPath(const QPainterPath& path,
                      const QPen& pen,
                      const QBrush& brush)
 {
-  Painter(this, pen, brush).drawPath(path);
+  record(
+    strokeBounds(path.controlPointRect(), pen),
+    [&] { return DisplayList::key(Primitive::Path, path, pen, brush); },
+    [=](QPainter& painter) {
+      painter.setPen(pen);
+      painter.setBrush(brush);
+      painter.drawPath(path);
+    });
 }
 
 void
@@ -400,42 +534,136 @@ MiniWindow::drawPolygon(const QPolygonF& polygon,
                         const QBrush& brush,
                         Qt::FillRule fillRule)
 {
-  Painter(this, pen, brush).drawPolygon(polygon, fillRule);
+  record(
+    strokeBounds(polygon.boundingRect(), pen),
+    [&] {
+      return DisplayList::key(Primitive::Polygon,
+                              polygon,
+                              pen,
+                              brush,
+                              static_cast<int>(fillRule));
+    },
+    [=](QPainter& painter) {
+      painter.setPen(pen);
+      painter.setBrush(brush);
+      painter.drawPolygon(polygon, fillRule);
+    });
 }
 
 void
 MiniWindow::drawPolyline(const QPolygonF& polygon, const QPen& pen)
 {
-  Painter(this, pen).drawPolyline(polygon);
+  record(
+    strokeBounds(polygon.boundingRect(), pen),
+    [&] { return DisplayList::key(Primitive::Polyline, polygon, pen); },
+    [=](QPainter& painter) {
+      painter.setPen(pen);
+      painter.drawPolyline(polygon);
+    });
 }
 
 void
-MiniWindow::drawRect(const QRectF& rect, const QPen& pen, const QBrush& brush)
+MiniWindow::drawRect(const QRectF& rectBase,
+                     const QPen& pen,
+                     const QBrush& brush)
 {
-  Painter(this, pen, brush).drawRect(normalize(rect));
+  const QRectF rect = normalize(rectBase);
+  record(
+    strokeBounds(rect, pen),
+    [&] { return DisplayList::key(Primitive::Rect, rect, pen, brush); },
+    [=](QPainter& painter) {
+      painter.setPen(pen);
+      painter.setBrush(brush);
+      painter.drawRect(rect);
+    });
 }
 
 void
-MiniWindow::drawRoundedRect(const QRectF& rect,
+MiniWindow::drawRoundedRect(const QRectF& rectBase,
                             qreal xRadius,
                             qreal yRadius,
                             const QPen& pen,
                             const QBrush& brush)
 {
-  Painter(this, pen, brush).drawRoundedRect(normalize(rect), xRadius, yRadius);
+  const QRectF rect = normalize(rectBase);
+  record(
+    strokeBounds(rect, pen),
+    [&] {
+      return DisplayList::key(
+        Primitive::RoundedRect, rect, xRadius, yRadius, pen, brush);
+    },
+    [=](QPainter& painter) {
+      painter.setPen(pen);
+      painter.setBrush(brush);
+      painter.drawRoundedRect(rect, xRadius, yRadius);
+    });
 }
 
-QRectF
-MiniWindow::drawText(const QFont& font,
-                     const QString& text,
+void
+MiniWindow::drawText(const TextCache::Entry& text,
                      const QRectF& rect,
                      const QColor& color)
 {
-  Painter painter(this, color);
-  painter.setFont(font);
-  QRectF boundingRect;
-  painter.drawText(normalize(rect), 0, text, &boundingRect);
-  return boundingRect;
+  const QRectF bounds = normalize(rect);
+  record(
+    bounds,
+    [&] {
+      return DisplayList::key(
+        Primitive::Text, bounds, color, text.font.key(), text.text.text());
+    },
+    [bounds,
+     color,
+     font = text.font,
+     staticText = text.text,
+     multiline = text.multiline](QPainter& painter) {
+      painter.setPen(color);
+      painter.setFont(font);
+      if (multiline) {
+        painter.drawText(bounds, 0, staticText.text());
+        return;
+      }
+      painter.setClipRect(bounds, Qt::ClipOperation::IntersectClip);
+      painter.drawStaticText(bounds.topLeft(), staticText);
+    });
+}
+
+void
+MiniWindow::drawTiles(const QPixmap& image,
+                      std::span<const QPainter::PixmapFragment> fragments)
+{
+  if (fragments.empty()) {
+    return;
+  }
+  // Fragments are positioned by their centers.
+  QRectF bounds;
+  for (const QPainter::PixmapFragment& fragment : fragments) {
+    bounds |= QRectF(fragment.x - fragment.width / 2,
+                     fragment.y - fragment.height / 2,
+                     fragment.width,
+                     fragment.height);
+  }
+  record(
+    bounds,
+    [&] {
+      // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+      // SAFETY: PixmapFragment is a plain struct of qreals
+      const QByteArray data = QByteArray::fromRawData(
+        reinterpret_cast<const char*>(fragments.data()),
+        static_cast<qsizetype>(fragments.size_bytes()));
+      // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+      return DisplayList::key(Primitive::Tiles, image.cacheKey(), data);
+    },
+    [image, fragments = std::vector(fragments.begin(), fragments.end())](
+      QPainter& painter) {
+      painter.drawPixmapFragments(
+        fragments.data(), static_cast<int>(fragments.size()), image);
+    });
+}
+
+void
+MiniWindow::endBatch()
+{
+  batchPainter.reset();
 }
 
 QString
@@ -502,6 +730,68 @@ MiniWindow::findImage(string_view imageID) const noexcept
   return &search->second;
 }
 
+const TextCache::Entry*
+MiniWindow::findText(string_view fontID, string_view text, bool unicode)
+{
+  const QFont* font = findFont(fontID);
+  if (font == nullptr) {
+    return nullptr;
+  }
+  return &texts.get(fontID, *font, text, unicode);
+}
+
+const string_map<QRectF>*
+MiniWindow::findTiles(string_view imageID) const noexcept
+{
+  auto search = tiles.find(imageID);
+  if (search == tiles.end()) {
+    return nullptr;
+  }
+  return &search->second;
+}
+
+void
+MiniWindow::flushFrame()
+{
+  if (pendingFrame.empty()) {
+    return;
+  }
+  const QRect pixmapRect(QPoint(), pixmap.deviceIndependentSize().toSize());
+  QRegion region;
+  QPainter painter(&pixmap);
+  if (frameFlushed) {
+    // Part of this batch has already been drawn, so draw the rest on top.
+    region = pendingFrame.bounds() & pixmapRect;
+    painter.setClipRegion(region);
+    pendingFrame.paint(painter, region);
+    lastFrame.extend(std::move(pendingFrame));
+  } else {
+    region = pixmapDetached ? QRegion(pixmapRect)
+                            : pendingFrame.diff(lastFrame) & pixmapRect;
+    painter.setClipRegion(region);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(pixmapRect, background);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    pendingFrame.paint(painter, region);
+    lastFrame.swap(pendingFrame);
+    lastFrameArea = 0;
+    frameFlushed = true;
+    pixmapDetached = false;
+  }
+  painter.end();
+  pendingFrame.clear();
+  if (region.isEmpty()) {
+    return;
+  }
+  lastFrameArea += regionArea(region);
+  updateMask();
+  if (position == Position::Tile) [[unlikely]] {
+    update();
+  } else {
+    update(region);
+  }
+}
+
 std::vector<string_view>
 MiniWindow::fontList() const noexcept
 {
@@ -523,6 +813,7 @@ MiniWindow::imageList() const noexcept
 void
 MiniWindow::invert(const QRect& rectBase, QImage::InvertMode mode)
 {
+  beginDirectDraw();
   const QRect rect = normalize(rectBase);
   QImage image = image::crop(pixmap, rect);
   image.invertPixels(mode);
@@ -532,18 +823,25 @@ MiniWindow::invert(const QRect& rectBase, QImage::InvertMode mode)
 const QFont&
 MiniWindow::loadFont(string_view fontID, const QFont& font)
 {
+  texts.clear();
   return fonts.emplace(fontID, font).first->second;
 }
 
 const QPixmap&
 MiniWindow::loadImage(string_view imageID, QPixmap&& image)
 {
-  return images.emplace(imageID, std::move(image)).first->second;
+  reservedImages.erase(imageID);
+  QPixmap& entry = images[imageID];
+  entry = std::move(image);
+  return entry;
 }
 const QPixmap&
 MiniWindow::loadImage(string_view imageID, const QPixmap& image)
 {
-  return images.emplace(imageID, image).first->second;
+  reservedImages.erase(imageID);
+  QPixmap& entry = images[imageID];
+  entry = image;
+  return entry;
 }
 
 bool
@@ -560,23 +858,52 @@ MiniWindow::mergeImageAlpha(const QPixmap& image,
     return false;
   }
   sourceRectN.setSize(targetRectN.size());
-  QImage cropped = image::crop(image, targetRectN);
-  if (mode == MergeMode::Transparent) {
-    image::colorToAlpha(cropped, image::topLeftPixel(image));
-  }
+  QImage cropped = mode == MergeMode::Transparent
+                     ? transparentImage(image, targetRectN)
+                     : image::crop(image, targetRectN);
   QImage maskImage = image::crop(mask, sourceRectN);
   if (!image::mask(cropped, maskImage, opacity)) {
     return false;
   }
+  beginDirectDraw();
   Painter painter(this);
   painter.setOpacity(opacity);
   painter.drawImage(targetRect.topLeft(), cropped);
   return true;
 }
 
+uint64_t
+MiniWindow::reserveImage(string_view imageID)
+{
+  images.erase(imageID);
+  const uint64_t reservation = ++lastReservation;
+  reservedImages[imageID] = reservation;
+  return reservation;
+}
+
+bool
+MiniWindow::installReservedImage(string_view imageID,
+                                 uint64_t reservation,
+                                 const QPixmap& image)
+{
+  auto search = reservedImages.find(imageID);
+  if (search == reservedImages.end() || search->second != reservation) {
+    return false;
+  }
+  reservedImages.erase(search);
+  if (image.isNull()) {
+    return false;
+  }
+  images[imageID] = image;
+  return true;
+}
+
 void
 MiniWindow::reset()
 {
+  // Images are kept when a window is recreated, but loads that were started
+  // before then are not installed.
+  reservedImages.clear();
   if (!flags.testFlag(Flag::KeepHotspots)) {
     clearHotspots();
   }
@@ -588,6 +915,7 @@ MiniWindow::setPixel(const QPoint& location, const QColor& color)
   if (!pixmap.rect().contains(location)) {
     return false;
   }
+  beginDirectDraw();
   QImage image = pixmap.toImage();
   const QColor oldColor = image.pixelColor(location);
   image.setPixelColor(location, color);
@@ -603,6 +931,11 @@ MiniWindow::setPixel(const QPoint& location, const QColor& color)
 void
 MiniWindow::setPosition(const QPoint& loc, Position pos, Flags newFlags)
 {
+  if (flags.testFlag(Flag::Retained) != newFlags.testFlag(Flag::Retained)) {
+    flushFrame();
+    lastFrame.clear();
+    pixmapDetached = true;
+  }
   location = loc;
   position = pos;
   flags = newFlags;
@@ -631,13 +964,16 @@ MiniWindow::setZOrder(int64_t order)
 bool
 MiniWindow::unloadFont(string_view fontID)
 {
+  texts.clear();
   return fonts.erase(fontID) != 0;
 }
 
 bool
 MiniWindow::unloadImage(string_view imageID)
 {
-  return fonts.erase(imageID) != 0;
+  reservedImages.erase(imageID);
+  tiles.erase(imageID);
+  return images.erase(imageID) != 0;
 }
 
 void
@@ -649,11 +985,13 @@ MiniWindow::updatePosition()
 
   const QSize newSize = geometry.size() * devicePixelRatio();
   if (pixmap.size() != newSize) {
-    QPixmap newPixmap(newSize);
+    QPixmap newPixmap = image::normalizedPixmap(newSize);
     newPixmap.setDevicePixelRatio(devicePixelRatio());
     newPixmap.fill(background);
     QPainter(&newPixmap).drawPixmap(QPointF(), pixmap);
     pixmap.swap(newPixmap);
+    // Recorded primitives may have been clipped by the old size.
+    pixmapDetached = true;
   }
 
   setGeometry(geometry);
@@ -694,6 +1032,30 @@ MiniWindow::applyFlags()
   }
 }
 
+void
+MiniWindow::beginDirectDraw()
+{
+  batchPainter.reset();
+  if (!flags.testFlag(Flag::Retained)) {
+    return;
+  }
+  flushFrame();
+  if (!frameFlushed) {
+    lastFrame.clear();
+    frameFlushed = true;
+    scheduleCommit();
+  }
+  pixmapDetached = true;
+}
+
+void
+MiniWindow::commitFrame()
+{
+  flushFrame();
+  frameFlushed = false;
+  frameScheduled = false;
+}
+
 QRect
 MiniWindow::normalize(const QRect& rect) const noexcept
 {
@@ -706,6 +1068,42 @@ MiniWindow::normalize(const QRectF& rect) const noexcept
   return geometry::normalize(rect, pixmap.size());
 }
 
+void
+MiniWindow::retain(const QRectF& bounds,
+                   QByteArray&& key,
+                   DisplayList::Paint&& paint)
+{
+  pendingFrame.append(bounds.toAlignedRect(), std::move(key), std::move(paint));
+  scheduleCommit();
+}
+
+void
+MiniWindow::scheduleCommit()
+{
+  if (frameScheduled) {
+    return;
+  }
+  frameScheduled = true;
+  QTimer::singleShot(0, this, &MiniWindow::commitFrame);
+}
+
+QImage
+MiniWindow::transparentImage(const QPixmap& image, const QRect& sourceRect)
+{
+  // Pixmaps get a new cache key whenever they are modified, so entries for
+  // replaced or unloaded images are never hit again and simply age out.
+  const QByteArray key =
+    DisplayList::key(Primitive::Image, image.cacheKey(), sourceRect);
+  if (const QImage* cached = transparentImages.object(key)) {
+    return *cached;
+  }
+  QImage cropped = image::crop(image, sourceRect);
+  image::colorToAlpha(cropped, image::topLeftPixel(image));
+  transparentImages.insert(
+    key, new QImage(cropped), std::max<qsizetype>(cropped.sizeInBytes(), 1));
+  return cropped;
+}
+
 void
 MiniWindow::updateMask()
 {
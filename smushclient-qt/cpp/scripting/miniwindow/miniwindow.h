@@ -2,9 +2,13 @@
 #include "../../enumbounds.h"
 #include "../scriptenums.h"
 #include "../stringmap.h"
+#include "displaylist.h"
 #include "hotspot.h"
+#include "textcache.h"
+#include <QtCore/QCache>
 #include <QtCore/QDateTime>
 #include <QtGui/QPainter>
+#include <span>
 
 class ImageFilter;
 class Plugin;
@@ -43,6 +47,14 @@ public:
     // Keep existing hotspots. If set, hotspots are not deleted if you are
     // recreating an existing miniwindow.
     KeepHotspots = 16,
+    // Retained. If set, drawing operations are recorded rather than applied
+    // immediately, and each batch of drawing is treated as a complete redraw
+    // of the window. Once control returns to the event loop, the batch is
+    // compared with the previous one, and only the areas that changed are
+    // rasterized. Operations that work on existing pixels, such as filters and
+    // blending, are applied directly and cause the next batch to redraw the
+    // whole window.
+    Retained = 0x100,
   };
   Q_DECLARE_FLAGS(Flags, Flag)
 
@@ -84,7 +96,16 @@ public:
                       WorldTab& tab,
                       const Plugin& plugin,
                       Hotspot::Callbacks&& callbacks);
+  // Names part of a loaded image, so that it can be drawn with drawTiles.
+  // Tiles are kept if the image is replaced, and dropped if it is unloaded.
+  bool addTile(std::string_view imageID,
+               std::string_view tileID,
+               const QRectF& rect);
   void applyFilter(const ImageFilter& filter, const QRect& rect = {});
+  // Draws every primitive until the next call to endBatch() with the same
+  // painter, and repaints the window once at the end. Operations that work on
+  // existing pixels end the batch early.
+  void beginBatch();
   void blendImage(BlendMode mode,
                   const QPixmap& image,
                   const QRectF& rect,
@@ -179,21 +200,37 @@ public:
   {
     drawRoundedRect(rect, xRadius, yRadius, Qt::PenStyle::NoPen, brush);
   }
-  QRectF drawText(const QFont& font,
-                  const QString& text,
-                  const QRectF& rect,
-                  const QColor& color);
+  void drawText(const TextCache::Entry& text,
+                const QRectF& rect,
+                const QColor& color);
+  // Draws many parts of the same image in a single pass.
+  void drawTiles(const QPixmap& image,
+                 std::span<const QPainter::PixmapFragment> fragments);
   bool drawsUnderneath() const noexcept
   {
     return flags.testFlag(Flag::DrawUnderneath);
   }
+  void endBatch();
   QString execMenu(const QPoint& location, std::string_view menuString);
   const QFont* findFont(std::string_view fontID) const noexcept;
   Hotspot* findHotspot(std::string_view hotspotID) const noexcept;
+  // Draws any primitives that have been recorded in retained mode but not yet
+  // drawn.
+  void flushFrame();
   const QPixmap* findImage(std::string_view imageID) const noexcept;
+  // Returns text shaped in a loaded font, or nullptr if no such font is
+  // loaded. The result is only valid until the next call.
+  const TextCache::Entry* findText(std::string_view fontID,
+                                   std::string_view text,
+                                   bool unicode);
+  const string_map<QRectF>* findTiles(std::string_view imageID) const noexcept;
   std::vector<std::string_view> fontList() const noexcept;
   const std::string& getPluginId() const noexcept { return pluginID; }
-  const QPixmap& getPixmap() const noexcept { return pixmap; }
+  const QPixmap& getPixmap()
+  {
+    flushFrame();
+    return pixmap;
+  }
   int64_t getZOrder() const noexcept { return zOrder; }
   std::vector<std::string_view> hotspotList() const noexcept;
   std::vector<std::string_view> imageList() const noexcept;
@@ -232,6 +269,14 @@ public:
   {
     return mergeImageAlpha(image, mask, targetRect, sourceRect, 1, mode);
   }
+  // Reserves an image ID for an asynchronous load. Until the load completes,
+  // the ID behaves as if no image is installed.
+  uint64_t reserveImage(std::string_view imageID);
+  // Installs an image for a reservation, unless the ID has since been reserved
+  // again, loaded or unloaded.
+  bool installReservedImage(std::string_view imageID,
+                            uint64_t reservation,
+                            const QPixmap& image);
   void reset();
   bool setPixel(const QPoint& location, const QColor& color);
   void setPosition(const QPoint& location, Position position, Flags flags = {});
@@ -247,22 +292,66 @@ protected:
 
 private:
   void applyFlags();
+  // Prepares the pixmap to be modified outside of the display list.
+  void beginDirectDraw();
+  void commitFrame();
   QRect normalize(const QRect& rect) const noexcept;
   QRectF normalize(const QRectF& rect) const noexcept;
+  template<typename MakeKey, typename Paint>
+  void record(const QRectF& bounds, MakeKey&& makeKey, Paint&& paint)
+  {
+    if (flags.testFlag(Flag::Retained)) {
+      retain(bounds, makeKey(), std::forward<Paint>(paint));
+      return;
+    }
+    if (batchPainter != nullptr) {
+      batchPainter->save();
+      paint(*batchPainter);
+      batchPainter->restore();
+      return;
+    }
+    Painter painter(this);
+    paint(painter);
+  }
+  void retain(const QRectF& bounds,
+              QByteArray&& key,
+              DisplayList::Paint&& paint);
+  void scheduleCommit();
+  // Returns part of an image with its top-left color made transparent, as
+  // drawn by DrawImageMode::CopyTransparent and MergeMode::Transparent.
+  QImage transparentImage(const QPixmap& image, const QRect& sourceRect);
   void updateMask();
 
 private:
+  class Painter;
+
   QColor background;
+  std::unique_ptr<Painter> batchPainter;
   QSize dimensions;
+  // Set when part of the current batch has already been drawn.
+  bool frameFlushed = false;
+  bool frameScheduled = false;
   Flags flags;
   string_map<QFont> fonts;
   string_map<std::unique_ptr<Hotspot>> hotspots;
   string_map<QPixmap> images;
   QDateTime installed;
+  // Primitives that produced the current contents of the pixmap.
+  DisplayList lastFrame;
+  int64_t lastFrameArea = 0;
+  uint64_t lastReservation = 0;
   QPoint location;
+  // Primitives recorded since the last commit.
+  DisplayList pendingFrame;
   QPixmap pixmap;
+  // Set when the pixmap has been modified outside of the display list.
+  bool pixmapDetached = false;
   std::string pluginID;
   Position position;
+  string_map<uint64_t> reservedImages;
+  TextCache texts;
+  string_map<string_map<QRectF>> tiles;
+  QCache<QByteArray, QImage> transparentImages;
   int64_t zOrder = 0;
 
 private:
@@ -0,0 +1,44 @@
+#include "textcache.h"
+#include <QtGui/QFontMetricsF>
+
+using std::string_view;
+
+// Public methods
+
+TextCache::TextCache(qsizetype maxEntries)
+  : entries(maxEntries)
+{
+}
+
+const TextCache::Entry&
+TextCache::get(string_view fontID,
+               const QFont& font,
+               string_view text,
+               bool unicode)
+{
+  // Keys are raw bytes, so cache hits skip conversion to QString entirely.
+  QByteArray key;
+  key.reserve(static_cast<qsizetype>(fontID.size() + text.size()) + 8);
+  key.append(QByteArray::number(fontID.size()))
+    .append(unicode ? 'u' : 'l')
+    .append(fontID)
+    .append(text);
+  if (const Entry* cached = entries.object(key)) {
+    return *cached;
+  }
+  const QString qtext =
+    unicode ? QString::fromUtf8(text) : QString::fromLatin1(text);
+  QStaticText staticText(qtext);
+  staticText.setTextFormat(Qt::TextFormat::PlainText);
+  staticText.prepare(QTransform(), font);
+  const QFontMetricsF fm(font);
+  auto* entry = new Entry{
+    .font = font,
+    .text = std::move(staticText),
+    .width = fm.horizontalAdvance(qtext),
+    .boundingWidth = fm.boundingRect(QRectF(), 0, qtext).width(),
+    .multiline = qtext.contains(u'\n'),
+  };
+  entries.insert(key, entry);
+  return *entry;
+}
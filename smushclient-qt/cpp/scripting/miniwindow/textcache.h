@@ -0,0 +1,37 @@
+#pragma once
+#include <QtCore/QCache>
+#include <QtGui/QFont>
+#include <QtGui/QStaticText>
+#include <string_view>
+
+class TextCache
+{
+public:
+  struct Entry
+  {
+    QFont font;
+    QStaticText text;
+    // Horizontal advance, as returned by WindowTextWidth.
+    qreal width;
+    // Width of the rectangle QPainter::drawText covers, as returned by
+    // WindowText. Unlike the advance, it spans the widest line.
+    qreal boundingWidth;
+    // QStaticText lays out line breaks differently from QPainter::drawText, so
+    // text with line breaks is drawn the way it was before it was cached.
+    bool multiline;
+  };
+
+  explicit TextCache(qsizetype maxEntries = 1024);
+
+  void clear() { entries.clear(); }
+  // Returns text shaped in a font, decoding it from UTF-8 or Latin-1. Results
+  // are cached by font ID, so the cache must be cleared whenever a font ID is
+  // reassigned. The returned entry may be evicted by the next call.
+  const Entry& get(std::string_view fontID,
+                   const QFont& font,
+                   std::string_view text,
+                   bool unicode);
+
+private:
+  QCache<QByteArray, Entry> entries;
+};
@@ -664,6 +664,32 @@ qlua::getString(lua_State* L, int idx, optional<string_view> ifNil)
   return lua_tostr(L, idx);
 }
 
+std::vector<string_view>
+qlua::getStrings(lua_State* L, int idx)
+{
+  luaL_checktype(L, idx, LUA_TTABLE);
+  const lua_Unsigned len = lua_rawlen(L, idx);
+  // Every element is checked before the vector is allocated, because raising a
+  // Lua error skips its destructor. Other types are rejected rather than
+  // converted, since a converted copy would not be referenced by anything.
+  for (lua_Unsigned i = 1; i <= len; ++i) {
+    const int type = lua_rawgeti(L, idx, static_cast<lua_Integer>(i));
+    lua_pop(L, 1);
+    if (type != LUA_TSTRING) [[unlikely]] {
+      luaL_typeerror(L, idx, "array of strings"); // exits function
+    }
+  }
+  std::vector<string_view> strings;
+  strings.reserve(static_cast<size_t>(len));
+  for (lua_Unsigned i = 1; i <= len; ++i) {
+    // Strings stay alive after being popped because the table references them.
+    lua_rawgeti(L, idx, static_cast<lua_Integer>(i));
+    strings.push_back(lua_tostr(L, -1));
+    lua_pop(L, 1);
+  }
+  return strings;
+}
+
 bool
 qlua::isScriptName(lua_State* L, string_view name)
 {
@@ -9,6 +9,7 @@
 #include <QtGui/QPen>
 #include <QtNetwork/QHostAddress>
 #include <type_traits>
+#include <vector>
 extern "C"
 {
 #include "lua.h"
@@ -183,6 +184,11 @@ getQString(lua_State* L, int idx, const QString& ifNil);
 std::string_view
 getString(lua_State* L, int idx, optional<std::string_view> ifNil = nullopt);
 
+// Raises a Lua error before allocating anything if the value is not an array
+// of strings. Metamethods are ignored.
+std::vector<std::string_view>
+getStrings(lua_State* L, int idx);
+
 bool
 isScriptName(lua_State* L, std::string_view name);
 
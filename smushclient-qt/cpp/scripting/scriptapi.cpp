@@ -16,7 +16,9 @@
 #include <QtCore/QFileInfo>
 #include <QtGui/QGradient>
 #include <QtGui/QGuiApplication>
+#include <QtGui/QImageReader>
 #include <QtGui/QTextBlock>
+#include <QtGui/QTextDocument>
 #include <QtWidgets/QErrorMessage>
 
 extern "C"
@@ -25,8 +27,6 @@ extern "C"
 }
 
 using std::string_view;
-using std::chrono::milliseconds;
-using std::chrono::seconds;
 
 // Private utils
 
@@ -109,11 +109,19 @@ ScriptApi::ScriptApi(SmushClient& client,
 {
   whenOpened.start();
   connect(&client, &SmushClient::timerSent, this, &ScriptApi::onTimerSent);
+  connect(output.document(),
+          &QTextDocument::contentsChange,
+          this,
+          [this](int position, int removed) {
+            styleCache.invalidate(position);
+            if (removed != 0) {
+              ++outputRemovalCount;
+            }
+          });
   connect(
     &socket, &QAbstractSocket::bytesWritten, this, &ScriptApi::onBytesSent);
   connect(
     commandQueueTimer, &QTimer::timeout, this, &ScriptApi::dequeueCommand);
-  timekeeper->beginPolling(milliseconds(seconds{ 60 }));
 }
 
 void
@@ -249,6 +257,12 @@ ScriptApi::installInto(lua_State* L)
   *apiSlot(L) = this;
 }
 
+QTextBlock
+ScriptApi::outputBlock(int lineNumber) const
+{
+  return cursor->document()->findBlockByNumber(lineNumber);
+}
+
 ApiCode
 ScriptApi::playFileRaw(string_view path)
 {
@@ -768,21 +782,78 @@ ScriptApi::getSenderList(SenderKind kind, string_view pluginId) const noexcept
   return client.listSenders(kind, pluginIndex);
 }
 
+ImageCache::Callback
+ScriptApi::reserveImage(size_t plugin,
+                        MiniWindow* window,
+                        string_view windowName,
+                        string_view imageID,
+                        string_view callback)
+{
+  // Until the image is decoded, the ID is not installed, so draws that use it
+  // fail with ImageNotInstalled. If the ID is loaded again before the decode
+  // finishes, the most recent load wins. Plugins may be reordered or removed
+  // in the meantime, so the callback is routed by plugin ID.
+  const uint64_t reservation = window->reserveImage(imageID);
+  return [this,
+          pluginID = plugins[plugin].id(),
+          window,
+          reservation,
+          windowName = std::string(windowName),
+          imageID = std::string(imageID),
+          routine = std::string(callback)](const QPixmap& image) {
+    ApiCode code = ApiCode::OK;
+    if (!window->installReservedImage(imageID, reservation, image)) {
+      code = image.isNull() ? ApiCode::UnableToLoadImage
+                            : ApiCode::ImageNotInstalled;
+    }
+    if (routine.empty()) {
+      return;
+    }
+    ImageLoadedCallback onLoaded(routine, windowName, imageID, code);
+    sendCallback(onLoaded, pluginID);
+  };
+}
+
 ApiCode
 ScriptApi::setImage(const QString& path,
                     MiniWindow::Position position,
                     bool above)
 {
-  QPointer<ImageWindow>& window = above ? foregroundImage : backgroundImage;
+  uint64_t& request = above ? foregroundImageRequest : backgroundImageRequest;
+  // Supersedes any image that is still being decoded.
+  const uint64_t thisRequest = ++request;
   if (path.isEmpty()) {
+    QPointer<ImageWindow>& window = above ? foregroundImage : backgroundImage;
     delete window.data();
     window = nullptr;
     return ApiCode::OK;
   }
-  QPixmap pixmap(path);
-  if (pixmap.isNull()) {
+  if (!QFile::exists(path)) {
     return ApiCode::FileNotFound;
   }
+  // Only the header is read here. Decoding happens in the background.
+  if (!QImageReader(path).canRead()) {
+    return ApiCode::BadParameter;
+  }
+  ImageCache::global().loadAsync(
+    path,
+    this,
+    [this, path, position, above, &request, thisRequest](
+      const QPixmap& pixmap) {
+      if (request == thisRequest && !pixmap.isNull()) {
+        showImage(path, QPixmap(pixmap), position, above);
+      }
+    });
+  return ApiCode::OK;
+}
+
+void
+ScriptApi::showImage(const QString& path,
+                     QPixmap&& pixmap,
+                     MiniWindow::Position position,
+                     bool above)
+{
+  QPointer<ImageWindow>& window = above ? foregroundImage : backgroundImage;
   if (window == nullptr) {
     window = new ImageWindow(path, std::move(pixmap), position, tab.ui->area);
     if (above) {
@@ -791,9 +862,8 @@ ScriptApi::setImage(const QString& path,
       window->lower();
     }
     window->show();
-    return ApiCode::OK;
+    return;
   }
   window->setPixmap(path, std::move(pixmap));
   window->setPosition(position);
-  return ApiCode::OK;
 }
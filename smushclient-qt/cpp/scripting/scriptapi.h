@@ -1,15 +1,19 @@
 #pragma once
 #include "../mudcursor.h"
+#include "../searchindex.h"
 #include "../stringmap.h"
 #include "../ui/notepad/notepad.h"
 #include "callback/filter.h"
 #include "callback/key.h"
 #include "databaseconnection.h"
+#include "miniwindow/drawcommand.h"
+#include "miniwindow/imagecache.h"
 #include "miniwindow/miniwindow.h"
 #include "plugin.h"
 #include "scriptenums.h"
 #include "smushclient_qt/src/ffi/send_request.cxx.h"
 #include "smushclient_qt/src/ffi/sender.cxxqt.h"
+#include "stylecache.h"
 #include <QtCore/QElapsedTimer>
 #include <QtCore/QPointer>
 #include <QtCore/QQueue>
@@ -230,8 +234,14 @@ public:
                            std::string_view option) const noexcept;
   bool GetEchoInput() const noexcept { return echoInput; }
   std::string_view GetEntity(std::string_view name) const noexcept;
+  ApiCode GetHostAddressAsync(size_t plugin,
+                              const QString& hostName,
+                              std::string_view callback);
+  ApiCode GetHostNameAsync(size_t plugin,
+                           const QString& address,
+                           std::string_view callback);
   QVariant GetInfo(int64_t infoType) const;
-  QVariant GetLineInfo(int line, int64_t infoType) const;
+  QVariant GetLineInfo(int line, int64_t infoType);
   int GetLinesInBufferCount() const;
   QColor GetMapColour(const QColor& color) const noexcept;
   QRect GetMainWindowPosition() const;
@@ -256,7 +266,7 @@ public:
   int GetSelectionEndLine() const;
   int GetSelectionStartColumn() const;
   int GetSelectionStartLine() const;
-  QVariant GetStyleInfo(int line, int64_t style, int64_t infoType) const;
+  QVariant GetStyleInfo(int line, int64_t style, int64_t infoType);
   int64_t GetReceivedBytes() const noexcept;
   int64_t GetSentBytes() const noexcept;
   QColor GetTermColour(uint8_t i) const noexcept;
@@ -383,6 +393,11 @@ public:
                    const QString& filePath,
                    bool replace) const;
   ApiCode SaveState(size_t plugin);
+  QList<SearchIndex::Match> SearchOutput(const QString& text,
+                                         Qt::CaseSensitivity caseSensitivity,
+                                         qsizetype limit) const;
+  QList<SearchIndex::Match> SearchOutput(const QRegularExpression& pattern,
+                                         qsizetype limit) const;
   void SelectCommand() const;
   ApiCode Send(std::string_view text);
   ApiCode Send(const QString& text);
@@ -439,7 +454,9 @@ public:
                    std::string_view value) const noexcept;
   void ShowInfoBar(bool visible);
   void Simulate(std::string_view output) const noexcept;
+  ApiCode StartRecording(std::string_view fileName) const;
   void StopEvaluatingTriggers() const noexcept;
+  ApiCode StopRecording() const;
   ApiCode StopSound(size_t channel = 0);
   void Tell(const QString& text);
   ApiCode TextRectangle(const QRect& rect,
@@ -462,6 +479,10 @@ public:
                            const QString& tooltip,
                            Qt::CursorShape cursor,
                            Hotspot::Flags flags) const;
+  ApiCode WindowAddTile(std::string_view windowName,
+                        std::string_view imageID,
+                        std::string_view tileID,
+                        const QRectF& rect) const;
   ApiCode WindowArc(std::string_view windowName,
                     const QRectF& rect,
                     const QPointF& start,
@@ -494,6 +515,8 @@ public:
   ApiCode WindowDeleteAllHotspots(std::string_view windowName) const;
   ApiCode WindowDeleteHotspot(std::string_view windowName,
                               std::string_view hotspotID) const;
+  ApiCode WindowDrawBatch(std::string_view windowName,
+                          std::span<const draw::Command> commands) const;
   ApiCode WindowDrawImage(std::string_view windowName,
                           std::string_view imageID,
                           const QRectF& rect,
@@ -504,6 +527,10 @@ public:
                                const QRectF& rect,
                                qreal opacity,
                                const QPointF& origin) const;
+  ApiCode WindowDrawTiles(std::string_view windowName,
+                          std::string_view imageID,
+                          std::span<const draw::Tile> tiles,
+                          qreal opacity) const;
   ApiCode WindowEllipse(std::string_view windowName,
                         const QRectF& rect,
                         const QPen& pen,
@@ -564,10 +591,21 @@ public:
   ApiCode WindowLoadImage(std::string_view windowName,
                           std::string_view imageID,
                           const QString& filename) const;
+  ApiCode WindowLoadImageAsync(size_t plugin,
+                               std::string_view windowName,
+                               std::string_view imageID,
+                               const QString& filename,
+                               std::string_view callback);
   ApiCode WindowLoadImageMemory(std::string_view windowName,
                                 std::string_view imageID,
                                 QByteArrayView data,
                                 bool swapBlueAndAlpha = false) const;
+  ApiCode WindowLoadImageMemoryAsync(size_t plugin,
+                                     std::string_view windowName,
+                                     std::string_view imageID,
+                                     const QByteArray& data,
+                                     bool swapBlueAndAlpha,
+                                     std::string_view callback);
   QString WindowMenu(std::string_view windowName,
                      const QPoint& location,
                      std::string_view menuString) const;
@@ -631,6 +669,11 @@ public:
                         std::string_view fontID,
                         std::string_view text,
                         bool unicode) const;
+  qreal WindowTextWidths(std::string_view windowName,
+                         std::string_view fontID,
+                         const std::vector<std::string_view>& texts,
+                         bool unicode,
+                         std::vector<qreal>& widths) const;
   ApiCode WindowTransformImage(std::string_view windowName,
                                std::string_view imageID,
                                MergeMode mode,
@@ -661,6 +704,11 @@ public:
   {
     return !plugins[plugin].isDisabled();
   }
+  // Returns a line of the output buffer, for walking many lines in one pass.
+  QTextBlock outputBlock(int lineNumber) const;
+  // Increases whenever text is removed from the output buffer. Blocks from
+  // outputBlock may be gone once it changes.
+  uint64_t outputRemovals() const noexcept { return outputRemovalCount; }
   QWidget* parentWidget() const { return qobject_cast<QWidget*>(parent()); }
   ApiCode playFileRaw(std::string_view path);
   void printError(const QString& message);
@@ -754,9 +802,18 @@ private:
   rust::Vec<rust::String> getSenderList(
     SenderKind kind,
     std::string_view pluginId) const noexcept;
+  ImageCache::Callback reserveImage(size_t plugin,
+                                    MiniWindow* window,
+                                    std::string_view windowName,
+                                    std::string_view imageID,
+                                    std::string_view callback);
   ApiCode setImage(const QString& path,
                    MiniWindow::Position position,
                    bool above);
+  void showImage(const QString& path,
+                 QPixmap&& pixmap,
+                 MiniWindow::Position position,
+                 bool above);
 
 private:
   static constexpr const size_t noSuchPlugin = 0xFFFFFFFFFFFFFFFF;
@@ -765,6 +822,7 @@ private:
   CallbackFilter activeCallbacks;
   QRect assignedTextRectangle;
   QPointer<ImageWindow> backgroundImage = nullptr;
+  uint64_t backgroundImageRequest = 0;
   CallbackFilter callbackFilter;
   const SmushClient& client;
   QQueue<QueuedCommand> commandQueue;
@@ -772,9 +830,11 @@ private:
   QPointer<MudCursor> cursor;
   string_map<DatabaseConnection> databases;
   QPointer<ImageWindow> foregroundImage = nullptr;
+  uint64_t foregroundImageRequest = 0;
   QTextCursor infoCursor;
   QByteArray lastCommandSent;
   QPointer<Notepads> notepads;
+  uint64_t outputRemovalCount = 0;
   std::vector<Plugin> plugins;
   string_map<size_t> pluginIndices;
   QQueue<QueuedScript> scriptQueue;
@@ -782,6 +842,7 @@ private:
   TimerMap<SendRequest, ScriptApi>* sendQueue;
   QPointer<QAbstractSocket> socket;
   std::unique_ptr<MudStatusBar> statusBarPtr;
+  StyleCache styleCache;
   WorldTab& tab;
   QDateTime timeOpened;
   Timekeeper* timekeeper;
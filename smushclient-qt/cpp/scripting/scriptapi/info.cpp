@@ -1,10 +1,12 @@
 #include "../../environment.h"
+#include "../../image.h"
 #include "../../settings.h"
 #include "../../spans.h"
 #include "../../ui/components/mudscrollbar.h"
 #include "../../ui/mudstatusbar/mudstatusbar.h"
 #include "../../ui/ui_worldtab.h"
 #include "../../ui/worldtab.h"
+#include "../miniwindow/imagecache.h"
 #include "../miniwindow/imagewindow.h"
 #include "../scriptapi.h"
 #include "smushclient_qt/src/ffi/util.cxx.h"
@@ -432,13 +434,25 @@ ScriptApi::GetInfo(int64_t infoType) const
       return QDateTime::currentDateTime();
     case 306:
       return timeOpened;
+    case 315:
+      return ImageCache::global().stats().hits;
+    case 316:
+      return ImageCache::global().stats().misses;
+    case 317:
+      return ImageCache::global().stats().bytes;
+    case 318:
+      return ImageCache::global().stats().images;
+    case 319:
+      return static_cast<qlonglong>(image::conversionStats().total);
+    case 320:
+      return static_cast<qlonglong>(image::conversionStats().lastSecond);
     default:
       return client.getInfo(infoType);
   }
 }
 
 QVariant
-ScriptApi::GetLineInfo(int lineNumber, int64_t infoType) const
+ScriptApi::GetLineInfo(int lineNumber, int64_t infoType)
 {
   const QTextBlock block = cursor->document()->findBlockByNumber(lineNumber);
   if (!block.isValid()) {
@@ -466,7 +480,7 @@ ScriptApi::GetLineInfo(int lineNumber, int64_t infoType) const
     case 10:
       return lineNumber;
     case 11:
-      return block.textFormats().size();
+      return styleCache.get(*cursor->document(), lineNumber)->styles.size();
     case 12:
       return spans::getElapsed(block.blockFormat()).msecsSinceReference();
     case 13:
@@ -493,28 +507,19 @@ ScriptApi::GetPluginInfo(string_view pluginID, int64_t infoType) const noexcept
 }
 
 QVariant
-ScriptApi::GetStyleInfo(int line, int64_t style, int64_t infoType) const
+ScriptApi::GetStyleInfo(int line, int64_t style, int64_t infoType)
 {
   if (line < 0 || style < 0) {
     return QVariant();
   }
-  const QTextDocument& doc = *cursor->document();
-  const QTextBlock block = doc.findBlockByNumber(line);
-  if (!block.isValid()) {
-    return QVariant();
-  }
-  const QTextLayout* layout = block.layout();
-  if (layout == nullptr) [[unlikely]] {
-    return QVariant();
-  }
-  const QList<QTextLayout::FormatRange> styles = block.textFormats();
-  if (styles.size() < style) {
+  const StyleCache::Line* cached = styleCache.get(*cursor->document(), line);
+  if (cached == nullptr || cached->styles.size() <= style) {
     return QVariant();
   }
-  const QTextLayout::FormatRange& range = styles.at(style);
+  const QTextLayout::FormatRange& range = cached->styles.at(style);
   switch (infoType) {
     case 1:
-      return block.text().sliced(range.start, range.length);
+      return cached->text.sliced(range.start, range.length);
     case 2:
       return range.length;
     case 3:
@@ -663,6 +668,10 @@ MiniWindow::info(int64_t infoType) const
       return zOrder;
     case 23:
       return QString::fromUtf8(pluginID);
+    case 24:
+      return static_cast<qlonglong>(lastFrame.size());
+    case 25:
+      return static_cast<qlonglong>(lastFrameArea);
     default:
       return QVariant();
   }
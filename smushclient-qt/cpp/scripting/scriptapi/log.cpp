@@ -27,6 +27,18 @@ ScriptApi::OpenLog(string_view logFileName, bool append) const
   return client.openLog(logFileName, append);
 }
 
+ApiCode
+ScriptApi::StartRecording(string_view fileName) const
+{
+  return client.startRecording(fileName);
+}
+
+ApiCode
+ScriptApi::StopRecording() const
+{
+  return client.stopRecording();
+}
+
 ApiCode
 ScriptApi::WriteLog(string_view message) const
 {
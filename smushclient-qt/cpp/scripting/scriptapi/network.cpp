@@ -1,4 +1,6 @@
 #include "../../ui/worldtab.h"
+#include "../callback/plugincallback.h"
+#include "../hostcache.h"
 #include "../scriptapi.h"
 #include <QtNetwork/QHostInfo>
 
@@ -7,13 +9,13 @@
 QList<QHostAddress>
 ScriptApi::GetHostAddress(const QString& hostName)
 {
-  return QHostInfo::fromName(hostName).addresses();
+  return HostCache::global().lookup(hostName).addresses();
 }
 
 QString
 ScriptApi::GetHostName(const QString& address)
 {
-  return QHostInfo::fromName(address).hostName();
+  return HostCache::global().lookup(address).hostName();
 }
 
 // Public methods
@@ -39,6 +41,50 @@ ScriptApi::GetConnectDuration() const
   return whenConnected.durationElapsed();
 }
 
+ApiCode
+ScriptApi::GetHostAddressAsync(size_t plugin,
+                               const QString& hostName,
+                               std::string_view callback)
+{
+  if (!plugins[plugin].hasFunction(callback)) {
+    return ApiCode::NoSuchRoutine;
+  }
+  HostCache::global().lookupAsync(
+    hostName,
+    this,
+    [this,
+     pluginID = plugins[plugin].id(),
+     hostName,
+     routine = std::string(callback)](const QHostInfo& info) {
+      const QList<QHostAddress> addresses = info.addresses();
+      HostAddressCallback onResolved(routine, hostName, addresses);
+      sendCallback(onResolved, pluginID);
+    });
+  return ApiCode::OK;
+}
+
+ApiCode
+ScriptApi::GetHostNameAsync(size_t plugin,
+                            const QString& address,
+                            std::string_view callback)
+{
+  if (!plugins[plugin].hasFunction(callback)) {
+    return ApiCode::NoSuchRoutine;
+  }
+  HostCache::global().lookupAsync(
+    address,
+    this,
+    [this,
+     pluginID = plugins[plugin].id(),
+     address,
+     routine = std::string(callback)](const QHostInfo& info) {
+      const QString hostName = info.hostName();
+      HostNameCallback onResolved(routine, address, hostName);
+      sendCallback(onResolved, pluginID);
+    });
+  return ApiCode::OK;
+}
+
 int64_t
 ScriptApi::GetReceivedBytes() const noexcept
 {
@@ -99,6 +99,22 @@ ScriptApi::Reset() const noexcept
   client.resetMxp();
 }
 
+QList<SearchIndex::Match>
+ScriptApi::SearchOutput(const QString& text,
+                        Qt::CaseSensitivity caseSensitivity,
+                        qsizetype limit) const
+{
+  return SearchIndex::of(*cursor->document())
+    .search(text, caseSensitivity, limit);
+}
+
+QList<SearchIndex::Match>
+ScriptApi::SearchOutput(const QRegularExpression& pattern,
+                        qsizetype limit) const
+{
+  return SearchIndex::of(*cursor->document()).search(pattern, limit);
+}
+
 ApiCode
 ScriptApi::SetBackgroundImage(const QString& path,
                               MiniWindow::Position position)
@@ -177,7 +177,9 @@ ScriptApi::DeleteTemporaryAliases() const noexcept
 size_t
 ScriptApi::DeleteTemporaryTimers() const noexcept
 {
-  return client.removeTemporarySenders(SenderKind::Timer);
+  const size_t count = client.removeTemporarySenders(SenderKind::Timer);
+  timekeeper->rearm();
+  return count;
 }
 
 size_t
@@ -189,13 +191,18 @@ ScriptApi::DeleteTemporaryTriggers() const noexcept
 ApiCode
 ScriptApi::DeleteTimer(size_t plugin, string_view name) const noexcept
 {
-  return client.removeSender(SenderKind::Timer, plugin, name);
+  const ApiCode code = client.removeSender(SenderKind::Timer, plugin, name);
+  timekeeper->rearm();
+  return code;
 }
 
 size_t
 ScriptApi::DeleteTimerGroup(size_t plugin, string_view group) const noexcept
 {
-  return client.removeSenderGroup(SenderKind::Timer, plugin, group);
+  const size_t count =
+    client.removeSenderGroup(SenderKind::Timer, plugin, group);
+  timekeeper->rearm();
+  return count;
 }
 
 ApiCode
@@ -250,7 +257,10 @@ ScriptApi::EnableTimer(size_t plugin,
                        string_view label,
                        bool enabled) const noexcept
 {
-  return client.setSenderEnabled(SenderKind::Timer, plugin, label, enabled);
+  const ApiCode code =
+    client.setSenderEnabled(SenderKind::Timer, plugin, label, enabled);
+  timekeeper->rearm();
+  return code;
 }
 
 size_t
@@ -258,8 +268,10 @@ ScriptApi::EnableTimerGroup(size_t plugin,
                             string_view group,
                             bool enabled) const noexcept
 {
-  return client.setSenderGroupEnabled(
-    SenderKind::Timer, plugin, group, enabled);
+  const size_t count =
+    client.setSenderGroupEnabled(SenderKind::Timer, plugin, group, enabled);
+  timekeeper->rearm();
+  return count;
 }
 
 ApiCode
@@ -353,8 +365,10 @@ ScriptApi::SetTimerOption(size_t plugin,
                           string_view option,
                           string_view value) const noexcept
 {
-  return client.setSenderOption(
-    SenderKind::Timer, plugin, label, option, value);
+  const ApiCode code =
+    client.setSenderOption(SenderKind::Timer, plugin, label, option, value);
+  timekeeper->rearm();
+  return code;
 }
 
 ApiCode
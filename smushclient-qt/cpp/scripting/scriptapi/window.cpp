@@ -1,6 +1,7 @@
 #include "../../image.h"
 #include "../../ui/ui_worldtab.h"
 #include "../../ui/worldtab.h"
+#include "../miniwindow/imagecache.h"
 #include "../miniwindow/imagefilters.h"
 #include "../scriptapi.h"
 #include <QtCore/QFile>
@@ -30,6 +31,109 @@ using std::string_view;
     return {};                                                                 \
   }
 
+namespace {
+QLinearGradient
+linearGradient(const QColor& color1,
+               const QColor& color2,
+               Qt::Orientation direction)
+{
+  const qreal horizontalStop =
+    direction == Qt::Orientation::Horizontal ? 1.0 : 0.0;
+  QLinearGradient gradient(0.0, 0.0, horizontalStop, 1.0 - horizontalStop);
+  gradient.setCoordinateMode(QGradient::CoordinateMode::ObjectMode);
+  gradient.setColorAt(0.0, color1);
+  gradient.setColorAt(1.0, color2);
+  return gradient;
+}
+
+class BatchDrawer
+{
+public:
+  explicit BatchDrawer(MiniWindow& window)
+    : window(window)
+  {
+  }
+
+  ApiCode operator()(const draw::Button& command)
+  {
+    window.drawButton(command.rect, command.frame, command.flags);
+    return ApiCode::OK;
+  }
+
+  ApiCode operator()(const draw::Ellipse& command)
+  {
+    window.drawEllipse(command.rect, command.pen, command.brush);
+    return ApiCode::OK;
+  }
+
+  ApiCode operator()(const draw::Frame& command)
+  {
+    window.drawFrame(command.rect, command.color1, command.color2);
+    return ApiCode::OK;
+  }
+
+  ApiCode operator()(const draw::Gradient& command)
+  {
+    window.drawGradient(
+      command.rect,
+      linearGradient(command.color1, command.color2, command.direction));
+    return ApiCode::OK;
+  }
+
+  ApiCode operator()(const draw::Image& command)
+  {
+    const QPixmap* pixmap = window.findImage(command.imageID);
+    if (pixmap == nullptr) [[unlikely]] {
+      return ApiCode::ImageNotInstalled;
+    }
+    window.drawImage(*pixmap, command.rect, command.sourceRect, command.mode);
+    return ApiCode::OK;
+  }
+
+  ApiCode operator()(const draw::Invert& command)
+  {
+    window.invert(command.rect);
+    return ApiCode::OK;
+  }
+
+  ApiCode operator()(const draw::Line& command)
+  {
+    window.drawLine(command.line, command.pen);
+    return ApiCode::OK;
+  }
+
+  ApiCode operator()(const draw::Rect& command)
+  {
+    window.drawRect(command.rect, command.pen, command.brush);
+    return ApiCode::OK;
+  }
+
+  ApiCode operator()(const draw::RoundedRect& command)
+  {
+    window.drawRoundedRect(command.rect,
+                           command.xRadius,
+                           command.yRadius,
+                           command.pen,
+                           command.brush);
+    return ApiCode::OK;
+  }
+
+  ApiCode operator()(const draw::Text& command)
+  {
+    const TextCache::Entry* shaped =
+      window.findText(command.fontID, command.text, command.unicode);
+    if (shaped == nullptr) [[unlikely]] {
+      return ApiCode::BadParameter;
+    }
+    window.drawText(*shaped, command.rect, command.color);
+    return ApiCode::OK;
+  }
+
+private:
+  MiniWindow& window;
+};
+} // namespace
+
 // Public static methods
 
 QColor
@@ -46,6 +150,19 @@ ScriptApi::BlendPixel(const QColor& blend,
 
 // Public methods
 
+ApiCode
+ScriptApi::WindowAddTile(string_view windowName,
+                         string_view imageID,
+                         string_view tileID,
+                         const QRectF& rect) const
+{
+  MiniWindow* window = TRY_WINDOW(windowName);
+  if (!window->addTile(imageID, tileID, rect)) [[unlikely]] {
+    return ApiCode::ImageNotInstalled;
+  }
+  return ApiCode::OK;
+}
+
 ApiCode
 ScriptApi::WindowArc(string_view windowName,
                      const QRectF& rect,
@@ -167,6 +284,24 @@ ScriptApi::WindowDelete(string_view windowName) const
   return ApiCode::OK;
 }
 
+ApiCode
+ScriptApi::WindowDrawBatch(string_view windowName,
+                           std::span<const draw::Command> commands) const
+{
+  MiniWindow* window = TRY_WINDOW(windowName);
+  BatchDrawer drawer(*window);
+  ApiCode result = ApiCode::OK;
+  window->beginBatch();
+  for (const draw::Command& command : commands) {
+    const ApiCode code = std::visit(drawer, command);
+    if (code != ApiCode::OK && result == ApiCode::OK) [[unlikely]] {
+      result = code;
+    }
+  }
+  window->endBatch();
+  return result;
+}
+
 ApiCode
 ScriptApi::WindowDrawImage(string_view windowName,
                            string_view imageID,
@@ -196,6 +331,37 @@ ScriptApi::WindowDrawImageAlpha(string_view windowName,
   return ApiCode::OK;
 }
 
+ApiCode
+ScriptApi::WindowDrawTiles(string_view windowName,
+                           string_view imageID,
+                           std::span<const draw::Tile> tiles,
+                           qreal opacity) const
+{
+  MiniWindow* window = TRY_WINDOW(windowName);
+  const QPixmap* pixmap = TRY_PIXMAP(window, imageID);
+  if (tiles.empty()) {
+    return ApiCode::OK;
+  }
+  const string_map<QRectF>* sheet = window->findTiles(imageID);
+  if (sheet == nullptr) [[unlikely]] {
+    return ApiCode::BadParameter;
+  }
+  std::vector<QPainter::PixmapFragment> fragments;
+  fragments.reserve(tiles.size());
+  for (const draw::Tile& tile : tiles) {
+    auto search = sheet->find(tile.tileID);
+    if (search == sheet->end()) [[unlikely]] {
+      return ApiCode::BadParameter;
+    }
+    const QRectF& source = search->second;
+    const QPointF center(source.width() / 2, source.height() / 2);
+    fragments.push_back(QPainter::PixmapFragment::create(
+      tile.position + center, source, 1, 1, 0, opacity));
+  }
+  window->drawTiles(*pixmap, fragments);
+  return ApiCode::OK;
+}
+
 ApiCode
 ScriptApi::WindowEllipse(string_view windowName,
                          const QRectF& rect,
@@ -276,9 +442,9 @@ ScriptApi::WindowGetImageAlpha(string_view windowName,
   MiniWindow* window = TRY_WINDOW(windowName);
   const QPixmap* pixmap = TRY_PIXMAP(window, imageID);
   QImage alphaImage = pixmap->toImage();
-  alphaImage.convertTo(QImage::Format::Format_Alpha8);
+  image::convert(alphaImage, QImage::Format::Format_Alpha8);
   alphaImage.reinterpretAsFormat(QImage::Format::Format_Grayscale8);
-  QPixmap alphaPixmap = QPixmap::fromImage(alphaImage);
+  QPixmap alphaPixmap = QPixmap::fromImage(std::move(alphaImage));
   window->drawImage(alphaPixmap, rect, QRectF(point, rect.size()));
   return ApiCode::OK;
 }
@@ -303,13 +469,7 @@ ScriptApi::WindowGradient(string_view windowName,
                           Qt::Orientation direction) const
 {
   MiniWindow* window = TRY_WINDOW(windowName);
-  const qreal horizontalStop =
-    direction == Qt::Orientation::Horizontal ? 1.0 : 0.0;
-  QLinearGradient gradient(0.0, 0.0, horizontalStop, 1.0 - horizontalStop);
-  gradient.setCoordinateMode(QGradient::CoordinateMode::ObjectMode);
-  gradient.setColorAt(0.0, color1);
-  gradient.setColorAt(1.0, color2);
-  window->drawGradient(rect, gradient);
+  window->drawGradient(rect, linearGradient(color1, color2, direction));
   return ApiCode::OK;
 }
 
@@ -374,7 +534,7 @@ ScriptApi::WindowLoadImage(string_view windowName,
                            const QString& filename) const
 {
   MiniWindow* window = TRY_WINDOW(windowName);
-  QPixmap image(filename);
+  QPixmap image = ImageCache::global().load(filename);
   if (!image.isNull()) [[likely]] {
     window->loadImage(imageID, std::move(image));
     return ApiCode::OK;
@@ -385,6 +545,27 @@ ScriptApi::WindowLoadImage(string_view windowName,
   return ApiCode::FileNotFound;
 }
 
+ApiCode
+ScriptApi::WindowLoadImageAsync(size_t plugin,
+                                string_view windowName,
+                                string_view imageID,
+                                const QString& filename,
+                                string_view callback)
+{
+  MiniWindow* window = TRY_WINDOW(windowName);
+  if (!callback.empty() && !plugins[plugin].hasFunction(callback)) {
+    return ApiCode::NoSuchRoutine;
+  }
+  if (!QFile::exists(filename)) {
+    return ApiCode::FileNotFound;
+  }
+  ImageCache::global().loadAsync(
+    filename,
+    window,
+    reserveImage(plugin, window, windowName, imageID, callback));
+  return ApiCode::OK;
+}
+
 ApiCode
 ScriptApi::WindowLoadImageMemory(string_view windowName,
                                  string_view imageID,
@@ -392,18 +573,31 @@ ScriptApi::WindowLoadImageMemory(string_view windowName,
                                  bool swapBlueAndAlpha) const
 {
   MiniWindow* window = TRY_WINDOW(windowName);
-  QImage image = QImage::fromData(data, "PNG");
+  QPixmap image = ImageCache::global().loadFromData(data, swapBlueAndAlpha);
   if (image.isNull()) [[unlikely]] {
-    image = QImage::fromData(data);
-    if (image.isNull()) [[unlikely]] {
-      return ApiCode::UnableToLoadImage;
-    }
-  }
-  if (swapBlueAndAlpha) {
-    ImageFilter::SwapBlueAndAlpha().apply(image);
+    return ApiCode::UnableToLoadImage;
   }
+  window->loadImage(imageID, std::move(image));
+  return ApiCode::OK;
+}
 
-  window->loadImage(imageID, QPixmap::fromImage(image));
+ApiCode
+ScriptApi::WindowLoadImageMemoryAsync(size_t plugin,
+                                      string_view windowName,
+                                      string_view imageID,
+                                      const QByteArray& data,
+                                      bool swapBlueAndAlpha,
+                                      string_view callback)
+{
+  MiniWindow* window = TRY_WINDOW(windowName);
+  if (!callback.empty() && !plugins[plugin].hasFunction(callback)) {
+    return ApiCode::NoSuchRoutine;
+  }
+  ImageCache::global().loadFromDataAsync(
+    data,
+    swapBlueAndAlpha,
+    window,
+    reserveImage(plugin, window, windowName, imageID, callback));
   return ApiCode::OK;
 }
 
@@ -594,13 +788,12 @@ ScriptApi::WindowText(string_view windowName,
   if (window == nullptr) [[unlikely]] {
     return -1;
   }
-  const QFont* font = window->findFont(fontID);
-  if (font == nullptr) [[unlikely]] {
+  const TextCache::Entry* shaped = window->findText(fontID, text, unicode);
+  if (shaped == nullptr) [[unlikely]] {
     return -2;
   }
-  const QString qtext =
-    unicode ? QString::fromUtf8(text) : QString::fromLatin1(text);
-  return window->drawText(*font, qtext, rect, color).width();
+  window->drawText(*shaped, rect, color);
+  return shaped->boundingWidth;
 }
 
 qreal
@@ -613,14 +806,33 @@ ScriptApi::WindowTextWidth(string_view windowName,
   if (window == nullptr) [[unlikely]] {
     return -1;
   }
-  const QFont* font = window->findFont(fontID);
-  if (font == nullptr) [[unlikely]] {
+  const TextCache::Entry* shaped = window->findText(fontID, text, unicode);
+  if (shaped == nullptr) [[unlikely]] {
     return -2;
   }
-  QFontMetricsF fm(*font);
-  const QString qtext =
-    unicode ? QString::fromUtf8(text) : QString::fromLatin1(text);
-  return fm.horizontalAdvance(qtext);
+  return shaped->width;
+}
+
+qreal
+ScriptApi::WindowTextWidths(string_view windowName,
+                            string_view fontID,
+                            const std::vector<string_view>& texts,
+                            bool unicode,
+                            std::vector<qreal>& widths) const
+{
+  MiniWindow* window = findWindow(windowName);
+  if (window == nullptr) [[unlikely]] {
+    return -1;
+  }
+  if (window->findFont(fontID) == nullptr) [[unlikely]] {
+    return -2;
+  }
+  widths.clear();
+  widths.reserve(texts.size());
+  for (string_view text : texts) {
+    widths.push_back(window->findText(fontID, text, unicode)->width);
+  }
+  return 0;
 }
 
 ApiCode
@@ -0,0 +1,39 @@
+#include "stylecache.h"
+#include <QtGui/QTextBlock>
+#include <QtGui/QTextDocument>
+
+// Public methods
+
+void
+StyleCache::clear() noexcept
+{
+  lineNumber = -1;
+  end = -1;
+}
+
+const StyleCache::Line*
+StyleCache::get(const QTextDocument& document, int number)
+{
+  if (number == lineNumber) {
+    return &line;
+  }
+  const QTextBlock block = document.findBlockByNumber(number);
+  if (!block.isValid()) {
+    return nullptr;
+  }
+  line.text = block.text();
+  line.styles = block.textFormats();
+  lineNumber = number;
+  end = block.position() + block.length();
+  return &line;
+}
+
+void
+StyleCache::invalidate(int position) noexcept
+{
+  // Removing lines from the start of the document renumbers every line, and
+  // starts at position 0, so it is caught here as well.
+  if (position <= end) {
+    clear();
+  }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <QtGui/QTextLayout>
+
+class QTextDocument;
+
+// Caches the text and style runs of the most recently inspected output line.
+// QTextBlock::textFormats copies every style run in a line, so without the
+// cache, walking each style of a line with GetStyleInfo is quadratic.
+class StyleCache
+{
+public:
+  struct Line
+  {
+    QString text;
+    QList<QTextLayout::FormatRange> styles;
+  };
+
+  void clear() noexcept;
+  // Returns a line of a document, or nullptr if there is no such line. The
+  // result is only valid until the next call.
+  const Line* get(const QTextDocument& document, int lineNumber);
+  // Drops the cached line if a change at a document position may affect it.
+  void invalidate(int position) noexcept;
+
+private:
+  Line line;
+  int lineNumber = -1;
+  int end = -1;
+};
@@ -0,0 +1,545 @@
+#include "searchindex.h"
+#include <QtCore/QRegularExpression>
+#include <QtGui/QTextBlock>
+#include <QtGui/QTextDocument>
+#include <algorithm>
+
+using std::nullopt;
+using std::optional;
+
+using Qt::StringLiterals::operator""_L1;
+
+// Lines removed from the start of the document before their postings are
+// pruned, unless the document is larger than this.
+constexpr int pruneThreshold = 4096;
+
+// Private utils
+
+namespace {
+quint64
+fold(QChar c) noexcept
+{
+  return c.toCaseFolded().unicode();
+}
+
+template<typename Trigram>
+void
+addTrigrams(QStringView text, std::vector<Trigram>& trigrams)
+{
+  const qsizetype size = text.size();
+  if (size < 3) {
+    return;
+  }
+  constexpr Trigram mask = 0xFFFF'FFFF'FFFF;
+  Trigram key = (fold(text[0]) << 16) | fold(text[1]);
+  for (qsizetype i = 2; i < size; ++i) {
+    key = ((key << 16) | fold(text[i])) & mask;
+    trigrams.push_back(key);
+  }
+}
+
+template<typename Trigram>
+void
+sortUnique(std::vector<Trigram>& trigrams)
+{
+  std::sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+// Skips a character class starting at position i, returning the position of
+// its closing bracket.
+qsizetype
+skipClass(const QString& source, qsizetype i)
+{
+  const qsizetype size = source.size();
+  ++i;
+  if (i < size && source[i] == u'^') {
+    ++i;
+  }
+  if (i < size && source[i] == u']') {
+    ++i;
+  }
+  for (; i < size && source[i] != u']'; ++i) {
+    if (source[i] == u'\\') {
+      ++i;
+    }
+  }
+  return i;
+}
+
+// Skips the arguments of an escape sequence such as \x{41} or \p{L}, returning
+// the position of the last character of the sequence. Any literal characters
+// that follow it are skipped too, which only weakens the prefilter.
+qsizetype
+skipEscape(const QString& source, qsizetype i)
+{
+  const qsizetype size = source.size();
+  while (i + 1 < size && source[i + 1].isLetterOrNumber()) {
+    ++i;
+  }
+  if (i + 1 < size && source[i + 1] == u'{') {
+    const qsizetype close = source.indexOf(u'}', i + 1);
+    i = close == -1 ? size - 1 : close;
+  }
+  return i;
+}
+
+// Returns runs of literal text that every match of a pattern must contain.
+// Patterns with alternation or inline groups are not analyzed, and literals
+// inside groups are ignored, since a group may be optional.
+QList<QString>
+requiredLiterals(const QRegularExpression& pattern)
+{
+  if (pattern.patternOptions().testFlag(
+        QRegularExpression::ExtendedPatternSyntaxOption)) {
+    return {};
+  }
+  const QString source = pattern.pattern();
+  if (source.contains(u'|') || source.contains("(?"_L1)) {
+    return {};
+  }
+  QList<QString> literals;
+  QString run;
+  const auto endRun = [&literals, &run] {
+    if (run.size() >= 3) {
+      literals.push_back(run);
+    }
+    run.clear();
+  };
+  const qsizetype size = source.size();
+  int depth = 0;
+  for (qsizetype i = 0; i < size; ++i) {
+    QChar c = source[i];
+    switch (c.unicode()) {
+      case u'\\':
+        if (i + 1 == size) {
+          endRun();
+          continue;
+        }
+        c = source[++i];
+        if (c.isLetterOrNumber()) {
+          endRun();
+          i = skipEscape(source, i);
+          continue;
+        }
+        break;
+      case u'[':
+        endRun();
+        i = skipClass(source, i);
+        continue;
+      case u'(':
+        ++depth;
+        endRun();
+        continue;
+      case u')':
+        --depth;
+        endRun();
+        continue;
+      case u'.':
+      case u'^':
+      case u'$':
+      case u'*':
+      case u'+':
+      case u'?':
+        endRun();
+        continue;
+      case u'{': {
+        endRun();
+        const qsizetype close = source.indexOf(u'}', i);
+        if (close != -1) {
+          i = close;
+        }
+        continue;
+      }
+      default:
+        break;
+    }
+    if (depth != 0) {
+      continue;
+    }
+    const QChar next = i + 1 < size ? source[i + 1] : QChar();
+    if (next == u'?' || next == u'*' || next == u'{') {
+      endRun();
+      continue;
+    }
+    run.push_back(c);
+    if (next == u'+') {
+      endRun();
+    }
+  }
+  endRun();
+  return literals;
+}
+std::vector<quint64>
+requiredTrigrams(const QRegularExpression& pattern)
+{
+  std::vector<quint64> trigrams;
+  for (const QString& literal : requiredLiterals(pattern)) {
+    addTrigrams(literal, trigrams);
+  }
+  sortUnique(trigrams);
+  return trigrams;
+}
+
+// Truncates a list of matches to a limit, returning whether it was reached. A
+// negative limit is never reached.
+bool
+reachedLimit(QList<SearchIndex::Match>& matches, qsizetype limit)
+{
+  if (limit < 0 || matches.size() < limit) {
+    return false;
+  }
+  matches.resize(limit);
+  return true;
+}
+
+void
+appendMatches(const QTextBlock& block,
+               const QString& text,
+               Qt::CaseSensitivity caseSensitivity,
+               QList<SearchIndex::Match>& matches)
+{
+  const QString line = block.text();
+  const int length = static_cast<int>(text.size());
+  for (qsizetype i = line.indexOf(text, 0, caseSensitivity); i != -1;
+       i = line.indexOf(text, i + length, caseSensitivity)) {
+    matches.push_back({
+      .line = block.blockNumber(),
+      .column = static_cast<int>(i),
+      .position = block.position() + static_cast<int>(i),
+      .length = length,
+    });
+  }
+}
+
+void
+appendMatches(const QTextBlock& block,
+               const QRegularExpression& pattern,
+               QList<SearchIndex::Match>& matches)
+{
+  QRegularExpressionMatchIterator iter = pattern.globalMatch(block.text());
+  while (iter.hasNext()) {
+    const QRegularExpressionMatch match = iter.next();
+    const qsizetype length = match.capturedLength();
+    if (length == 0) {
+      continue;
+    }
+    const int column = static_cast<int>(match.capturedStart());
+    matches.push_back({
+      .line = block.blockNumber(),
+      .column = column,
+      .position = block.position() + column,
+      .length = static_cast<int>(length),
+    });
+  }
+}
+} // namespace
+
+// Public methods
+
+SearchIndex&
+SearchIndex::of(QTextDocument& document)
+{
+  SearchIndex* index =
+    document.findChild<SearchIndex*>(QString(), Qt::FindDirectChildrenOnly);
+  if (index == nullptr) {
+    index = new SearchIndex(document);
+  }
+  return *index;
+}
+
+SearchIndex::SearchIndex(QTextDocument& document)
+  : QObject(&document)
+  , blockCount(document.blockCount())
+  , document(document)
+{
+  connect(&document,
+          &QTextDocument::contentsChange,
+          this,
+          &SearchIndex::onContentsChange);
+}
+
+optional<SearchIndex::Match>
+SearchIndex::find(const QString& text,
+                  Qt::CaseSensitivity caseSensitivity,
+                  int position,
+                  bool backward)
+{
+  if (text.isEmpty()) {
+    return nullopt;
+  }
+  catchUp();
+  std::vector<Trigram> trigrams;
+  addTrigrams(text, trigrams);
+  sortUnique(trigrams);
+  return findFrom(
+    trigrams, position, backward, [&](const QTextBlock& block, auto& matches) {
+      appendMatches(block, text, caseSensitivity, matches);
+    });
+}
+
+optional<SearchIndex::Match>
+SearchIndex::find(const QRegularExpression& pattern, int position, bool backward)
+{
+  if (!pattern.isValid() || pattern.pattern().isEmpty()) {
+    return nullopt;
+  }
+  catchUp();
+  const std::vector<Trigram> trigrams = requiredTrigrams(pattern);
+  return findFrom(
+    trigrams, position, backward, [&](const QTextBlock& block, auto& matches) {
+      appendMatches(block, pattern, matches);
+    });
+}
+
+QTextBlock
+SearchIndex::findLine(LineId id) const
+{
+  if (id < base) {
+    return QTextBlock();
+  }
+  return document.findBlockByNumber(static_cast<int>(id - base));
+}
+
+SearchIndex::LineId
+SearchIndex::lineId(int blockNumber) const noexcept
+{
+  return base + static_cast<LineId>(blockNumber);
+}
+
+QList<SearchIndex::Match>
+SearchIndex::search(const QString& text,
+                    Qt::CaseSensitivity caseSensitivity,
+                    qsizetype limit)
+{
+  QList<Match> matches;
+  if (text.isEmpty() || limit == 0) {
+    return matches;
+  }
+  catchUp();
+  std::vector<Trigram> trigrams;
+  addTrigrams(text, trigrams);
+  sortUnique(trigrams);
+  forEachCandidate(trigrams, 0, false, [&](const QTextBlock& block) {
+    appendMatches(block, text, caseSensitivity, matches);
+    return !reachedLimit(matches, limit);
+  });
+  return matches;
+}
+
+QList<SearchIndex::Match>
+SearchIndex::search(const QRegularExpression& pattern, qsizetype limit)
+{
+  QList<Match> matches;
+  if (!pattern.isValid() || pattern.pattern().isEmpty() || limit == 0) {
+    return matches;
+  }
+  catchUp();
+  forEachCandidate(
+    requiredTrigrams(pattern), 0, false, [&](const QTextBlock& block) {
+      appendMatches(block, pattern, matches);
+      return !reachedLimit(matches, limit);
+    });
+  return matches;
+}
+
+// Private methods
+
+void
+SearchIndex::catchUp()
+{
+  const LineId end = base + static_cast<LineId>(blockCount);
+  dirtyBegin = std::max(dirtyBegin, base);
+  dirtyEnd = std::min(dirtyEnd, indexedEnd);
+  if (dirtyBegin < dirtyEnd) {
+    QTextBlock block = findLine(dirtyBegin);
+    for (LineId id = dirtyBegin; id < dirtyEnd && block.isValid(); ++id) {
+      indexBlock(block, id);
+      block = block.next();
+    }
+  }
+  dirtyBegin = dirtyEnd = 0;
+  indexedEnd = std::max(indexedEnd, base);
+  if (indexedEnd >= end) {
+    return;
+  }
+  QTextBlock block = findLine(indexedEnd);
+  for (LineId id = indexedEnd; id < end && block.isValid(); ++id) {
+    indexBlock(block, id);
+    block = block.next();
+  }
+  indexedEnd = end;
+}
+
+template<typename AppendMatches>
+optional<SearchIndex::Match>
+SearchIndex::findFrom(const std::vector<Trigram>& trigrams,
+                      int position,
+                      bool backward,
+                      AppendMatches&& appendMatches)
+{
+  optional<Match> found;
+  const int line = document.findBlock(position).blockNumber();
+  if (line == -1) {
+    return found;
+  }
+  QList<Match> matches;
+  forEachCandidate(trigrams, line, backward, [&](const QTextBlock& block) {
+    matches.clear();
+    appendMatches(block, matches);
+    if (backward) {
+      const auto iter =
+        std::find_if(matches.crbegin(), matches.crend(), [&](const Match& m) {
+          return m.position < position;
+        });
+      if (iter != matches.crend()) {
+        found = *iter;
+      }
+    } else {
+      const auto iter =
+        std::find_if(matches.cbegin(), matches.cend(), [&](const Match& m) {
+          return m.position >= position;
+        });
+      if (iter != matches.cend()) {
+        found = *iter;
+      }
+    }
+    return !found;
+  });
+  return found;
+}
+
+template<typename Visit>
+void
+SearchIndex::forEachCandidate(const std::vector<Trigram>& trigrams,
+                              int fromLine,
+                              bool backward,
+                              Visit&& visit)
+{
+  if (trigrams.empty()) {
+    for (QTextBlock block = document.findBlockByNumber(fromLine);
+         block.isValid();
+         block = backward ? block.previous() : block.next()) {
+      if (!visit(block)) {
+        return;
+      }
+    }
+    return;
+  }
+  std::vector<const std::vector<LineId>*> lists;
+  lists.reserve(trigrams.size());
+  for (Trigram trigram : trigrams) {
+    const auto search = postings.constFind(trigram);
+    if (search == postings.cend()) {
+      return;
+    }
+    lists.push_back(&search.value());
+  }
+  std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) {
+    return a->size() < b->size();
+  });
+  const std::vector<LineId>& smallest = *lists.front();
+  const auto visitIfContainsAll = [&lists, &visit, this](LineId id) {
+    const bool containsAll =
+      std::all_of(lists.begin() + 1, lists.end(), [id](const auto* list) {
+        return std::binary_search(list->begin(), list->end(), id);
+      });
+    if (!containsAll) {
+      return true;
+    }
+    const QTextBlock block = findLine(id);
+    return !block.isValid() || visit(block);
+  };
+  const LineId from = lineId(fromLine);
+  const auto first = std::lower_bound(smallest.begin(), smallest.end(), base);
+  const auto last = std::lower_bound(first, smallest.end(), lineId(blockCount));
+  if (backward) {
+    for (auto iter = std::upper_bound(first, last, from); iter != first;) {
+      if (!visitIfContainsAll(*--iter)) {
+        return;
+      }
+    }
+    return;
+  }
+  for (auto iter = std::lower_bound(first, last, from); iter != last; ++iter) {
+    if (!visitIfContainsAll(*iter)) {
+      return;
+    }
+  }
+}
+
+void
+SearchIndex::indexBlock(const QTextBlock& block, LineId id)
+{
+  std::vector<Trigram> trigrams;
+  addTrigrams(block.text(), trigrams);
+  sortUnique(trigrams);
+  for (Trigram trigram : trigrams) {
+    std::vector<LineId>& lines = postings[trigram];
+    if (lines.empty() || lines.back() < id) {
+      lines.push_back(id);
+      continue;
+    }
+    const auto iter = std::lower_bound(lines.begin(), lines.end(), id);
+    if (*iter != id) {
+      lines.insert(iter, id);
+    }
+  }
+}
+
+void
+SearchIndex::onContentsChange(int position, int /*removed*/, int added)
+{
+  const int newBlockCount = document.blockCount();
+  const int delta = newBlockCount - blockCount;
+  blockCount = newBlockCount;
+
+  if (position == 0 && delta < 0) {
+    // Lines were removed from the start of the document, most likely by its
+    // maximum block count. Lines after the change keep their IDs.
+    base += static_cast<LineId>(-delta);
+    trimmed -= delta;
+    if (trimmed > std::max(pruneThreshold, blockCount)) {
+      prune();
+    }
+  } else if (delta != 0) {
+    const int first = document.findBlock(position).blockNumber();
+    if (first != -1) {
+      indexedEnd = std::min(indexedEnd, base + static_cast<LineId>(first));
+    }
+    return;
+  }
+
+  const int lastPosition =
+    std::min(position + added, document.characterCount() - 1);
+  const int first = document.findBlock(position).blockNumber();
+  const int last = document.findBlock(lastPosition).blockNumber();
+  if (first == -1 || last == -1) {
+    return;
+  }
+  const LineId begin = base + static_cast<LineId>(first);
+  const LineId end = base + static_cast<LineId>(last) + 1;
+  if (dirtyBegin == dirtyEnd) {
+    dirtyBegin = begin;
+    dirtyEnd = end;
+    return;
+  }
+  dirtyBegin = std::min(dirtyBegin, begin);
+  dirtyEnd = std::max(dirtyEnd, end);
+}
+
+void
+SearchIndex::prune()
+{
+  trimmed = 0;
+  for (auto iter = postings.begin(); iter != postings.end();) {
+    std::vector<LineId>& lines = iter.value();
+    lines.erase(lines.begin(),
+                std::lower_bound(lines.begin(), lines.end(), base));
+    if (lines.empty()) {
+      iter = postings.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <optional>
+#include <vector>
+
+class QRegularExpression;
+class QTextBlock;
+class QTextDocument;
+
+// Trigram index over the lines of a document, for searching large output
+// buffers without testing every line. Each trigram of case-folded text maps to
+// the lines that contain it, so a search only has to test lines that contain
+// every trigram of the search text.
+//
+// The index is maintained incrementally. Lines removed from the start of the
+// document by a maximum block count are dropped from it. Edits within lines
+// mark those lines for reindexing, and edits that add or remove lines mark
+// every line after them, since their numbers change. Reindexing happens on the
+// next search. Stale entries can only produce extra candidates, which are
+// always verified against the current text of the line.
+class SearchIndex : public QObject
+{
+  Q_OBJECT
+
+public:
+  struct Match
+  {
+    // Block number of the line.
+    int line;
+    // Position of the start of the match within the line.
+    int column;
+    // Position of the start of the match within the document.
+    int position;
+    int length;
+  };
+
+  // Number of a line that stays the same when lines before it are removed from
+  // the start of the document.
+  using LineId = quint32;
+
+  // Returns the index of a document, creating one if necessary.
+  static SearchIndex& of(QTextDocument& document);
+
+  explicit SearchIndex(QTextDocument& document);
+
+  // Finds the first occurrence of text at or after a document position, or
+  // the last occurrence before it if backward is true. Lines are searched
+  // outward from the position, and the search stops at the first match.
+  std::optional<Match> find(const QString& text,
+                            Qt::CaseSensitivity caseSensitivity,
+                            int position,
+                            bool backward);
+  std::optional<Match> find(const QRegularExpression& pattern,
+                            int position,
+                            bool backward);
+  // Returns the line with an ID, or an invalid block if it has been removed.
+  QTextBlock findLine(LineId id) const;
+  LineId lineId(int blockNumber) const noexcept;
+  // Finds occurrences of text, in document order. Stops after limit matches
+  // if limit is not negative.
+  QList<Match> search(const QString& text,
+                      Qt::CaseSensitivity caseSensitivity,
+                      qsizetype limit = -1);
+  // Finds non-empty matches of a pattern, in document order. Patterns are
+  // prefiltered by literal text that every match must contain, if any.
+  QList<Match> search(const QRegularExpression& pattern, qsizetype limit = -1);
+
+private:
+  using Trigram = quint64;
+
+  void catchUp();
+  template<typename AppendMatches>
+  std::optional<Match> findFrom(const std::vector<Trigram>& trigrams,
+                                int position,
+                                bool backward,
+                                AppendMatches&& appendMatches);
+  // Calls visit on every line that may contain all of a set of trigrams,
+  // starting from a line and moving forward or backward, until it returns
+  // false.
+  template<typename Visit>
+  void forEachCandidate(const std::vector<Trigram>& trigrams,
+                        int fromLine,
+                        bool backward,
+                        Visit&& visit);
+  void indexBlock(const QTextBlock& block, LineId id);
+  void onContentsChange(int position, int removed, int added);
+  void prune();
+
+private:
+  // Line ID of the first block. IDs increase by one per block, and are not
+  // reused when lines are removed from the start of the document.
+  LineId base = 0;
+  int blockCount;
+  // Indexed lines that have been edited since.
+  LineId dirtyBegin = 0;
+  LineId dirtyEnd = 0;
+  QTextDocument& document;
+  // Lines from here on have not been indexed.
+  LineId indexedEnd = 0;
+  QHash<Trigram, std::vector<LineId>> postings;
+  // Lines removed from the start of the document since the last prune.
+  int trimmed = 0;
+};
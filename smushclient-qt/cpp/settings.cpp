@@ -218,6 +218,10 @@ SETTING(ConfirmQuit, bool, false, "closing/app");
 SETTING(DisplayConnect, bool, true, "connecting/display/connect");
 SETTING(DisplayDisconnect, bool, true, "connecting/display/disconnect");
 
+SETTING(FairScheduling, bool, false, "connecting/fairscheduling");
+
+SETTING(ImageCacheSize, int, 64, "images/cachesize");
+
 SETTING(InputBackground, QColor, Qt::white, "input/background");
 SETTING(InputFont, QFont, getDefaultFont(12), "input/font");
 SETTING(InputForeground, QColor, Qt::black, "input/foreground");
@@ -228,6 +232,8 @@ SETTING(LastFiles, QStringList, QStringList(), "startup/reopen");
 
 SETTING(LoggingEnabled, bool, true, "logging/enable");
 
+SETTING(MatchThreads, int, 1, "connecting/matchthreads");
+
 SETTING(NotepadFont, QFont, getDefaultFont(12), "notepad/font");
 SETTING(NotepadBackground, QColor, Qt::white, "notepad/background");
 SETTING(NotepadForeground, QColor, Qt::black, "notepad/foreground");
@@ -244,6 +250,8 @@ SETTING(OutputLines, int, 10000, "output/lines");
 SETTING(OutputLineSpacing, int, 100.0, "output/spacing");
 SETTING(OutputWrapping, bool, true, "output/wrap");
 
+SETTING(ReadBatchWindow, int, 0, "connecting/batchwindow");
+
 SETTING(ReconnectOnDisconnect, bool, false, "connecting/reconnect");
 
 SETTING(ScriptFont, QFont, getDefaultFont(12), "script/font");
@@ -48,6 +48,10 @@ public:
   bool getDisplayConnect() const;
   bool getDisplayDisconnect() const;
 
+  bool getFairScheduling() const;
+
+  int getImageCacheSize() const;
+
   QColor getInputBackground() const;
   QFont getInputFont() const;
   QColor getInputForeground() const;
@@ -59,6 +63,8 @@ public:
 
   bool getLoggingEnabled() const;
 
+  int getMatchThreads() const;
+
   QFont getNotepadFont() const;
   QColor getNotepadBackground() const;
   QColor getNotepadForeground() const;
@@ -77,6 +83,8 @@ public:
   int getOutputLineSpacing() const;
   bool getOutputWrapping() const;
 
+  int getReadBatchWindow() const;
+
   QStringList getRecentFiles() const;
   RecentFileResult addRecentFile(const QString& path);
   RecentFileResult removeRecentFile(const QString& path);
@@ -114,6 +122,10 @@ public slots:
   void setDisplayConnect(bool display);
   void setDisplayDisconnect(bool display);
 
+  void setFairScheduling(bool enabled);
+
+  void setImageCacheSize(int megabytes);
+
   void setInputBackground(const QColor& color);
   void setInputFont(const QFont& font);
   void setInputForeground(const QColor& color);
@@ -124,6 +136,8 @@ public slots:
 
   void setLoggingEnabled(bool enabled);
 
+  void setMatchThreads(int threads);
+
   void setNotepadFont(const QFont& font);
   void setNotepadBackground(const QColor& color);
   void setNotepadForeground(const QColor& color);
@@ -140,6 +154,8 @@ public slots:
   void setOutputLineSpacing(int spacing);
   void setOutputWrapping(bool wrapping);
 
+  void setReadBatchWindow(int millis);
+
   void setReconnectOnDisconnect(bool reconnect);
 
   void setScriptFont(const QFont& font);
@@ -1,5 +1,12 @@
 #include "finddialog.h"
+#include "../../searchindex.h"
+#include "findresults.h"
 #include "ui_finddialog.h"
+#include <QtWidgets/QPushButton>
+
+using std::optional;
+
+// Public methods
 
 FindDialog::FindDialog(QWidget* parent)
   : QDialog(parent)
@@ -7,6 +14,13 @@ FindDialog::FindDialog(QWidget* parent)
 {
   ui->setupUi(this);
   ui->Direction_Up->setChecked(true);
+  QPushButton* findAllButton =
+    ui->buttonBox->addButton(tr("Find &All"), QDialogButtonBox::ActionRole);
+  connect(findAllButton, &QPushButton::clicked, this, [this] {
+    readInputs();
+    findAll = true;
+    accept();
+  });
   hide();
 }
 
@@ -16,17 +30,43 @@ FindDialog::~FindDialog()
 }
 
 void
-FindDialog::find(QTextEdit* edit) const
+FindDialog::find(QTextEdit* edit)
 {
-  if (isRegex) {
-    edit->find(pattern, flags);
-  } else {
-    edit->find(text, flags);
+  SearchIndex& index = SearchIndex::of(*edit->document());
+  const Qt::CaseSensitivity caseSensitivity =
+    flags.testFlag(QTextDocument::FindCaseSensitively) ? Qt::CaseSensitive
+                                                       : Qt::CaseInsensitive;
+
+  if (findAll) {
+    findAll = false;
+    const QList<SearchIndex::Match> matches =
+      isRegex ? index.search(pattern) : index.search(text, caseSensitivity);
+    (new FindResults(edit, matches, edit->window()))->show();
+    return;
   }
+
+  const QTextCursor current = edit->textCursor();
+  const bool backward = flags.testFlag(QTextDocument::FindBackward);
+  const int position =
+    backward ? current.selectionStart() : current.selectionEnd();
+  const optional<SearchIndex::Match> found =
+    isRegex ? index.find(pattern, position, backward)
+            : index.find(text, caseSensitivity, position, backward);
+  if (!found) {
+    return;
+  }
+  QTextCursor cursor(edit->document());
+  cursor.setPosition(found->position);
+  cursor.setPosition(found->position + found->length,
+                     QTextCursor::MoveMode::KeepAnchor);
+  edit->setTextCursor(cursor);
+  edit->ensureCursorVisible();
 }
 
+// Private methods
+
 void
-FindDialog::on_buttonBox_accepted()
+FindDialog::readInputs()
 {
   flags.setFlag(QTextDocument::FindFlag::FindBackward,
                 ui->Direction_Up->isChecked());
@@ -36,10 +76,22 @@ FindDialog::on_buttonBox_accepted()
   text = ui->Find->text();
   m_filled = !text.isEmpty();
   if (isRegex && m_filled) {
-    pattern = QRegularExpression(text);
+    pattern = QRegularExpression(
+      text,
+      ui->MatchCase->isChecked() ? QRegularExpression::NoPatternOption
+                                 : QRegularExpression::CaseInsensitiveOption);
   }
 }
 
+// Private slots
+
+void
+FindDialog::on_buttonBox_accepted()
+{
+  readInputs();
+  findAll = false;
+}
+
 void
 FindDialog::on_buttonBox_rejected()
 {
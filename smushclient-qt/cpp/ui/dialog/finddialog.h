@@ -15,9 +15,14 @@ public:
   explicit FindDialog(QWidget* parent = nullptr);
   ~FindDialog() override;
 
-  void find(QTextEdit* edit) const;
+  // Selects the next match in an edit, or lists every match if the dialog
+  // was closed with Find All.
+  void find(QTextEdit* edit);
   bool filled() const noexcept { return m_filled; }
 
+private:
+  void readInputs();
+
 private slots:
   void on_buttonBox_accepted();
   void on_buttonBox_rejected();
@@ -27,6 +32,7 @@ private:
   QTextDocument::FindFlags flags;
   QRegularExpression pattern;
   QString text;
+  bool findAll = false;
   bool isRegex = false;
   bool m_filled = false;
 };
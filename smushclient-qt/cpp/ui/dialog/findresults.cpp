@@ -0,0 +1,64 @@
+#include "findresults.h"
+#include <QtGui/QTextBlock>
+#include <QtGui/QTextCursor>
+#include <QtWidgets/QListWidget>
+#include <QtWidgets/QTextEdit>
+#include <QtWidgets/QVBoxLayout>
+
+// Public methods
+
+FindResults::FindResults(QTextEdit* edit,
+                         const QList<SearchIndex::Match>& matches,
+                         QWidget* parent)
+  : QDialog(parent)
+  , edit(edit)
+  , index(&SearchIndex::of(*edit->document()))
+  , list(new QListWidget(this))
+{
+  setAttribute(Qt::WA_DeleteOnClose);
+  const int count = static_cast<int>(matches.size());
+  setWindowTitle(tr("%n match(es)", nullptr, count));
+  QVBoxLayout* layout = new QVBoxLayout(this);
+  layout->addWidget(list);
+  list->setUniformItemSizes(true);
+  results.reserve(matches.size());
+  QTextBlock block;
+  for (const SearchIndex::Match& match : matches) {
+    results.push_back({ .line = index->lineId(match.line),
+                        .column = match.column,
+                        .length = match.length });
+    if (!block.isValid() || block.blockNumber() != match.line) {
+      block = edit->document()->findBlockByNumber(match.line);
+    }
+    const QString line = block.text().trimmed();
+    list->addItem(tr("%1: %2").arg(match.line + 1).arg(line));
+  }
+  connect(list,
+          &QListWidget::itemActivated,
+          this,
+          &FindResults::onItemActivated);
+  resize(600, 400);
+}
+
+// Private slots
+
+void
+FindResults::onItemActivated(QListWidgetItem* item)
+{
+  const int row = list->row(item);
+  if (edit == nullptr || index == nullptr || row < 0 ||
+      static_cast<size_t>(row) >= results.size()) {
+    return;
+  }
+  const Result& result = results[row];
+  const QTextBlock block = index->findLine(result.line);
+  if (!block.isValid() || result.column + result.length >= block.length()) {
+    return;
+  }
+  QTextCursor cursor(block);
+  cursor.setPosition(block.position() + result.column);
+  cursor.setPosition(block.position() + result.column + result.length,
+                     QTextCursor::MoveMode::KeepAnchor);
+  edit->setTextCursor(cursor);
+  edit->ensureCursorVisible();
+}
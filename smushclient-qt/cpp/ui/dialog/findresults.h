@@ -0,0 +1,38 @@
+#pragma once
+#include "../../searchindex.h"
+#include <QtCore/QPointer>
+#include <QtWidgets/QDialog>
+#include <vector>
+
+class QListWidget;
+class QListWidgetItem;
+class QTextEdit;
+
+// Non-modal list of every match of a search. Activating a match selects it in
+// the searched text edit. Matches are kept by line ID, so they still find their
+// line after earlier lines are trimmed from the start of the document.
+class FindResults : public QDialog
+{
+  Q_OBJECT
+
+public:
+  FindResults(QTextEdit* edit,
+              const QList<SearchIndex::Match>& matches,
+              QWidget* parent = nullptr);
+
+private slots:
+  void onItemActivated(QListWidgetItem* item);
+
+private:
+  struct Result
+  {
+    SearchIndex::LineId line;
+    int column;
+    int length;
+  };
+
+  QPointer<QTextEdit> edit;
+  QPointer<SearchIndex> index;
+  QListWidget* list;
+  std::vector<Result> results;
+};
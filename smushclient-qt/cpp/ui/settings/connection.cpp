@@ -1,5 +1,6 @@
 #include "connection.h"
 #include "../../fieldconnector.h"
+#include "../../scripting/miniwindow/imagecache.h"
 #include "../../settings.h"
 #include "ui_connection.h"
 
@@ -12,9 +13,21 @@ SettingsConnecting::SettingsConnecting(Settings& settings, QWidget* parent)
   CONNECT_SETTINGS(ReconnectOnDisconnect);
   CONNECT_SETTINGS(DisplayConnect);
   CONNECT_SETTINGS(DisplayDisconnect);
+  CONNECT_SETTINGS(FairScheduling);
+  CONNECT_SETTINGS(ReadBatchWindow);
+  CONNECT_SETTINGS(MatchThreads);
+  CONNECT_SETTINGS(ImageCacheSize);
 }
 
 SettingsConnecting::~SettingsConnecting()
 {
   delete ui;
 }
+
+// Private slots
+
+void
+SettingsConnecting::on_ImageCacheSize_valueChanged(int size)
+{
+  ImageCache::global().setMaxBytes(static_cast<qsizetype>(size) * 1024 * 1024);
+}
@@ -15,6 +15,9 @@ public:
   explicit SettingsConnecting(Settings& settings, QWidget* parent = nullptr);
   ~SettingsConnecting() override;
 
+private slots:
+  void on_ImageCacheSize_valueChanged(int size);
+
 private:
   Ui::SettingsConnecting* ui;
 };
@@ -10,19 +10,42 @@
 
 using Qt::StringLiterals::operator""_L1;
 
+// Private utils
+
+namespace {
+// Filters senders with the model's search index, rather than by fetching and
+// comparing the text of every cell.
+class SenderFilterModel : public QSortFilterProxyModel
+{
+public:
+  SenderFilterModel(AbstractSenderModel& model, QObject* parent)
+    : QSortFilterProxyModel(parent)
+    , model(model)
+  {
+  }
+
+protected:
+  bool filterAcceptsRow(int row, const QModelIndex& parent) const override
+  {
+    return model.filterAcceptsRow(row, parent);
+  }
+
+private:
+  AbstractSenderModel& model;
+};
+} // namespace
+
 // Public methods
 
 AbstractPrefsTree::AbstractPrefsTree(AbstractSenderModel& model,
                                      QWidget* parent)
   : QWidget(parent)
   , model(model)
-  , proxy(new QSortFilterProxyModel(this))
+  , proxy(new SenderFilterModel(model, this))
 {
 
   proxy->setSourceModel(&model);
-  proxy->setFilterCaseSensitivity(Qt::CaseSensitivity::CaseInsensitive);
   proxy->setRecursiveFilteringEnabled(true);
-  proxy->setFilterKeyColumn(-1);
 }
 
 AbstractPrefsTree::~AbstractPrefsTree()
@@ -93,7 +116,8 @@ AbstractPrefsTree::on_remove_clicked()
 void
 AbstractPrefsTree::on_search_textChanged(const QString& text)
 {
-  proxy->setFilterFixedString(text);
+  model.setFilter(text);
+  proxy->invalidate();
   if (filtering == !text.isEmpty()) {
     return;
   }
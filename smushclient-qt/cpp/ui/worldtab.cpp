@@ -31,6 +31,7 @@
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QMenu>
 #include <QtWidgets/QMessageBox>
+#include <limits>
 
 using std::nullopt;
 using std::string_view;
@@ -41,6 +42,11 @@ using Qt::StringLiterals::operator""_L1;
 constexpr const Qt::KeyboardModifiers numpadMods =
   Qt::KeyboardModifier::ControlModifier | Qt::KeyboardModifier::MetaModifier;
 
+// With fair scheduling, a world reads at most this many bytes per event loop
+// pass before yielding to other worlds.
+constexpr size_t readSlice = 16384;
+constexpr size_t noReadLimit = std::numeric_limits<size_t>::max();
+
 // Private utilities
 
 namespace {
@@ -68,7 +74,9 @@ WorldTab::WorldTab(const QTextCursor& infoCursor,
       new QAction(QIcon::fromTheme(QIcon::ThemeIcon::HelpFaq),
                   tr("Text Attributes"),
                   this))
+  , batchTimer(new QTimer(this))
   , flushTimer(new QTimer(this))
+  , readTimer(new QTimer(this))
   , resizeTimer(new QTimer(this))
   , scriptReloadOption(ScriptRecompile::Never)
 #ifdef QT_NO_SSL
@@ -96,10 +104,17 @@ WorldTab::WorldTab(const QTextCursor& infoCursor,
   connect(socket, &QSslSocket::errorOccurred, this, &WorldTab::onSocketError);
 #endif
 
+  batchTimer->setSingleShot(true);
+  connect(batchTimer, &QTimer::timeout, this, &WorldTab::drainOutput);
+
   flushTimer->setInterval(milliseconds{ 2000 });
   flushTimer->setSingleShot(true);
   connect(flushTimer, &QTimer::timeout, this, &WorldTab::flushOutput);
 
+  readTimer->setInterval(0);
+  readTimer->setSingleShot(true);
+  connect(readTimer, &QTimer::timeout, this, &WorldTab::readFromSocket);
+
   resizeTimer->setInterval(milliseconds{ 100 });
   resizeTimer->setSingleShot(true);
   connect(resizeTimer, &QTimer::timeout, this, &WorldTab::finishResize);
@@ -747,7 +762,11 @@ void
 WorldTab::handleConnect()
 {
   client.handleConnect(*socket);
-  if (Settings().getDisplayConnect()) {
+  const Settings settings;
+  fairScheduling = settings.getFairScheduling();
+  batchTimer->setInterval(settings.getReadBatchWindow());
+  client.setMatchThreads(static_cast<size_t>(settings.getMatchThreads()));
+  if (settings.getDisplayConnect()) {
     const QString format = tr("'Connected on' dddd, MMMM d, yyyy 'at' h:mm AP");
     MudCursor* cursor = ui->output->cursor();
     cursor->appendText(QDateTime::currentDateTime().toString(format));
@@ -850,6 +869,16 @@ WorldTab::saveWorldAndState(const QString& path)
   return true;
 }
 
+void
+WorldTab::scheduleFlush()
+{
+  if (client.hasOutput()) {
+    flushTimer->start();
+  } else {
+    flushTimer->stop();
+  }
+}
+
 void
 WorldTab::setupWorldScriptWatcher()
 {
@@ -946,6 +975,15 @@ WorldTab::confirmReloadWorldScript(const QString& worldScriptPath)
   api->reloadWorldScript(worldScriptPath);
 }
 
+void
+WorldTab::drainOutput()
+{
+  const ActionSource currentSource = api->setSource(ActionSource::TriggerFired);
+  client.drain(*document);
+  api->setSource(currentSource);
+  scheduleFlush();
+}
+
 void
 WorldTab::finishResize()
 {
@@ -1073,13 +1111,23 @@ WorldTab::onSocketError(QAbstractSocket::SocketError socketError)
 void
 WorldTab::readFromSocket()
 {
+  // With a batch window, triggers run once the window closes instead of after
+  // every packet.
+  const bool batching = batchTimer->interval() != 0;
   const ActionSource currentSource = api->setSource(ActionSource::TriggerFired);
-  client.read(*socket, *document);
+  client.read(*socket,
+              *document,
+              fairScheduling ? readSlice : noReadLimit,
+              !batching);
   api->setSource(currentSource);
-  if (client.hasOutput()) {
-    flushTimer->start();
-  } else {
-    flushTimer->stop();
+  if (fairScheduling && socket->bytesAvailable() != 0) {
+    // Let the event loop serve other worlds before reading the rest.
+    readTimer->start();
+  }
+  if (!batching) {
+    scheduleFlush();
+  } else if (!batchTimer->isActive()) {
+    batchTimer->start();
   }
 }
 
@@ -129,6 +129,7 @@ private:
   bool restoreHistory();
   bool saveHistory() const;
   bool saveWorldAndState(const QString& filePath);
+  void scheduleFlush();
   void setupWorldScriptWatcher();
   void showAliasMenu();
   QStringList splitCommands(const QString& input) const;
@@ -136,6 +137,7 @@ private:
 
 private slots:
   void confirmReloadWorldScript(const QString& worldScriptPath);
+  void drainOutput();
   void finishResize();
   void flushOutput();
   void loadPlugins();
@@ -166,6 +168,7 @@ private:
   QAction* actionTextAttributes;
   ScriptApi* api;
   QMetaObject::Connection autoScroll;
+  QTimer* batchTimer;
   SmushClient client;
   Document* document;
   QString filePath;
@@ -174,6 +177,7 @@ private:
   QString m_title;
   std::optional<CallbackTrigger> onDragMove = std::nullopt;
   QPointer<Hotspot> onDragRelease = nullptr;
+  QTimer* readTimer;
   QTimer* resizeTimer;
   ScriptRecompile scriptReloadOption;
 #ifdef QT_NO_SSL
@@ -189,6 +193,7 @@ private:
   QFileSystemWatcher worldScriptWatcher;
   bool alertNewActivity : 1 = false;
   bool commandStackDelay : 1 = false;
+  bool fairScheduling : 1 = false;
   bool handleKeypad : 1 = false;
   bool initialized : 1 = false;
   bool inputCopyAvailable : 1 = false;
@@ -10,7 +10,5 @@ public:
   {
   }
 
-  virtual void startSendTimer(size_t index,
-                              uint16_t timerId,
-                              unsigned int millis) const = 0;
+  virtual void armTimer(int64_t millis) const = 0;
 };
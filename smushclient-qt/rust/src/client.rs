@@ -4,8 +4,8 @@ use std::fs::File;
 use std::io::{self, Write};
 use std::path::Path;
 use std::pin::Pin;
-use std::rc::Rc;
 
+use chrono::{DateTime, Utc};
 use cxx_qt::casting::Downcast;
 use cxx_qt_io::{QAbstractSocket, QIODevice, QNetworkProxy, QNetworkProxyProxyType, QSslSocket};
 use cxx_qt_lib::{QString, QStringList, QVariant};
@@ -13,8 +13,7 @@ use flagset::FlagSet;
 use mud_transformer::{ByteSet, Tag, opt};
 use smushclient::world::PersistError;
 use smushclient::{
-    AliasOutcome, CommandSource, Handler, SmushClient, TimerFinish, TimerStart, Timers, World,
-    WorldConfig,
+    AliasOutcome, CommandSource, Handler, ReadBuffer, SmushClient, Timers, World, WorldConfig,
 };
 use smushclient_plugins::{ImportError, LoadError, PluginIndex, SenderAccessError, Timer};
 
@@ -23,13 +22,11 @@ use crate::get_info::InfoVisitorQVariant;
 use crate::handler::ClientHandler;
 use crate::text_formatter::TextFormatter;
 
-const BUF_LEN: usize = 1024 * 20;
-
 pub struct SmushClientRust {
     pub client: SmushClient,
-    read_buf: RefCell<Box<[u8]>>,
+    read_buf: RefCell<ReadBuffer>,
     stats: RefCell<HashSet<String>>,
-    timers: RefCell<Timers<ffi::SendTimer>>,
+    timers: RefCell<Timers>,
     formatter: TextFormatter,
 }
 
@@ -39,7 +36,7 @@ impl Default for SmushClientRust {
     /// Panics if audio initialization fails.
     fn default() -> Self {
         Self {
-            read_buf: RefCell::new(vec![0; BUF_LEN].into_boxed_slice()),
+            read_buf: RefCell::new(ReadBuffer::default()),
             stats: RefCell::new(HashSet::new()),
             timers: RefCell::new(Timers::new()),
             formatter: TextFormatter::default(),
@@ -107,12 +104,7 @@ impl SmushClientRust {
     }
 
     pub fn load_variables<P: AsRef<Path>>(&self, path: P) -> Result<bool, PersistError> {
-        let file = match File::open(path) {
-            Err(err) if err.kind() == io::ErrorKind::NotFound => return Ok(false),
-            file => file?,
-        };
-        self.client.load_variables(file)?;
-        Ok(true)
+        self.client.load_variables(path)
     }
 
     pub fn save_state<P: AsRef<Path>>(
@@ -120,16 +112,14 @@ impl SmushClientRust {
         index: PluginIndex,
         path: P,
     ) -> Result<(), PersistError> {
-        let file = File::create(path)?;
-        self.client.save_variables_for(file, index)
+        self.client.save_variables_for(path, index)
     }
 
     pub fn save_variables<P: AsRef<Path>>(&self, path: P) -> Result<bool, PersistError> {
         if !self.client.has_variables() {
             return Ok(false);
         }
-        let file = File::create(path)?;
-        self.client.save_all_variables(file)?;
+        self.client.save_all_variables(path)?;
         Ok(true)
     }
 
@@ -197,6 +187,13 @@ impl SmushClientRust {
         self.client.alias(command, source, &mut self.handler(doc))
     }
 
+    pub fn drain(&self, doc: Pin<&mut ffi::Document>) {
+        let mut handler = self.handler(doc);
+        if self.client.drain_output(&mut handler) {
+            handler.set_had_output();
+        }
+    }
+
     pub fn flush(&self, doc: Pin<&mut ffi::Document>) {
         let mut handler = self.handler(doc);
         if self.client.flush_output(&mut handler) {
@@ -208,10 +205,16 @@ impl SmushClientRust {
         self.client.invoke_alias(index, id, &mut self.handler(doc))
     }
 
-    pub fn read(&self, socket: Pin<&mut QAbstractSocket>, doc: Pin<&mut ffi::Document>) -> i64 {
-        let io_result = self.handle_socket_read(socket);
+    pub fn read(
+        &self,
+        socket: Pin<&mut QAbstractSocket>,
+        doc: Pin<&mut ffi::Document>,
+        limit: usize,
+        drain: bool,
+    ) -> i64 {
+        let io_result = self.handle_socket_read(socket, limit);
         let mut handler = self.handler(doc);
-        if self.client.drain_output(&mut handler) {
+        if drain && self.client.drain_output(&mut handler) {
             handler.set_had_output();
         }
         #[allow(clippy::cast_possible_truncation, clippy::cast_possible_wrap)]
@@ -267,10 +270,16 @@ impl SmushClientRust {
         self.client.reset_connection();
     }
 
-    fn handle_socket_read(&self, mut socket: Pin<&mut QAbstractSocket>) -> io::Result<usize> {
+    fn handle_socket_read(
+        &self,
+        mut socket: Pin<&mut QAbstractSocket>,
+        limit: usize,
+    ) -> io::Result<usize> {
+        let mut read_buf = self.read_buf.borrow_mut();
         let n = self
             .client
-            .read(&mut socket, &mut self.read_buf.borrow_mut())?;
+            .read_at_most(&mut socket, read_buf.as_mut_slice(), limit)?;
+        read_buf.record(n);
         self.client.write(&mut socket)?;
         Ok(n)
     }
@@ -283,7 +292,7 @@ impl SmushClientRust {
     }
 
     pub fn timer_info(&self, index: PluginIndex, label: &str, info_type: i64) -> QVariant {
-        self.client.timer_info::<InfoVisitorQVariant, _>(
+        self.client.timer_info::<InfoVisitorQVariant>(
             index,
             label,
             info_type,
@@ -298,99 +307,161 @@ impl SmushClientRust {
 
     // Timers
 
-    pub fn add_timer(
-        &self,
-        index: PluginIndex,
-        timer: Timer,
-    ) -> Result<Option<TimerStart>, SenderAccessError> {
+    pub fn add_timer(&self, index: PluginIndex, timer: Timer) -> Result<(), SenderAccessError> {
         let timer = self.client.add_sender(index, timer)?;
-        if !self.client.borrow_world().enable_timers {
-            return Ok(None);
+        if self.client.borrow_world().enable_timers {
+            self.timers.borrow_mut().start(index, &timer);
         }
-        Ok(self.timers.borrow_mut().start(index, &timer))
+        Ok(())
     }
 
-    pub fn add_or_replace_timer(&self, index: PluginIndex, timer: Timer) -> Option<TimerStart> {
+    pub fn add_or_replace_timer(&self, index: PluginIndex, timer: Timer) {
         let timer = self.client.add_or_replace_sender(index, timer);
-        if !self.client.borrow_world().enable_timers {
-            return None;
+        if self.client.borrow_world().enable_timers {
+            self.timers.borrow_mut().start(index, &timer);
         }
-        self.timers.borrow_mut().start(index, &timer)
     }
 
-    pub fn finish_timer(&self, id: usize) -> TimerFinish<ffi::SendTimer> {
-        self.timers.borrow_mut().finish(id, &self.client)
+    pub fn next_timer_deadline(&self) -> Option<DateTime<Utc>> {
+        self.timers.borrow_mut().next_deadline()
     }
 
-    pub fn poll_timers(&self) -> Vec<Rc<ffi::SendTimer>> {
-        self.timers.borrow_mut().poll(&self.client)
+    pub fn poll_timers(&self) -> Vec<ffi::SendTimer> {
+        self.timers.borrow_mut().poll(&self.client, Utc::now())
     }
 
-    pub fn import_world_timers<'a, I>(&self, imports: I) -> Vec<TimerStart>
+    pub fn import_world_timers<'a, I>(&self, imports: I)
     where
         I: IntoIterator<Item = &'a Timer>,
     {
         if !self.client.borrow_world().enable_timers {
-            return Vec::new();
+            return;
         }
         let world_index = self.world_plugin_index();
         let mut timers = self.timers.borrow_mut();
-        imports
-            .into_iter()
-            .filter_map(|timer| timers.start(world_index, timer))
-            .collect()
+        for timer in imports {
+            timers.start(world_index, timer);
+        }
     }
 
     pub fn replace_world_timer(
         &self,
         index: usize,
         timer: Timer,
-    ) -> (Result<usize, ffi::ReplaceSenderResult>, Option<TimerStart>) {
+    ) -> Result<usize, ffi::ReplaceSenderResult> {
         let group = timer.group.clone();
-        let (i, timer) = match self.client.replace_world_sender(index, timer) {
-            Ok(result) => result,
-            Err(e) => return (Err(e.into()), None),
-        };
-        let result = if timer.group == group {
+        let (i, timer) = self.client.replace_world_sender(index, timer)?;
+        if self.client.borrow_world().enable_timers {
+            let world_index = self.world_plugin_index();
+            self.timers.borrow_mut().start(world_index, &timer);
+        }
+        if timer.group == group {
             Ok(i)
         } else {
             Err(ffi::ReplaceSenderResult::GroupChanged)
+        }
+    }
+
+    /// Reschedules a timer after it has been enabled, disabled, or edited.
+    pub fn restart_timer(&self, index: PluginIndex, label: &str) {
+        let Some(timer) = self.client.borrow_sender::<Timer>(index, label) else {
+            return;
         };
-        if !self.client.borrow_world().enable_timers {
-            return (result, None);
+        let mut timers = self.timers.borrow_mut();
+        if self.client.borrow_world().enable_timers {
+            timers.start(index, &timer);
+        } else {
+            timers.stop(timer.id);
         }
-        let world_index = self.world_plugin_index();
-        (result, self.timers.borrow_mut().start(world_index, &timer))
     }
 
-    pub fn start_all_timers(&self) -> Vec<TimerStart> {
-        if !self.client.borrow_world().enable_timers {
-            return Vec::new();
+    pub fn restart_timer_group(&self, index: PluginIndex, group: &str) {
+        let enable_timers = self.client.borrow_world().enable_timers;
+        let mut timers = self.timers.borrow_mut();
+        for timer in self.client.senders::<Timer>(index).borrow().iter() {
+            if timer.group != group {
+                continue;
+            }
+            if enable_timers {
+                timers.start(index, timer);
+            } else {
+                timers.stop(timer.id);
+            }
         }
-        let mut timer_starts = Vec::new();
+    }
+
+    /// Forgets timers that have been deleted.
+    pub fn remove_timers<I: IntoIterator<Item = u16>>(&self, ids: I) {
         let mut timers = self.timers.borrow_mut();
-        for (index, plugin_timers) in self.client.all_senders::<Timer>().enumerate() {
-            timer_starts.extend(
-                plugin_timers
+        for id in ids {
+            timers.remove(id);
+        }
+    }
+
+    pub fn remove_timer(&self, index: PluginIndex, label: &str) -> Result<(), SenderAccessError> {
+        let id = self
+            .client
+            .borrow_sender::<Timer>(index, label)
+            .ok_or(SenderAccessError::NotFound)?
+            .id;
+        self.client.remove_sender::<Timer>(index, label)?;
+        self.timers.borrow_mut().remove(id);
+        Ok(())
+    }
+
+    pub fn remove_timer_group(&self, index: PluginIndex, group: &str) -> usize {
+        let ids: Vec<u16> = self
+            .client
+            .senders::<Timer>(index)
+            .borrow()
+            .iter()
+            .filter(|timer| timer.group == group)
+            .map(|timer| timer.id)
+            .collect();
+        let removed = self.client.remove_sender_group::<Timer>(index, group);
+        self.remove_timers(ids);
+        removed
+    }
+
+    pub fn remove_temporary_timers(&self) -> usize {
+        let ids: Vec<u16> = self
+            .client
+            .all_senders::<Timer>()
+            .flat_map(|timers| {
+                timers
                     .borrow()
                     .iter()
-                    .filter_map(|timer| timers.start(index, timer)),
-            );
+                    .filter(|timer| timer.temporary)
+                    .map(|timer| timer.id)
+                    .collect::<Vec<_>>()
+            })
+            .collect();
+        let removed = self.client.remove_temporary_senders::<Timer>();
+        self.remove_timers(ids);
+        removed
+    }
+
+    pub fn start_all_timers(&self) {
+        let mut timers = self.timers.borrow_mut();
+        if !self.client.borrow_world().enable_timers {
+            timers.clear();
+            return;
+        }
+        for (index, plugin_timers) in self.client.all_senders::<Timer>().enumerate() {
+            for timer in plugin_timers.borrow().iter() {
+                timers.start(index, timer);
+            }
         }
-        timer_starts
     }
 
-    pub fn start_timers(&self, index: PluginIndex) -> Vec<TimerStart> {
+    pub fn start_timers(&self, index: PluginIndex) {
         if !self.client.borrow_world().enable_timers {
-            return Vec::new();
+            return;
         }
         let mut timers = self.timers.borrow_mut();
-        self.client
-            .senders::<Timer>(index)
-            .borrow()
-            .iter()
-            .filter_map(|timer| timers.start(index, timer))
-            .collect()
+        for timer in self.client.senders::<Timer>(index).borrow().iter() {
+            timers.start(index, timer);
+        }
     }
 
     // Color
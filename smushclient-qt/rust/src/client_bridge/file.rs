@@ -40,10 +40,10 @@ impl ffi::SmushClient {
     ) -> ffi::ParseResult {
         let timers: Vec<Timer> = try_xml!(xml);
         let rust = self.rust();
-        for timer in rust.import_world_timers(&timers) {
-            timekeeper.start(&timer);
-        }
-        rust.client.world_plugin().import_senders(timers).into()
+        rust.import_world_timers(&timers);
+        let result: ffi::ParseResult = rust.client.world_plugin().import_senders(timers).into();
+        self.arm_timekeeper(timekeeper);
+        result
     }
 
     pub fn import_world_triggers(&self, xml: &QString) -> ffi::ParseResult {
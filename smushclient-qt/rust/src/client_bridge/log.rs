@@ -52,6 +52,27 @@ impl ffi::SmushClient {
         }
     }
 
+    pub fn start_recording(&self, path: StringView) -> ApiCode {
+        let Ok(path) = path.to_str() else {
+            return ApiCode::FileNotFound;
+        };
+        match self.rust().client.start_recording(path) {
+            Ok(()) => ApiCode::OK,
+            Err(_) => ApiCode::CouldNotOpenFile,
+        }
+    }
+
+    pub fn stop_recording(&self) -> ApiCode {
+        let client = &self.rust().client;
+        if !client.is_recording() {
+            return ApiCode::LogFileNotOpen;
+        }
+        match client.stop_recording() {
+            Ok(()) => ApiCode::OK,
+            Err(_) => ApiCode::LogFileBadWrite,
+        }
+    }
+
     pub fn try_close_log(&self) -> io::Result<()> {
         self.rust().client.close_log()
     }
@@ -15,6 +15,10 @@ impl ffi::SmushClient {
         self.rust().connect_to_host(socket);
     }
 
+    pub fn drain(&self, doc: Pin<&mut ffi::Document>) {
+        self.rust().drain(doc);
+    }
+
     pub fn flush(&self, doc: Pin<&mut ffi::Document>) {
         self.rust().flush(doc);
     }
@@ -35,11 +39,17 @@ impl ffi::SmushClient {
         &self,
         device: Pin<&mut ffi::QAbstractSocket>,
         doc: Pin<&mut ffi::Document>,
+        limit: usize,
+        drain: bool,
     ) -> i64 {
-        self.rust().read(device, doc)
+        self.rust().read(device, doc, limit, drain)
     }
 
     pub fn reset_mxp(&self) {
         self.rust().client.reset_mxp();
     }
+
+    pub fn set_match_threads(self: Pin<&mut Self>, threads: usize) {
+        self.rust_mut().client.set_match_threads(threads);
+    }
 }
@@ -82,7 +82,19 @@ impl ffi::SmushClient {
         let client = &self.rust().client;
         match kind {
             SenderKind::Alias => inner::<Alias>(client, opt, value).code(),
-            SenderKind::Timer => inner::<Timer>(client, opt, value).code(),
+            SenderKind::Timer => {
+                let schedule = |client: &SmushClient| {
+                    client
+                        .borrow_sender::<Timer>(opt.index, opt.label)
+                        .map(|timer| (timer.enabled, timer.occurrence))
+                };
+                let before = schedule(client);
+                let code = inner::<Timer>(client, opt, value).code();
+                if schedule(client) != before {
+                    self.rust().restart_timer(opt.index, opt.label);
+                }
+                code
+            }
             SenderKind::Trigger => inner::<Trigger>(client, opt, value).code(),
             _ => ApiCode::BadParameter,
         }
@@ -2,7 +2,7 @@ use std::cell::Ref;
 use std::pin::Pin;
 
 use cxx_qt::CxxQtType;
-use cxx_qt_lib::{QString, QVariant};
+use cxx_qt_lib::{QSet, QString, QVariant};
 use smushclient::SmushClient;
 use smushclient_plugins::{
     Alias, PluginIndex, PluginSender, Reaction, RegexError, Sender, Timer, Trigger,
@@ -35,9 +35,7 @@ impl ffi::SmushClient {
         timekeeper: &ffi::Timekeeper,
     ) -> ApiCode {
         let result = self.rust().add_timer(index, timer.rust().into());
-        if let Ok(Some(timer)) = &result {
-            timekeeper.start(timer);
-        }
+        self.arm_timekeeper(timekeeper);
         result.code::<Timer>()
     }
 
@@ -91,14 +89,6 @@ impl ffi::SmushClient {
         menu
     }
 
-    pub fn finish_timer(self: Pin<&mut Self>, id: usize) -> bool {
-        let result = self.rust().finish_timer(id);
-        if let Some(timer) = result.timer {
-            self.timer_sent(&timer);
-        }
-        result.done
-    }
-
     pub fn get_alias_wildcard(
         &self,
         index: PluginIndex,
@@ -137,10 +127,16 @@ impl ffi::SmushClient {
         }
     }
 
-    pub fn poll_timers(mut self: Pin<&mut Self>) {
-        for timer in self.rust().poll_timers() {
-            self.as_mut().timer_sent(&timer);
+    pub fn poll_timers(mut self: Pin<&mut Self>, timekeeper: &ffi::Timekeeper) {
+        let fired = self.rust().poll_timers();
+        for timer in &fired {
+            self.as_mut().timer_sent(timer);
         }
+        self.arm_timekeeper(timekeeper);
+    }
+
+    pub fn arm_timekeeper(&self, timekeeper: &ffi::Timekeeper) {
+        timekeeper.arm(self.rust().next_timer_deadline());
     }
 
     pub fn remove_sender(
@@ -155,7 +151,7 @@ impl ffi::SmushClient {
         let client = &self.rust().client;
         match kind {
             SenderKind::Alias => client.remove_sender::<Alias>(index, name).code::<Alias>(),
-            SenderKind::Timer => client.remove_sender::<Timer>(index, name).code::<Timer>(),
+            SenderKind::Timer => self.rust().remove_timer(index, name).code::<Timer>(),
             SenderKind::Trigger => client
                 .remove_sender::<Trigger>(index, name)
                 .code::<Trigger>(),
@@ -175,7 +171,7 @@ impl ffi::SmushClient {
         let client = &self.rust().client;
         match kind {
             SenderKind::Alias => client.remove_sender_group::<Alias>(index, name),
-            SenderKind::Timer => client.remove_sender_group::<Timer>(index, name),
+            SenderKind::Timer => self.rust().remove_timer_group(index, name),
             SenderKind::Trigger => client.remove_sender_group::<Trigger>(index, name),
             _ => 0,
         }
@@ -187,7 +183,7 @@ impl ffi::SmushClient {
         };
         let client = &self.rust().client;
         client.remove_sender_group::<Alias>(index, name)
-            + client.remove_sender_group::<Timer>(index, name)
+            + self.rust().remove_timer_group(index, name)
             + client.remove_sender_group::<Trigger>(index, name)
     }
 
@@ -195,7 +191,7 @@ impl ffi::SmushClient {
         let client = &self.rust().client;
         match kind {
             SenderKind::Alias => client.remove_temporary_senders::<Alias>(),
-            SenderKind::Timer => client.remove_temporary_senders::<Timer>(),
+            SenderKind::Timer => self.rust().remove_temporary_timers(),
             SenderKind::Trigger => client.remove_temporary_senders::<Trigger>(),
             _ => 0,
         }
@@ -214,9 +210,8 @@ impl ffi::SmushClient {
         timer: &ffi::Timer,
         timekeeper: &ffi::Timekeeper,
     ) -> ApiCode {
-        if let Some(timer) = self.rust().add_or_replace_timer(index, timer.rust().into()) {
-            timekeeper.start(&timer);
-        }
+        self.rust().add_or_replace_timer(index, timer.rust().into());
+        self.arm_timekeeper(timekeeper);
         ApiCode::OK
     }
 
@@ -238,12 +233,10 @@ impl ffi::SmushClient {
         timer: &ffi::Timer,
         timekeeper: &ffi::Timekeeper,
     ) -> i32 {
-        let (result, timer) = self
+        let result = self
             .rust()
             .replace_world_timer(index, Timer::from(&**timer));
-        if let Some(timer) = timer {
-            timekeeper.start(&timer);
-        }
+        self.arm_timekeeper(timekeeper);
         result.code()
     }
 
@@ -305,7 +298,11 @@ impl ffi::SmushClient {
         let client = &self.rust().client;
         match kind {
             SenderKind::Alias => set_sender_enabled::<Alias>(client, index, label, enabled),
-            SenderKind::Timer => set_sender_enabled::<Timer>(client, index, label, enabled),
+            SenderKind::Timer => {
+                let code = set_sender_enabled::<Timer>(client, index, label, enabled);
+                self.rust().restart_timer(index, label);
+                code
+            }
             SenderKind::Trigger => set_sender_enabled::<Trigger>(client, index, label, enabled),
             _ => ApiCode::BadParameter,
         }
@@ -324,7 +321,11 @@ impl ffi::SmushClient {
         let client = &self.rust().client;
         match kind {
             SenderKind::Alias => client.set_sender_group_enabled::<Alias>(index, group, enabled),
-            SenderKind::Timer => client.set_sender_group_enabled::<Timer>(index, group, enabled),
+            SenderKind::Timer => {
+                let count = client.set_sender_group_enabled::<Timer>(index, group, enabled);
+                self.rust().restart_timer_group(index, group);
+                count
+            }
             SenderKind::Trigger => {
                 client.set_sender_group_enabled::<Trigger>(index, group, enabled)
             }
@@ -342,9 +343,11 @@ impl ffi::SmushClient {
             return 0;
         };
         let client = &self.rust().client;
-        client.set_sender_group_enabled::<Alias>(index, group, enabled)
+        let count = client.set_sender_group_enabled::<Alias>(index, group, enabled)
             + client.set_sender_group_enabled::<Timer>(index, group, enabled)
-            + client.set_sender_group_enabled::<Trigger>(index, group, enabled)
+            + client.set_sender_group_enabled::<Trigger>(index, group, enabled);
+        self.rust().restart_timer_group(index, group);
+        count
     }
 
     pub fn simulate(&self, line: StringView<'_>, doc: Pin<&mut ffi::Document>) {
@@ -352,15 +355,17 @@ impl ffi::SmushClient {
     }
 
     pub fn start_all_timers(&self, timekeeper: &ffi::Timekeeper) {
-        for timer in &self.rust().start_all_timers() {
-            timekeeper.start(timer);
-        }
+        self.rust().start_all_timers();
+        self.arm_timekeeper(timekeeper);
     }
 
     pub fn start_timers(&self, index: PluginIndex, timekeeper: &ffi::Timekeeper) {
-        for timer in &self.rust().start_timers(index) {
-            timekeeper.start(timer);
-        }
+        self.rust().start_timers(index);
+        self.arm_timekeeper(timekeeper);
+    }
+
+    pub fn remove_timers(&self, ids: &QSet<u16>) {
+        self.rust().remove_timers(ids.iter().copied());
     }
 
     pub fn stop_senders(&self, kind: SenderKind) {
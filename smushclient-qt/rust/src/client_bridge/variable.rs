@@ -95,13 +95,13 @@ impl ffi::SmushClient {
         let Ok(key) = key.to_str() else {
             return false;
         };
-        self.rust().client.unset_metavariable(key).is_some()
+        self.rust().client.unset_metavariable(key)
     }
 
     pub fn unset_variable(&self, index: PluginIndex, key: StringView<'_>) -> bool {
         let Ok(key) = key.to_str() else {
             return false;
         };
-        self.rust().client.unset_variable(index, key).is_some()
+        self.rust().client.unset_variable(index, key)
     }
 }
@@ -6,6 +6,8 @@ pub mod ffi {
     extern "C++" {
         include!("cxx-qt-lib/qcolor.h");
         type QColor = cxx_qt_lib::QColor;
+        include!("cxx-qt-lib/qset.h");
+        type QSet_u16 = cxx_qt_lib::QSet<u16>;
         include!("cxx-qt-lib/qstring.h");
         type QString = cxx_qt_lib::QString;
         include!("cxx-qt-lib/qstringlist.h");
@@ -137,6 +139,8 @@ pub mod ffi {
         fn log_input(self: &SmushClient, input: &QString) -> ApiCode;
         fn log_note(self: &SmushClient, note: StringView) -> ApiCode;
         fn open_log(self: &SmushClient, path: StringView, append: bool) -> ApiCode;
+        fn start_recording(self: &SmushClient, path: StringView) -> ApiCode;
+        fn stop_recording(self: &SmushClient) -> ApiCode;
         fn try_close_log(self: &SmushClient) -> Result<()>;
         fn try_open_log(self: &SmushClient) -> Result<()>;
         fn write_to_log(self: &SmushClient, bytes: BytesView) -> ApiCode;
@@ -144,6 +148,7 @@ pub mod ffi {
         // network
         fn bytes_received(self: &SmushClient) -> u64;
         fn connect_to_host(self: &SmushClient, socket: Pin<&mut QAbstractSocket>);
+        fn drain(self: &SmushClient, doc: Pin<&mut Document>);
         fn flush(self: &SmushClient, doc: Pin<&mut Document>);
         fn handle_connect(self: &SmushClient, socket: Pin<&mut QAbstractSocket>) -> QString;
         fn handle_disconnect(self: &SmushClient);
@@ -152,8 +157,11 @@ pub mod ffi {
             self: &SmushClient,
             device: Pin<&mut QAbstractSocket>,
             doc: Pin<&mut Document>,
+            limit: usize,
+            drain: bool,
         ) -> i64;
         fn reset_mxp(self: &SmushClient);
+        fn set_match_threads(self: Pin<&mut SmushClient>, threads: usize);
 
         // option
         fn get_sender_option(
@@ -223,7 +231,7 @@ pub mod ffi {
             doc: Pin<&mut Document>,
         ) -> AliasOutcomes;
         fn alias_menu(self: &SmushClient) -> Vec<AliasMenuItem>;
-        fn finish_timer(self: Pin<&mut SmushClient>, id: usize) -> bool;
+        fn arm_timekeeper(self: &SmushClient, timekeeper: &Timekeeper);
         fn get_alias_wildcard(&self, index: usize, label: StringView, name: StringView) -> String;
         fn get_trigger_wildcard(&self, index: usize, label: StringView, name: StringView)
         -> String;
@@ -232,7 +240,7 @@ pub mod ffi {
         fn is_sender(self: &SmushClient, kind: SenderKind, index: usize, label: StringView)
         -> bool;
         fn list_senders(self: &SmushClient, kind: SenderKind, index: usize) -> Vec<String>;
-        fn poll_timers(self: Pin<&mut SmushClient>);
+        fn poll_timers(self: Pin<&mut SmushClient>, timekeeper: &Timekeeper);
         fn remove_sender(
             self: &SmushClient,
             kind: SenderKind,
@@ -300,6 +308,7 @@ pub mod ffi {
         fn start_all_timers(self: &SmushClient, timekeeper: &Timekeeper);
         fn start_timers(self: &SmushClient, index: usize, timekeeper: &Timekeeper);
         fn stop_senders(self: &SmushClient, kind: SenderKind);
+        fn remove_timers(self: &SmushClient, ids: &QSet_u16);
 
         // sound
         fn handle_alert(self: &SmushClient) -> ApiCode;
@@ -1,6 +1,6 @@
 use cxx_qt_lib::QColor;
 use smushclient_graphics::filter::{
-    self, average, dissolve, grayscale_linear, grayscale_perceptual, mask_premultiplied,
+    self, average, dissolve_premultiplied, grayscale_linear, grayscale_perceptual, is_opaque,
     mono_noise, noise, swap_blue_and_alpha,
 };
 use smushclient_graphics::{ColorChannel, Directions, Pixel};
@@ -50,8 +50,15 @@ mod ffi {
         fn average(data: &mut [u32]);
 
         fn color_to_alpha(data: &mut [u32], color: &QColor);
-        fn dissolve(data: &mut [u32], opacity: f64);
-        fn mask_premultiplied(data: &mut [u32], mask: &[u8], opacity: f64) -> bool;
+        fn dissolve_premultiplied(data: &mut [u32], opacity: f64);
+        fn is_opaque(data: &[u32]) -> bool;
+        fn mask_premultiplied(
+            data: &mut [u32],
+            width: i32,
+            mask: &[u8],
+            mask_stride: isize,
+            opacity: f64,
+        ) -> bool;
         fn swap_blue_and_alpha(data: &mut [u32]);
     }
 }
@@ -116,6 +123,21 @@ fn emboss(data: &mut [u32], width: i32, directions: ffi::Directions) {
     }
 }
 
+fn mask_premultiplied(
+    data: &mut [u32],
+    width: i32,
+    mask: &[u8],
+    mask_stride: isize,
+    opacity: f64,
+) -> bool {
+    match (usize::try_from(width), usize::try_from(mask_stride)) {
+        (Ok(width), Ok(mask_stride)) => {
+            filter::mask_premultiplied(data, width, mask, mask_stride, opacity)
+        }
+        _ => false,
+    }
+}
+
 fn brightness_add(data: &mut [u32], add: i32, channel: ffi::ColorChannel) {
     if let Ok(channel) = channel.try_into() {
         filter::brightness_add(data, add, channel);
@@ -19,6 +19,22 @@ pub mod ffi {
         type SenderKind = crate::ffi::SenderKind;
     }
 
+    enum SenderMapEditKind {
+        InsertGroup,
+        RemoveGroup,
+        InsertRows,
+        RemoveRows,
+    }
+
+    /// A step in updating a sender map. For group edits, `group` is the position of the group.
+    /// For row edits, `first` and `count` are the rows within the group.
+    struct SenderMapEdit {
+        kind: SenderMapEditKind,
+        group: i32,
+        first: i32,
+        count: i32,
+    }
+
     #[auto_cxx_name]
     extern "RustQt" {
         #[qobject]
@@ -31,6 +47,9 @@ pub mod ffi {
             index: usize,
             column: i32,
         ) -> QString;
+        fn apply_staged_edit(self: Pin<&mut SenderMap>, i: usize);
+        fn filter_accepts(self: &SenderMap, group: &String, row: usize) -> bool;
+        fn group_filter_accepts(self: &SenderMap, group_index: usize) -> bool;
         fn len(self: &SenderMap) -> usize;
         fn group_len(self: &SenderMap, group_index: usize) -> usize;
         fn group_index(self: &SenderMap, group: &String) -> i32;
@@ -44,7 +63,16 @@ pub mod ffi {
             first: usize,
             amount: usize,
         ) -> bool;
+        fn refresh_sender(self: Pin<&mut SenderMap>, client: &SmushClient, index: usize);
         fn sender_index(self: &SenderMap, group: &String, index: usize) -> i32;
+        fn set_filter(
+            self: Pin<&mut SenderMap>,
+            client: &SmushClient,
+            filter: &QString,
+            columns: i32,
+        );
+        fn stage(self: Pin<&mut SenderMap>, client: &SmushClient) -> usize;
+        fn staged_edit(self: &SenderMap, i: usize) -> SenderMapEdit;
         fn set_cell(
             self: Pin<&mut SenderMap>,
             client: &SmushClient,
@@ -53,6 +81,7 @@ pub mod ffi {
             column: i32,
             data: &QVariant,
         ) -> i32;
+        fn unstage(self: Pin<&mut SenderMap>);
         fn timer_ids(
             self: &SenderMap,
             client: &SmushClient,
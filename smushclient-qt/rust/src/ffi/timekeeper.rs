@@ -1,17 +1,7 @@
-use smushclient::TimerStart;
+use chrono::{DateTime, Utc};
 
 #[cxx::bridge]
 pub mod ffi {
-    extern "C++" {
-        include!("cxx-qt-lib/qstring.h");
-        type QString = cxx_qt_lib::QString;
-    }
-
-    extern "C++" {
-        include!("smushclient_qt/src/ffi/send_request.cxx.h");
-        type SendTarget = crate::ffi::SendTarget;
-    }
-
     unsafe extern "C++" {
         include!("smushclient_qt/abstracttimekeeper.h");
 
@@ -19,13 +9,23 @@ pub mod ffi {
         type Timekeeper;
 
         #[doc(hidden)]
-        #[rust_name = "start_send_timer"]
-        fn startSendTimer(self: &Timekeeper, index: usize, timer: u16, milliseconds: u32);
+        #[rust_name = "arm_timer"]
+        fn armTimer(self: &Timekeeper, milliseconds: i64);
     }
 }
 
 impl ffi::Timekeeper {
-    pub fn start(&self, start: &TimerStart) {
-        self.start_send_timer(start.plugin, start.timer, start.milliseconds);
+    /// Arms the timekeeper's single wake-up for the next due timer, or disarms it if no timers
+    /// are scheduled.
+    pub fn arm(&self, deadline: Option<DateTime<Utc>>) {
+        let Some(deadline) = deadline else {
+            self.arm_timer(-1);
+            return;
+        };
+        let millis = deadline
+            .signed_duration_since(Utc::now())
+            .num_milliseconds()
+            .max(0);
+        self.arm_timer(millis);
     }
 }
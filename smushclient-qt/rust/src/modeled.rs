@@ -3,7 +3,7 @@ use std::ptr;
 
 use cxx_qt::{CxxQtType, Initialize};
 use cxx_qt_lib::{QDate, QSet, QString, QVariant};
-use smushclient::{SenderMap, SmushClient};
+use smushclient::{SenderMap, SenderMapEdit, SmushClient};
 use smushclient_plugins::{
     Alias, CursorVec, Plugin, PluginIndex, PluginMetadata, PluginSender, Timer, Trigger,
 };
@@ -19,6 +19,16 @@ pub trait Modeled {
     fn cell_text(&self, column: i32) -> QString;
     fn set_cell(&mut self, column: i32, data: &QVariant) -> Option<()>;
 
+    /// Case-folded text of the first `columns` columns, for filtering.
+    fn search_text(&self, columns: i32) -> String {
+        let mut text = String::new();
+        for column in 0..columns {
+            text.push_str(&String::from(&self.cell_text(column)).to_lowercase());
+            text.push('\n');
+        }
+        text
+    }
+
     fn update_in_world(
         client: &SmushClient,
         index: usize,
@@ -206,10 +216,59 @@ fn try_index(index: usize) -> i32 {
     index.try_into().unwrap_or(-1)
 }
 
+fn search_texts<T: Modeled>(senders: &CursorVec<T>, columns: i32) -> Vec<String> {
+    senders
+        .borrow()
+        .iter()
+        .map(|sender| sender.search_text(columns))
+        .collect()
+}
+
+impl From<SenderMapEdit> for ffi::SenderMapEdit {
+    fn from(value: SenderMapEdit) -> Self {
+        let (kind, group, first, count) = match value {
+            SenderMapEdit::InsertGroup { index, .. } => {
+                (ffi::SenderMapEditKind::InsertGroup, index, 0, 1)
+            }
+            SenderMapEdit::RemoveGroup { index } => {
+                (ffi::SenderMapEditKind::RemoveGroup, index, 0, 1)
+            }
+            SenderMapEdit::InsertRows {
+                group,
+                first,
+                count,
+                ..
+            } => (ffi::SenderMapEditKind::InsertRows, group, first, count),
+            SenderMapEdit::RemoveRows {
+                group,
+                first,
+                count,
+            } => (ffi::SenderMapEditKind::RemoveRows, group, first, count),
+        };
+        Self {
+            kind,
+            group: try_index(group),
+            first: try_index(first),
+            count: try_index(count),
+        }
+    }
+}
+
 #[derive(Clone, PartialEq, Eq)]
 pub struct SenderMapRust {
     inner: SenderMap,
     kind: ffi::SenderKind,
+    /// Map that `inner` is being transformed into, and the steps that transform it.
+    staged: Option<(SenderMap, Vec<SenderMapEdit>)>,
+    /// Case-folded filter text.
+    filter: String,
+    /// Number of columns the model displays, all of which are searched.
+    columns: i32,
+    /// For each sender, whether it matches the filter. Empty if there is no filter.
+    matches: Vec<bool>,
+    /// For each sender, its search text. Built when a filter is first set, and cleared when
+    /// senders change.
+    search_index: Vec<String>,
 }
 
 impl SenderMapRust {
@@ -224,12 +283,34 @@ impl SenderMapRust {
             return QString::default();
         };
         let world = client.world_plugin();
-        match self.kind {
-            ffi::SenderKind::Alias => world.aliases.get(index).unwrap().cell_text(column),
-            ffi::SenderKind::Timer => world.timers.get(index).unwrap().cell_text(column),
-            ffi::SenderKind::Trigger => world.triggers.get(index).unwrap().cell_text(column),
-            _ => QString::default(),
+        let text = match self.kind {
+            ffi::SenderKind::Alias => world.aliases.get(index).map(|s| s.cell_text(column)),
+            ffi::SenderKind::Timer => world.timers.get(index).map(|s| s.cell_text(column)),
+            ffi::SenderKind::Trigger => world.triggers.get(index).map(|s| s.cell_text(column)),
+            _ => None,
+        };
+        text.unwrap_or_default()
+    }
+
+    pub fn filter_accepts(&self, group: &str, row: usize) -> bool {
+        if self.matches.is_empty() {
+            return true;
         }
+        self.inner
+            .sender_index(group, row)
+            .and_then(|index| self.matches.get(index).copied())
+            .unwrap_or(false)
+    }
+
+    /// Returns `true` if a group's name matches the filter, folded the same way as the search
+    /// text of its senders.
+    pub fn group_filter_accepts(&self, group_index: usize) -> bool {
+        if self.filter.is_empty() {
+            return true;
+        }
+        self.inner
+            .group_name(group_index)
+            .is_some_and(|name| name.to_lowercase().contains(self.filter.as_str()))
     }
 
     pub fn group_len(&self, group_index: usize) -> usize {
@@ -269,6 +350,96 @@ impl SenderMapRust {
             ffi::SenderKind::Trigger => self.inner.recalculate(&*world.triggers.borrow()),
             _ => (),
         }
+        self.search_index.clear();
+        self.refilter(client);
+    }
+
+    /// Updates the search text of a sender that was edited in place, without moving.
+    pub fn refresh_sender(&mut self, client: &SmushClient, index: usize) {
+        if index >= self.search_index.len() {
+            return;
+        }
+        let world = client.world_plugin();
+        let columns = self.columns;
+        let text = match self.kind {
+            ffi::SenderKind::Alias => world.aliases.get(index).map(|s| s.search_text(columns)),
+            ffi::SenderKind::Timer => world.timers.get(index).map(|s| s.search_text(columns)),
+            ffi::SenderKind::Trigger => world.triggers.get(index).map(|s| s.search_text(columns)),
+            _ => None,
+        };
+        let Some(text) = text else {
+            return;
+        };
+        if let Some(matches) = self.matches.get_mut(index) {
+            *matches = text.contains(self.filter.as_str());
+        }
+        self.search_index[index] = text;
+    }
+
+    pub fn set_filter(&mut self, client: &SmushClient, filter: &QString, columns: i32) {
+        self.filter = String::from(filter).to_lowercase();
+        if columns != self.columns {
+            self.columns = columns;
+            self.search_index.clear();
+        }
+        self.refilter(client);
+    }
+
+    fn refilter(&mut self, client: &SmushClient) {
+        self.matches.clear();
+        if self.filter.is_empty() {
+            return;
+        }
+        if self.search_index.is_empty() {
+            let world = client.world_plugin();
+            let columns = self.columns;
+            self.search_index = match self.kind {
+                ffi::SenderKind::Alias => search_texts(&world.aliases, columns),
+                ffi::SenderKind::Timer => search_texts(&world.timers, columns),
+                ffi::SenderKind::Trigger => search_texts(&world.triggers, columns),
+                _ => Vec::new(),
+            };
+        }
+        let filter = &self.filter;
+        self.matches = self
+            .search_index
+            .iter()
+            .map(|text| text.contains(filter.as_str()))
+            .collect();
+    }
+
+    /// Prepares to transform the map to match the current senders, returning the number of
+    /// steps. Each step is applied by `apply_staged_edit`.
+    pub fn stage(&mut self, client: &SmushClient) -> usize {
+        let world = client.world_plugin();
+        let target = match self.kind {
+            ffi::SenderKind::Alias => SenderMap::from_iter(&*world.aliases.borrow()),
+            ffi::SenderKind::Timer => SenderMap::from_iter(&*world.timers.borrow()),
+            ffi::SenderKind::Trigger => SenderMap::from_iter(&*world.triggers.borrow()),
+            _ => SenderMap::new(),
+        };
+        let edits = self.inner.diff(&target);
+        let len = edits.len();
+        self.inner.reindex(&target);
+        self.staged = Some((target, edits));
+        self.search_index.clear();
+        self.refilter(client);
+        len
+    }
+
+    pub fn staged_edit(&self, i: usize) -> ffi::SenderMapEdit {
+        let (_, edits) = self.staged.as_ref().expect("no edits are staged");
+        edits[i].into()
+    }
+
+    pub fn apply_staged_edit(&mut self, i: usize) {
+        if let Some((target, edits)) = &self.staged {
+            self.inner.apply(edits[i], target);
+        }
+    }
+
+    pub fn unstage(&mut self) {
+        self.staged = None;
     }
 
     fn group_indices<'a>(&'a self, group: &str, start: usize, amount: usize) -> &'a [usize] {
@@ -346,6 +517,8 @@ impl SenderMapRust {
         let Some(new_index) = result else {
             return -1;
         };
+        self.search_index.clear();
+        self.refilter(client);
         if new_index == index {
             return try_index(row);
         }
@@ -362,6 +535,11 @@ impl_constructor!(<>, ffi::SenderMap, (ffi::SenderKind,), {
         SenderMapRust {
             inner: SenderMap::default(),
             kind,
+            staged: None,
+            filter: String::new(),
+            columns: 0,
+            matches: Vec::new(),
+            search_index: Vec::new(),
         }
     }
 });
@@ -379,6 +557,14 @@ impl ffi::SenderMap {
             .cell_text(&client.rust().client, group, index, column)
     }
 
+    pub fn filter_accepts(&self, group: &String, row: usize) -> bool {
+        self.rust().filter_accepts(group, row)
+    }
+
+    pub fn group_filter_accepts(&self, group_index: usize) -> bool {
+        self.rust().group_filter_accepts(group_index)
+    }
+
     pub fn group_len(&self, group_index: usize) -> usize {
         self.rust().group_len(group_index)
     }
@@ -418,6 +604,36 @@ impl ffi::SenderMap {
         self.rust().sender_index(group, index)
     }
 
+    pub fn refresh_sender(self: Pin<&mut Self>, client: &ffi::SmushClient, index: usize) {
+        self.rust_mut().refresh_sender(&client.rust().client, index);
+    }
+
+    pub fn set_filter(
+        self: Pin<&mut Self>,
+        client: &ffi::SmushClient,
+        filter: &QString,
+        columns: i32,
+    ) {
+        self.rust_mut()
+            .set_filter(&client.rust().client, filter, columns);
+    }
+
+    pub fn stage(self: Pin<&mut Self>, client: &ffi::SmushClient) -> usize {
+        self.rust_mut().stage(&client.rust().client)
+    }
+
+    pub fn staged_edit(&self, i: usize) -> ffi::SenderMapEdit {
+        self.rust().staged_edit(i)
+    }
+
+    pub fn apply_staged_edit(self: Pin<&mut Self>, i: usize) {
+        self.rust_mut().apply_staged_edit(i);
+    }
+
+    pub fn unstage(self: Pin<&mut Self>) {
+        self.rust_mut().unstage();
+    }
+
     pub fn set_cell(
         self: Pin<&mut Self>,
         client: &ffi::SmushClient,
@@ -1,7 +1,24 @@
 use std::cell::{Cell, RefCell};
+use std::time::{Duration, Instant};
 
 use mud_transformer::Bytes;
 
+/// Receive rates, averaged over the most recent sampling window.
+#[derive(Copy, Clone, Debug, Default, PartialEq)]
+pub struct Throughput {
+    pub packets_per_sec: f64,
+    pub bytes_per_sec: f64,
+    pub passes_per_sec: f64,
+}
+
+#[derive(Copy, Clone, Debug)]
+struct ThroughputSample {
+    at: Instant,
+    packets: u64,
+    bytes: u64,
+    passes: u64,
+}
+
 #[derive(Debug, Default)]
 pub struct ClientInfo {
     pub bytes_received: Cell<u64>,
@@ -14,7 +31,10 @@ pub struct ClientInfo {
     pub lines_displayed: Cell<u64>,
     pub lines_received: Cell<u64>,
     pub packets_received: Cell<u64>,
+    pub processing_passes: Cell<u64>,
     pub simulating: Cell<bool>,
+    last_sample: Cell<Option<ThroughputSample>>,
+    throughput: Cell<Throughput>,
 }
 
 impl ClientInfo {
@@ -29,6 +49,108 @@ impl ClientInfo {
         self.lines_displayed.set(0);
         self.lines_received.set(0);
         self.packets_received.set(0);
+        self.processing_passes.set(0);
         self.simulating.set(false);
+        self.last_sample.set(None);
+        self.throughput.set(Throughput::default());
+    }
+
+    /// Closes the current sampling window if it is at least a second old, so that its rates are
+    /// returned by [`throughput`](Self::throughput). Called as data is received.
+    pub fn sample_throughput(&self) {
+        self.sample_throughput_at(Instant::now());
+    }
+
+    /// Returns receive rates over the most recent sampling window. If no window has closed for
+    /// more than a second, e.g. because nothing has been received, rates are averaged from the
+    /// last sample to now instead, so they fall toward zero while the connection is idle.
+    pub fn throughput(&self) -> Throughput {
+        self.throughput_at(Instant::now())
+    }
+
+    fn counts_at(&self, at: Instant) -> ThroughputSample {
+        ThroughputSample {
+            at,
+            packets: self.packets_received.get(),
+            bytes: self.bytes_received.get(),
+            passes: self.processing_passes.get(),
+        }
+    }
+
+    fn sample_throughput_at(&self, now: Instant) {
+        let sample = self.counts_at(now);
+        let Some(last) = self.last_sample.get() else {
+            self.last_sample.set(Some(sample));
+            return;
+        };
+        if let Some(throughput) = Throughput::between(last, sample) {
+            self.last_sample.set(Some(sample));
+            self.throughput.set(throughput);
+        }
+    }
+
+    fn throughput_at(&self, now: Instant) -> Throughput {
+        let Some(last) = self.last_sample.get() else {
+            return Throughput::default();
+        };
+        Throughput::between(last, self.counts_at(now)).unwrap_or_else(|| self.throughput.get())
+    }
+}
+
+impl Throughput {
+    const WINDOW: Duration = Duration::from_secs(1);
+
+    /// Returns the rates between two samples, or `None` if they are less than a window apart.
+    fn between(then: ThroughputSample, now: ThroughputSample) -> Option<Self> {
+        let elapsed = now.at.duration_since(then.at);
+        if elapsed < Self::WINDOW {
+            return None;
+        }
+        let secs = elapsed.as_secs_f64();
+        #[allow(clippy::cast_precision_loss)]
+        let rate = |now: u64, then: u64| now.saturating_sub(then) as f64 / secs;
+        Some(Self {
+            packets_per_sec: rate(now.packets, then.packets),
+            bytes_per_sec: rate(now.bytes, then.bytes),
+            passes_per_sec: rate(now.passes, then.passes),
+        })
+    }
+}
+
+#[cfg(test)]
+#[allow(clippy::float_cmp)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn throughput_falls_while_idle() {
+        let info = ClientInfo::default();
+        let start = Instant::now();
+        info.sample_throughput_at(start);
+        info.bytes_received.set(1000);
+        info.sample_throughput_at(start + Duration::from_secs(1));
+        let burst = info.throughput_at(start + Duration::from_millis(1500));
+        assert_eq!(burst.bytes_per_sec, 1000.0);
+        let idle = info.throughput_at(start + Duration::from_secs(11));
+        assert_eq!(idle.bytes_per_sec, 0.0);
+    }
+
+    #[test]
+    fn throughput_counts_bytes_since_last_sample() {
+        let info = ClientInfo::default();
+        let start = Instant::now();
+        info.sample_throughput_at(start);
+        info.bytes_received.set(1000);
+        assert_eq!(
+            info.throughput_at(start + Duration::from_secs(4))
+                .bytes_per_sec,
+            250.0
+        );
+        assert_eq!(
+            info.throughput_at(start + Duration::from_secs(4))
+                .bytes_per_sec,
+            250.0,
+            "reading rates should not start a new window"
+        );
     }
 }
@@ -0,0 +1,314 @@
+use std::ffi::OsString;
+use std::fs::{self, File, OpenOptions};
+use std::io::{self, BufWriter, Write};
+use std::path::{Path, PathBuf};
+use std::sync::mpsc::{self, Receiver, Sender};
+use std::sync::{Arc, Mutex, PoisonError};
+use std::thread::{self, JoinHandle};
+
+const HEADER_LEN: usize = 8;
+
+/// A change to a single variable. `value` is `None` if the variable was deleted.
+#[derive(Copy, Clone, Debug, PartialEq, Eq)]
+pub(crate) struct Record<'a> {
+    pub plugin_id: &'a str,
+    pub key: &'a str,
+    pub value: Option<&'a [u8]>,
+}
+
+impl<'a> Record<'a> {
+    /// Appends the record to a buffer, framed by its length and a checksum so that a record
+    /// torn by a crash can be detected.
+    pub fn encode(&self, buf: &mut Vec<u8>) {
+        let start = buf.len();
+        buf.extend_from_slice(&[0; HEADER_LEN]);
+        write_field(buf, self.plugin_id.as_bytes());
+        write_field(buf, self.key.as_bytes());
+        if let Some(value) = self.value {
+            buf.push(1);
+            buf.extend_from_slice(value);
+        } else {
+            buf.push(0);
+        }
+        let payload = &buf[start + HEADER_LEN..];
+        let len = u32::try_from(payload.len()).expect("journal record is too large");
+        let checksum = checksum(payload);
+        buf[start..start + 4].copy_from_slice(&len.to_le_bytes());
+        buf[start + 4..start + HEADER_LEN].copy_from_slice(&checksum.to_le_bytes());
+    }
+
+    /// Decodes the record at the start of a buffer, returning it and the number of bytes it
+    /// occupies. Returns `None` if the buffer does not start with a complete, intact record.
+    pub fn decode(buf: &'a [u8]) -> Option<(Self, usize)> {
+        let (len, rest) = read_u32(buf)?;
+        let (expected_checksum, rest) = read_u32(rest)?;
+        let len = usize::try_from(len).ok()?;
+        let payload = rest.get(..len)?;
+        if checksum(payload) != expected_checksum {
+            return None;
+        }
+        let (plugin_id, payload) = read_field(payload)?;
+        let (key, payload) = read_field(payload)?;
+        let value = match payload {
+            [0] => None,
+            [1, value @ ..] => Some(value),
+            _ => return None,
+        };
+        let record = Self {
+            plugin_id: std::str::from_utf8(plugin_id).ok()?,
+            key: std::str::from_utf8(key).ok()?,
+            value,
+        };
+        Some((record, HEADER_LEN + len))
+    }
+}
+
+/// Calls `apply` on each intact record at the start of a journal, in order. Returns the length
+/// of the intact prefix. Anything after it was torn by a crash and should be discarded.
+pub(crate) fn replay<'a, F: FnMut(Record<'a>)>(mut journal: &'a [u8], mut apply: F) -> usize {
+    let mut valid = 0;
+    while let Some((record, len)) = Record::decode(journal) {
+        apply(record);
+        valid += len;
+        journal = &journal[len..];
+    }
+    valid
+}
+
+/// Returns the path of the journal that belongs to a variables file.
+pub(crate) fn journal_path(path: &Path) -> PathBuf {
+    with_suffix(path, ".journal")
+}
+
+/// Writes a full snapshot of variables.
+pub(crate) type Snapshot = Box<dyn FnOnce(&mut dyn Write) -> io::Result<()> + Send>;
+
+enum Job {
+    Append(Vec<u8>),
+    Compact(Snapshot),
+}
+
+/// Persists variables to a file and its journal on a background thread, so that saving never
+/// blocks on disk I/O. Jobs are run in the order they are submitted. Errors are reported by the
+/// next submission.
+#[derive(Debug)]
+pub(crate) struct VariableStore {
+    path: PathBuf,
+    journal_len: u64,
+    jobs: Option<Sender<Job>>,
+    worker: Option<JoinHandle<()>>,
+    error: Arc<Mutex<Option<io::Error>>>,
+}
+
+impl VariableStore {
+    /// Starts a store for a variables file whose journal already contains `journal_len` bytes.
+    pub fn new(path: PathBuf, journal_len: u64) -> Self {
+        let (jobs, receiver) = mpsc::channel();
+        let error = Arc::new(Mutex::new(None));
+        let worker = {
+            let path = path.clone();
+            let error = error.clone();
+            thread::Builder::new()
+                .name("variable-store".to_owned())
+                .spawn(move || run(&path, &receiver, &error))
+                .ok()
+        };
+        Self {
+            path,
+            journal_len,
+            jobs: Some(jobs),
+            worker,
+            error,
+        }
+    }
+
+    pub fn path(&self) -> &Path {
+        &self.path
+    }
+
+    pub fn journal_len(&self) -> u64 {
+        self.journal_len
+    }
+
+    /// Appends encoded records to the journal.
+    pub fn append(&mut self, records: Vec<u8>) -> io::Result<()> {
+        self.take_error()?;
+        self.journal_len += records.len() as u64;
+        self.submit(Job::Append(records))
+    }
+
+    /// Replaces the variables file with a snapshot and empties the journal.
+    pub fn compact(&mut self, snapshot: Snapshot) -> io::Result<()> {
+        self.take_error()?;
+        self.journal_len = 0;
+        self.submit(Job::Compact(snapshot))
+    }
+
+    fn submit(&self, job: Job) -> io::Result<()> {
+        if self.worker.is_none() {
+            return Err(io::Error::other("failed to start variable store thread"));
+        }
+        match &self.jobs {
+            Some(jobs) if jobs.send(job).is_ok() => Ok(()),
+            _ => Err(io::Error::other("variable store thread has stopped")),
+        }
+    }
+
+    fn take_error(&self) -> io::Result<()> {
+        match self
+            .error
+            .lock()
+            .unwrap_or_else(PoisonError::into_inner)
+            .take()
+        {
+            Some(e) => Err(e),
+            None => Ok(()),
+        }
+    }
+}
+
+impl Drop for VariableStore {
+    fn drop(&mut self) {
+        // Disconnect the channel so the worker exits once it has finished every job.
+        self.jobs = None;
+        if let Some(worker) = self.worker.take() {
+            let _ = worker.join();
+        }
+        if let Err(e) = self.take_error() {
+            log::error!(target: "smushclient.variables", "{e}");
+        }
+    }
+}
+
+fn run(path: &Path, jobs: &Receiver<Job>, error: &Mutex<Option<io::Error>>) {
+    let journal_path = journal_path(path);
+    for job in jobs {
+        let result = match job {
+            Job::Append(records) => append(&journal_path, &records),
+            Job::Compact(snapshot) => compact(path, &journal_path, snapshot),
+        };
+        if let Err(e) = result {
+            *error.lock().unwrap_or_else(PoisonError::into_inner) = Some(e);
+        }
+    }
+}
+
+fn append(journal_path: &Path, records: &[u8]) -> io::Result<()> {
+    let mut file = OpenOptions::new()
+        .create(true)
+        .append(true)
+        .open(journal_path)?;
+    file.write_all(records)?;
+    file.sync_data()
+}
+
+/// Writes the snapshot to a temporary file and renames it over the variables file, so the old
+/// file survives a crash. The journal is emptied afterward. If a crash happens in between,
+/// replaying the journal onto the new file is harmless, since it only repeats changes the
+/// snapshot already contains.
+fn compact(path: &Path, journal_path: &Path, snapshot: Snapshot) -> io::Result<()> {
+    let temp_path = with_suffix(path, ".tmp");
+    let mut writer = BufWriter::new(File::create(&temp_path)?);
+    snapshot(&mut writer)?;
+    let file = writer
+        .into_inner()
+        .map_err(io::IntoInnerError::into_error)?;
+    file.sync_all()?;
+    drop(file);
+    fs::rename(&temp_path, path)?;
+    File::create(journal_path)?.sync_all()
+}
+
+fn with_suffix(path: &Path, suffix: &str) -> PathBuf {
+    let mut path = OsString::from(path);
+    path.push(suffix);
+    PathBuf::from(path)
+}
+
+fn write_field(buf: &mut Vec<u8>, field: &[u8]) {
+    let len = u32::try_from(field.len()).expect("journal field is too large");
+    buf.extend_from_slice(&len.to_le_bytes());
+    buf.extend_from_slice(field);
+}
+
+fn read_u32(buf: &[u8]) -> Option<(u32, &[u8])> {
+    let (bytes, rest) = buf.split_first_chunk::<4>()?;
+    Some((u32::from_le_bytes(*bytes), rest))
+}
+
+pub(crate) fn read_field(buf: &[u8]) -> Option<(&[u8], &[u8])> {
+    let (len, rest) = read_u32(buf)?;
+    let len = usize::try_from(len).ok()?;
+    if rest.len() < len {
+        return None;
+    }
+    Some(rest.split_at(len))
+}
+
+/// 32-bit FNV-1a.
+fn checksum(bytes: &[u8]) -> u32 {
+    bytes.iter().fold(0x811c_9dc5, |hash, &byte| {
+        (hash ^ u32::from(byte)).wrapping_mul(0x0100_0193)
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn encode_all(records: &[Record]) -> Vec<u8> {
+        let mut buf = Vec::new();
+        for record in records {
+            record.encode(&mut buf);
+        }
+        buf
+    }
+
+    const RECORDS: [Record; 3] = [
+        Record {
+            plugin_id: "plugin",
+            key: "a",
+            value: Some(b"1"),
+        },
+        Record {
+            plugin_id: "plugin",
+            key: "b",
+            value: Some(b""),
+        },
+        Record {
+            plugin_id: "",
+            key: "a",
+            value: None,
+        },
+    ];
+
+    #[test]
+    fn replay_round_trip() {
+        let journal = encode_all(&RECORDS);
+        let mut replayed = Vec::new();
+        let valid = replay(&journal, |record| replayed.push(record));
+        assert_eq!(valid, journal.len());
+        assert_eq!(replayed, RECORDS);
+    }
+
+    #[test]
+    fn replay_stops_at_torn_record() {
+        let journal = encode_all(&RECORDS);
+        let intact = encode_all(&RECORDS[..2]).len();
+        for end in intact..journal.len() {
+            let mut replayed = Vec::new();
+            let valid = replay(&journal[..end], |record| replayed.push(record));
+            assert_eq!(valid, intact);
+            assert_eq!(replayed, RECORDS[..2]);
+        }
+    }
+
+    #[test]
+    fn replay_stops_at_corrupt_record() {
+        let mut journal = encode_all(&RECORDS);
+        let last = journal.len() - 1;
+        journal[last] ^= 0xFF;
+        let valid = replay(&journal, |_| ());
+        assert_eq!(valid, encode_all(&RECORDS[..2]).len());
+    }
+}
@@ -4,6 +4,7 @@ use std::io::{self, BufWriter, Write};
 use mud_transformer::output::Output;
 
 use super::log_file::LogFile;
+use super::recording::SessionRecorder;
 use crate::world::{Escaped, LogBrackets, LogFormat, LogMode, WorldConfig};
 
 #[derive(Debug)]
@@ -13,6 +14,7 @@ pub struct Logger {
     file: LogFile,
     format: LogFormat,
     path: Option<String>,
+    recorder: Option<SessionRecorder>,
 }
 
 impl Logger {
@@ -23,6 +25,7 @@ impl Logger {
             file: LogFile::default(),
             format: world.log_format,
             path: None,
+            recorder: None,
         }
     }
 
@@ -70,7 +73,29 @@ impl Logger {
         self.file.write_all(bytes)
     }
 
+    pub fn is_recording(&self) -> bool {
+        self.recorder.is_some()
+    }
+
+    pub fn start_recording(&mut self, path: &str) -> io::Result<()> {
+        self.stop_recording()?;
+        self.recorder = Some(SessionRecorder::create(path)?);
+        Ok(())
+    }
+
+    pub fn stop_recording(&mut self) -> io::Result<()> {
+        match self.recorder.take() {
+            Some(recorder) => recorder.into_inner().map(drop),
+            None => Ok(()),
+        }
+    }
+
     pub fn log_raw(&mut self, bytes: &[u8]) -> io::Result<()> {
+        if let Some(recorder) = &mut self.recorder
+            && recorder.record(bytes).is_err()
+        {
+            self.recorder = None;
+        }
         if self.format != LogFormat::Raw {
             return Ok(());
         }
@@ -133,5 +158,6 @@ impl Logger {
 impl Drop for Logger {
     fn drop(&mut self) {
         let _ = self.close();
+        let _ = self.stop_recording();
     }
 }
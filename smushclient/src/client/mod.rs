@@ -1,13 +1,29 @@
 mod clipboard;
 
+mod journal;
+
 mod log_file;
 
 mod logger;
 
+mod prematch;
+
 mod smushclient;
 pub use smushclient::SmushClient;
 
 mod info;
+pub use info::Throughput;
+
+mod read_buffer;
+pub use read_buffer::ReadBuffer;
+
+mod recording;
+pub use recording::{SessionFrame, SessionReader, SessionRecorder};
+
+mod replay;
+pub use replay::{ReplayStats, replay};
+
+mod snapshot;
 
 mod variables;
 pub(crate) use variables::{PluginVariableMap, XmlVariable};
@@ -0,0 +1,228 @@
+use std::num::NonZero;
+use std::sync::{Mutex, PoisonError};
+use std::thread;
+
+use smushclient_plugins::{Matchers, Regex};
+
+/// Each thread used for matching must have at least this many candidate patterns to itself, so
+/// lines with fewer than twice this many candidates are matched on the calling thread. Spawning a
+/// worker takes about as long as matching 150 to 200 patterns against a line (see the
+/// `parallel_threshold` benchmark below), so a worker with fewer patterns than this saves little
+/// or nothing. Workers are spawned for each line that clears the threshold.
+const PATTERNS_PER_THREAD: usize = 256;
+
+/// Number of patterns a worker takes at a time.
+const BATCH_LEN: usize = 32;
+
+const MAX_THREADS: usize = 16;
+
+/// Resolves a requested number of threads for matching. 0 uses the number of available CPUs, up
+/// to 16.
+pub(crate) fn resolve_threads(threads: usize) -> usize {
+    match threads {
+        0 => thread::available_parallelism()
+            .map_or(1, NonZero::get)
+            .min(MAX_THREADS),
+        threads => threads.min(MAX_THREADS),
+    }
+}
+
+/// Which patterns in a plugin's snapshot of senders match a line, worked out ahead of time.
+#[derive(Debug)]
+pub(crate) struct Prematch {
+    matchers: Matchers,
+    matched: Vec<bool>,
+}
+
+impl Prematch {
+    /// Returns whether each pattern matched, if `matchers` is the snapshot that was matched. If a
+    /// handler has changed the plugin's senders since, the snapshot is different and the results
+    /// no longer apply.
+    pub fn get(&self, matchers: &Matchers) -> Option<&[bool]> {
+        Matchers::ptr_eq(&self.matchers, matchers).then_some(&self.matched)
+    }
+}
+
+/// Returns whether a pattern matches a line, by the same test that is applied while evaluating
+/// senders.
+pub(crate) fn is_match(regex: &Regex, line: &str) -> bool {
+    regex.captures_iter(line).any(|captures| captures.is_ok())
+}
+
+/// Matches a line against the patterns in a list of snapshots, one per plugin, spreading them
+/// across up to `threads` threads. As in a serial scan, only the
+/// [candidates](Matchers::candidates) for the line are run, and the rest are recorded as not
+/// matching. Matching has no side effects, so the results are the same as matching each pattern
+/// in turn, no matter how many threads are used.
+///
+/// Returns an empty list if there are too few candidates to be worth spreading out.
+pub(crate) fn prematch(
+    snapshots: Vec<Option<Matchers>>,
+    line: &str,
+    threads: usize,
+) -> Vec<Option<Prematch>> {
+    let candidates: Vec<Vec<usize>> = snapshots
+        .iter()
+        .map(|matchers| match matchers {
+            Some(matchers) => matchers.candidates(line).map(|(i, _)| i).collect(),
+            None => Vec::new(),
+        })
+        .collect();
+    let total: usize = candidates.iter().map(Vec::len).sum();
+    let threads = threads.min(total / PATTERNS_PER_THREAD);
+    if threads <= 1 {
+        return Vec::new();
+    }
+    let regexes: Vec<&Regex> = snapshots
+        .iter()
+        .zip(&candidates)
+        .filter_map(|(matchers, indices)| Some((matchers.as_ref()?, indices)))
+        .flat_map(|(matchers, indices)| indices.iter().map(|&i| matchers[i].regex()))
+        .collect();
+    let mut results = match_all(&regexes, line, threads).into_iter();
+    snapshots
+        .into_iter()
+        .zip(candidates)
+        .map(|(matchers, indices)| {
+            let matchers = matchers?;
+            let mut matched = vec![false; matchers.len()];
+            for (i, result) in indices.into_iter().zip(results.by_ref()) {
+                matched[i] = result;
+            }
+            Some(Prematch { matchers, matched })
+        })
+        .collect()
+}
+
+/// Matches a line against patterns on `threads` threads, counting the calling thread, which
+/// take batches of patterns until none are left.
+fn match_all(regexes: &[&Regex], line: &str, threads: usize) -> Vec<bool> {
+    let mut matched = vec![false; regexes.len()];
+    let batches = Mutex::new(regexes.chunks(BATCH_LEN).zip(matched.chunks_mut(BATCH_LEN)));
+    let next_batch = || {
+        batches
+            .lock()
+            .unwrap_or_else(PoisonError::into_inner)
+            .next()
+    };
+    let run = || {
+        while let Some((regexes, matched)) = next_batch() {
+            for (regex, matched) in regexes.iter().zip(matched) {
+                *matched = is_match(regex, line);
+            }
+        }
+    };
+    thread::scope(|scope| {
+        for _ in 1..threads {
+            scope.spawn(run);
+        }
+        run();
+    });
+    matched
+}
+
+#[cfg(test)]
+mod tests {
+    use smushclient_plugins::testing::{plugins, trigger};
+    use smushclient_plugins::{CursorVec, Matcher, Trigger};
+
+    use super::*;
+    use crate::testing::time;
+
+    fn snapshots(plugins: &[CursorVec<Trigger>]) -> Vec<Option<Matchers>> {
+        plugins
+            .iter()
+            .enumerate()
+            .map(|(i, plugin)| (i != 3).then(|| plugin.matchers()))
+            .collect()
+    }
+
+    /// Triggers `x0` to `x{len-1}`, each anchored to a line that starts with its label.
+    fn anchored(len: usize) -> CursorVec<Trigger> {
+        (0..len)
+            .map(|i| trigger(&format!("x{i}"), &format!(r"^x{i}\b")))
+            .collect()
+    }
+
+    #[test]
+    fn prematch_agrees_with_serial_matching() {
+        let plugins = plugins();
+        let lines = [
+            "",
+            "12 34",
+            "You see 5 orcs and 96 goblins here.",
+            "a 7 b 60 c 61 d",
+            "x12 5 x13",
+        ];
+        let anchored = anchored(PATTERNS_PER_THREAD);
+        for line in lines {
+            let mut snapshots = snapshots(&plugins);
+            snapshots.insert(1, Some(anchored.matchers()));
+            let serial: Vec<Option<Vec<bool>>> = snapshots
+                .iter()
+                .map(|matchers| {
+                    let matchers = matchers.as_ref()?;
+                    Some(matchers.iter().map(|m| is_match(m.regex(), line)).collect())
+                })
+                .collect();
+            for threads in [2, 3, 4, 16] {
+                let prematches = prematch(snapshots.clone(), line, threads);
+                let parallel: Vec<Option<Vec<bool>>> = prematches
+                    .iter()
+                    .zip(&snapshots)
+                    .map(|(prematch, matchers)| {
+                        Some(prematch.as_ref()?.get(matchers.as_ref()?)?.to_vec())
+                    })
+                    .collect();
+                assert_eq!(parallel, serial, "line: {line:?}, threads: {threads}");
+            }
+        }
+    }
+
+    #[test]
+    fn prematch_skips_small_lists() {
+        let plugins = plugins();
+        assert!(prematch(snapshots(&plugins[..2]), "1 2 3", 4).is_empty());
+        assert!(prematch(snapshots(&plugins), "1 2 3", 1).is_empty());
+    }
+
+    #[test]
+    fn prematch_counts_only_candidates() {
+        // 1024 patterns, of which at most 111 may match any line.
+        let anchored = anchored(PATTERNS_PER_THREAD * 4);
+        let snapshots = vec![Some(anchored.matchers())];
+        assert!(prematch(snapshots.clone(), "no prefix here", 4).is_empty());
+        assert!(prematch(snapshots, "x5 and more", 4).is_empty());
+    }
+
+    #[test]
+    fn prematch_is_discarded_after_senders_change() {
+        let plugins = plugins();
+        let prematches = prematch(snapshots(&plugins), "1 2 3", 2);
+        let first = prematches[0].as_ref().unwrap();
+        assert!(first.get(&plugins[0].matchers()).is_some());
+        plugins[0].set_enabled_by_label("t0", false);
+        assert!(first.get(&plugins[0].matchers()).is_none());
+    }
+
+    /// Times matching one line against more and more patterns, on the calling thread and spread
+    /// across workers, to show where spreading them out starts to pay for spawning the workers.
+    #[test]
+    #[ignore = "benchmark"]
+    fn parallel_threshold() {
+        let plugins = plugins();
+        let line = "You see 5 orcs and 96 goblins here.";
+        for plugins_len in [2, 4, 8, 13, 26, 40] {
+            let snapshots = snapshots(&plugins[..plugins_len]);
+            let regexes: Vec<&Regex> = snapshots
+                .iter()
+                .flatten()
+                .flat_map(|matchers| matchers.iter().map(Matcher::regex))
+                .collect();
+            for threads in [1, 2, 4, 8] {
+                let label = format!("{} patterns, {threads} threads", regexes.len());
+                time(&label, 2000, || match_all(&regexes, line, threads));
+            }
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/// Receive buffer for [`SmushClient::read`](super::SmushClient::read) that adapts its size to the
+/// connection's throughput.
+///
+/// The buffer doubles after several consecutive reads that needed more than one chunk, and halves
+/// after a long run of reads that only used a small part of a chunk.
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct ReadBuffer {
+    buf: Box<[u8]>,
+    min_len: usize,
+    max_len: usize,
+    busy_reads: u32,
+    idle_reads: u32,
+}
+
+impl Default for ReadBuffer {
+    fn default() -> Self {
+        Self::new(Self::DEFAULT_MIN_LEN, Self::DEFAULT_MAX_LEN)
+    }
+}
+
+impl ReadBuffer {
+    pub const DEFAULT_MIN_LEN: usize = 1024 * 8;
+    pub const DEFAULT_MAX_LEN: usize = 1024 * 512;
+
+    const GROW_AFTER: u32 = 4;
+    const SHRINK_AFTER: u32 = 64;
+
+    pub fn new(min_len: usize, max_len: usize) -> Self {
+        let min_len = min_len.max(2);
+        Self {
+            buf: vec![0; min_len].into_boxed_slice(),
+            min_len,
+            max_len: max_len.max(min_len),
+            busy_reads: 0,
+            idle_reads: 0,
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.buf.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.buf.is_empty()
+    }
+
+    pub fn as_mut_slice(&mut self) -> &mut [u8] {
+        &mut self.buf
+    }
+
+    /// Records the number of bytes returned by a read, resizing the buffer for the next one if
+    /// the connection has been consistently busy or idle.
+    pub fn record(&mut self, bytes_read: usize) {
+        // SmushClient::read receives into the first half of the buffer.
+        let chunk = self.buf.len() / 2;
+        if bytes_read > chunk {
+            self.idle_reads = 0;
+            self.busy_reads += 1;
+            if self.busy_reads >= Self::GROW_AFTER {
+                self.resize((self.buf.len() * 2).min(self.max_len));
+            }
+        } else if bytes_read <= chunk / 4 {
+            self.busy_reads = 0;
+            self.idle_reads += 1;
+            if self.idle_reads >= Self::SHRINK_AFTER {
+                self.resize((self.buf.len() / 2).max(self.min_len));
+            }
+        } else {
+            self.busy_reads = 0;
+            self.idle_reads = 0;
+        }
+    }
+
+    fn resize(&mut self, len: usize) {
+        self.busy_reads = 0;
+        self.idle_reads = 0;
+        if len != self.buf.len() {
+            self.buf = vec![0; len].into_boxed_slice();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn grows_under_load_and_shrinks_when_idle() {
+        let mut buf = ReadBuffer::new(64, 256);
+        for _ in 0..ReadBuffer::GROW_AFTER * 4 {
+            buf.record(buf.len());
+        }
+        assert_eq!(buf.len(), 256);
+        for _ in 0..ReadBuffer::SHRINK_AFTER * 4 {
+            buf.record(1);
+        }
+        assert_eq!(buf.len(), 64);
+    }
+
+    #[test]
+    fn moderate_reads_keep_size() {
+        let mut buf = ReadBuffer::new(64, 256);
+        for _ in 0..ReadBuffer::SHRINK_AFTER * 2 {
+            buf.record(buf.len() / 4);
+        }
+        assert_eq!(buf.len(), 64);
+    }
+}
@@ -0,0 +1,139 @@
+use std::fs::File;
+use std::io::{self, BufWriter, Read, Write};
+use std::path::Path;
+use std::time::{Duration, Instant};
+
+const MAGIC: &[u8; 8] = b"SMUSHREC";
+const VERSION: u8 = 1;
+
+/// Records raw bytes received from the server, along with when they arrived, so that sessions
+/// can be replayed later at their original pace.
+///
+/// The format is an 8-byte magic number and a version byte, followed by one frame per packet:
+/// microseconds since the recording started (u64 LE), payload length (u32 LE), and payload.
+#[derive(Debug)]
+pub struct SessionRecorder<W: Write = BufWriter<File>> {
+    writer: W,
+    started: Instant,
+}
+
+impl SessionRecorder {
+    pub fn create<P: AsRef<Path>>(path: P) -> io::Result<Self> {
+        Self::new(BufWriter::new(File::create(path)?))
+    }
+}
+
+impl<W: Write> SessionRecorder<W> {
+    pub fn new(mut writer: W) -> io::Result<Self> {
+        writer.write_all(MAGIC)?;
+        writer.write_all(&[VERSION])?;
+        Ok(Self {
+            writer,
+            started: Instant::now(),
+        })
+    }
+
+    pub fn record(&mut self, bytes: &[u8]) -> io::Result<()> {
+        let micros = u64::try_from(self.started.elapsed().as_micros()).unwrap_or(u64::MAX);
+        for chunk in bytes.chunks(u32::MAX as usize) {
+            #[allow(clippy::cast_possible_truncation)]
+            let len = chunk.len() as u32;
+            self.writer.write_all(&micros.to_le_bytes())?;
+            self.writer.write_all(&len.to_le_bytes())?;
+            self.writer.write_all(chunk)?;
+        }
+        Ok(())
+    }
+
+    pub fn flush(&mut self) -> io::Result<()> {
+        self.writer.flush()
+    }
+
+    pub fn into_inner(mut self) -> io::Result<W> {
+        self.writer.flush()?;
+        Ok(self.writer)
+    }
+}
+
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct SessionFrame {
+    /// Time since the start of the recording.
+    pub offset: Duration,
+    pub bytes: Vec<u8>,
+}
+
+/// Reads frames written by a [`SessionRecorder`].
+#[derive(Debug)]
+pub struct SessionReader<R> {
+    reader: R,
+}
+
+impl<R: Read> SessionReader<R> {
+    pub fn new(mut reader: R) -> io::Result<Self> {
+        let mut header = [0; MAGIC.len() + 1];
+        reader.read_exact(&mut header)?;
+        if &header[..MAGIC.len()] != MAGIC || header[MAGIC.len()] != VERSION {
+            return Err(io::Error::new(
+                io::ErrorKind::InvalidData,
+                "not a session recording",
+            ));
+        }
+        Ok(Self { reader })
+    }
+
+    fn read_frame(&mut self) -> io::Result<Option<SessionFrame>> {
+        let mut micros = [0; 8];
+        match self.reader.read_exact(&mut micros) {
+            Ok(()) => (),
+            Err(e) if e.kind() == io::ErrorKind::UnexpectedEof => return Ok(None),
+            Err(e) => return Err(e),
+        }
+        let mut len = [0; 4];
+        self.reader.read_exact(&mut len)?;
+        let mut bytes = vec![0; u32::from_le_bytes(len) as usize];
+        self.reader.read_exact(&mut bytes)?;
+        Ok(Some(SessionFrame {
+            offset: Duration::from_micros(u64::from_le_bytes(micros)),
+            bytes,
+        }))
+    }
+}
+
+impl<R: Read> Iterator for SessionReader<R> {
+    type Item = io::Result<SessionFrame>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        self.read_frame().transpose()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn recording_round_trip() {
+        let mut recorder = SessionRecorder::new(Vec::new()).unwrap();
+        recorder.record(b"\x1b[31mhello\x1b[0m\r\n").unwrap();
+        recorder
+            .record(b"\xff\xfa\xc9Core.Hello {}\xff\xf0")
+            .unwrap();
+        let recording = recorder.into_inner().unwrap();
+        let frames = SessionReader::new(recording.as_slice())
+            .unwrap()
+            .map(|frame| frame.unwrap().bytes)
+            .collect::<Vec<_>>();
+        assert_eq!(
+            frames,
+            [
+                b"\x1b[31mhello\x1b[0m\r\n".to_vec(),
+                b"\xff\xfa\xc9Core.Hello {}\xff\xf0".to_vec()
+            ]
+        );
+    }
+
+    #[test]
+    fn rejects_other_files() {
+        assert!(SessionReader::new(b"not a recording".as_slice()).is_err());
+    }
+}
@@ -0,0 +1,456 @@
+use std::fmt;
+use std::fs;
+use std::io::{self, Read};
+use std::ops::Range;
+use std::thread;
+use std::time::{Duration, Instant};
+
+use mud_transformer::output::{Output, OutputFragment};
+
+use super::read_buffer::ReadBuffer;
+use super::recording::SessionReader;
+use super::smushclient::SmushClient;
+use crate::handler::Handler;
+use crate::plugins::{SendRequest, SendScriptRequest, SpanStyle};
+
+/// Measurements taken by [`replay`].
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+pub struct ReplayStats {
+    pub packets: usize,
+    pub bytes: u64,
+    pub lines: u64,
+    /// Number of sends and script calls made by triggers.
+    pub fires: u64,
+    /// Time spent receiving and displaying packets, not counting time spent waiting to keep
+    /// pace with the recording.
+    pub busy: Duration,
+    /// Time from receiving each packet to displaying its output, in ascending order.
+    pub latencies: Vec<Duration>,
+    /// Peak resident set size of the process in bytes, if the platform reports it.
+    pub peak_rss: Option<u64>,
+}
+
+impl ReplayStats {
+    fn per_sec(&self, n: u64) -> f64 {
+        #[allow(clippy::cast_precision_loss)]
+        let n = n as f64;
+        n / self.busy.as_secs_f64()
+    }
+
+    pub fn bytes_per_sec(&self) -> f64 {
+        self.per_sec(self.bytes)
+    }
+
+    pub fn lines_per_sec(&self) -> f64 {
+        self.per_sec(self.lines)
+    }
+
+    pub fn fires_per_sec(&self) -> f64 {
+        self.per_sec(self.fires)
+    }
+
+    /// Returns the packet latency at a percentile between 0 and 100, by the nearest-rank method.
+    pub fn latency(&self, percentile: usize) -> Duration {
+        if self.latencies.is_empty() {
+            return Duration::ZERO;
+        }
+        let rank = (percentile.min(100) * self.latencies.len()).div_ceil(100);
+        self.latencies[rank.saturating_sub(1)]
+    }
+}
+
+impl fmt::Display for ReplayStats {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(
+            f,
+            "{} packets, {} bytes, {} lines, {} fires in {:?}: {:.0} bytes/s, {:.0} lines/s, \
+             {:.0} fires/s, p50 {:?}, p99 {:?}",
+            self.packets,
+            self.bytes,
+            self.lines,
+            self.fires,
+            self.busy,
+            self.bytes_per_sec(),
+            self.lines_per_sec(),
+            self.fires_per_sec(),
+            self.latency(50),
+            self.latency(99),
+        )?;
+        if let Some(peak_rss) = self.peak_rss {
+            write!(f, ", peak RSS {} KiB", peak_rss / 1024)?;
+        }
+        Ok(())
+    }
+}
+
+/// Feeds a recorded session through a client the same way a connection would, one packet at a
+/// time, and measures how long the client takes to process it.
+///
+/// If `speed` is `None`, packets are replayed as fast as the client can take them. Otherwise,
+/// packets are replayed at their recorded pace, sped up by the given factor.
+pub fn replay<R: Read, H: Handler>(
+    client: &SmushClient,
+    session: SessionReader<R>,
+    handler: &mut H,
+    speed: Option<f64>,
+) -> io::Result<ReplayStats> {
+    let mut handler = CountingHandler {
+        inner: handler,
+        lines: 0,
+        fires: 0,
+    };
+    let mut stats = ReplayStats::default();
+    let mut read_buf = ReadBuffer::default();
+    let started = Instant::now();
+    for frame in session {
+        let frame = frame?;
+        if let Some(speed) = speed
+            && let Some(wait) = frame.offset.div_f64(speed).checked_sub(started.elapsed())
+        {
+            thread::sleep(wait);
+        }
+        let received = Instant::now();
+        let n = client.read(frame.bytes.as_slice(), read_buf.as_mut_slice())?;
+        read_buf.record(n);
+        client.drain_output(&mut handler);
+        let latency = received.elapsed();
+        // Discard replies to the server, as there is no server.
+        client.write(&mut io::sink())?;
+        stats.packets += 1;
+        stats.bytes += n as u64;
+        stats.busy += latency;
+        stats.latencies.push(latency);
+    }
+    let flushing = Instant::now();
+    client.flush_output(&mut handler);
+    stats.busy += flushing.elapsed();
+    stats.latencies.sort_unstable();
+    stats.lines = handler.lines;
+    stats.fires = handler.fires;
+    stats.peak_rss = peak_rss();
+    Ok(stats)
+}
+
+fn peak_rss() -> Option<u64> {
+    let status = fs::read_to_string("/proc/self/status").ok()?;
+    let kib = status
+        .lines()
+        .find_map(|line| line.strip_prefix("VmHWM:"))?
+        .trim()
+        .strip_suffix("kB")?
+        .trim()
+        .parse::<u64>()
+        .ok()?;
+    Some(kib * 1024)
+}
+
+struct CountingHandler<'a, H> {
+    inner: &'a mut H,
+    lines: u64,
+    fires: u64,
+}
+
+impl<H: Handler> Handler for CountingHandler<'_, H> {
+    fn apply_styles(&mut self, range: Range<usize>, style: SpanStyle) {
+        self.inner.apply_styles(range, style);
+    }
+
+    fn display(&mut self, output: &Output) {
+        if matches!(
+            output.fragment,
+            OutputFragment::LineBreak | OutputFragment::PageBreak | OutputFragment::Hr
+        ) {
+            self.lines += 1;
+        }
+        self.inner.display(output);
+    }
+
+    fn display_error(&mut self, error: &str) {
+        self.inner.display_error(error);
+    }
+
+    fn echo(&mut self, input: &str) {
+        self.inner.echo(input);
+    }
+
+    fn erase_last_line(&mut self) {
+        self.inner.erase_last_line();
+    }
+
+    fn send(&mut self, request: SendRequest) {
+        self.fires += 1;
+        self.inner.send(request);
+    }
+
+    fn send_script(&mut self, request: SendScriptRequest) {
+        self.fires += 1;
+        self.inner.send_script(request);
+    }
+
+    fn permit_line(&mut self, line: &str) -> bool {
+        self.inner.permit_line(line)
+    }
+
+    fn permit_sound(&mut self, file: &str) -> bool {
+        self.inner.permit_sound(file)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::borrow::Cow;
+    use std::env;
+    use std::fs::File;
+    use std::io::BufReader;
+
+    use smushclient_plugins::Trigger;
+
+    use super::*;
+    use crate::client::SessionRecorder;
+    use crate::testing::{self, RecordingHandler};
+    use crate::world::World;
+
+    fn client(triggers: Vec<Trigger>) -> Option<SmushClient> {
+        testing::client(World {
+            triggers: Cow::Owned(triggers),
+            ..Default::default()
+        })
+    }
+
+    fn trigger(pattern: &str, text: &str) -> Trigger {
+        let mut trigger = Trigger::default();
+        trigger.send.text = text.to_owned();
+        trigger.set_pattern(pattern.to_owned()).unwrap();
+        trigger
+    }
+
+    /// Records `lines` lines of colour spam, interleaved with GMCP subnegotiations and MXP tags,
+    /// in packets of up to 40 lines.
+    fn generate_session(lines: usize) -> Vec<u8> {
+        let mut recorder = SessionRecorder::new(Vec::new()).unwrap();
+        let mut packet = Vec::new();
+        for i in 0..lines {
+            let color = 31 + i % 7;
+            match i % 10 {
+                0 => packet.extend_from_slice(b"\xff\xfa\xc9Char.Vitals {\"hp\":100}\xff\xf0"),
+                1 => packet.extend_from_slice(b"\x1b[1z<B>A rat</B> is here.\r\n"),
+                _ => {
+                    let line = format!("\x1b[1;{color}mYou hit the rat ({i}).\x1b[0m\r\n");
+                    packet.extend_from_slice(line.as_bytes());
+                }
+            }
+            if i % 40 == 39 {
+                recorder.record(&packet).unwrap();
+                packet.clear();
+            }
+        }
+        recorder.record(&packet).unwrap();
+        recorder.into_inner().unwrap()
+    }
+
+    #[test]
+    fn replay_counts_lines_and_fires() {
+        let Some(client) = client(vec![trigger("You hit *", "cheer")]) else {
+            return;
+        };
+        let packets: [&[u8]; 2] = [
+            b"You hit the rat.\r\nThe rat",
+            b" flees.\r\nYou hit the air.\r\n",
+        ];
+        let mut recorder = SessionRecorder::new(Vec::new()).unwrap();
+        for packet in packets {
+            recorder.record(packet).unwrap();
+        }
+        let recording = recorder.into_inner().unwrap();
+        let session = SessionReader::new(recording.as_slice()).unwrap();
+        let mut handler = RecordingHandler::new();
+        let stats = replay(&client, session, &mut handler, None).unwrap();
+        assert_eq!(stats.packets, 2);
+        assert_eq!(stats.bytes, packets.concat().len() as u64);
+        assert_eq!(stats.lines, 3);
+        assert_eq!(stats.fires, 2);
+        assert_eq!(handler.lines(), 3);
+        assert_eq!(stats.latencies.len(), 2);
+    }
+
+    fn benchmark_triggers() -> Vec<Trigger> {
+        (0..200)
+            .map(|i| match i % 4 {
+                0 => trigger(&format!("You hit the rat ({i})."), "cheer"),
+                1 => trigger(&format!("* rat ({i}).*"), "look"),
+                2 => trigger(&format!("A {i} is here."), "kill"),
+                _ => trigger(&format!("*{i} flees*"), "follow"),
+            })
+            .collect()
+    }
+
+    /// Replays the recording at `$SMUSHCLIENT_REPLAY`, or a generated session if it is unset,
+    /// into a client with 200 triggers.
+    #[test]
+    #[ignore = "benchmark"]
+    fn replay_throughput() {
+        let Some(client) = client(benchmark_triggers()) else {
+            return;
+        };
+        let mut handler = RecordingHandler::new();
+        let stats = match env::var_os("SMUSHCLIENT_REPLAY") {
+            Some(path) => {
+                let session = SessionReader::new(BufReader::new(File::open(path).unwrap()));
+                replay(&client, session.unwrap(), &mut handler, None)
+            }
+            None => {
+                let recording = generate_session(100_000);
+                let session = SessionReader::new(recording.as_slice()).unwrap();
+                replay(&client, session, &mut handler, None)
+            }
+        }
+        .unwrap();
+        println!("{stats}");
+    }
+
+    /// Compares how long a flood of output holds the thread when it is read all at once with how
+    /// long each 16 KiB slice holds it when reads are shared fairly between worlds.
+    #[test]
+    #[ignore = "benchmark"]
+    fn fair_read_slices() {
+        const SLICE: usize = 16 * 1024;
+        let Some(client) = client(benchmark_triggers()) else {
+            return;
+        };
+        let flood: Vec<u8> = (0..100_000)
+            .flat_map(|i| {
+                format!("\x1b[1;{}mYou hit the rat ({i}).\x1b[0m\r\n", 31 + i % 7).into_bytes()
+            })
+            .collect();
+        let mut handler = RecordingHandler::new();
+        let mut read_buf = ReadBuffer::default();
+
+        let started = Instant::now();
+        client
+            .read(flood.as_slice(), read_buf.as_mut_slice())
+            .unwrap();
+        client.drain_output(&mut handler);
+        println!("{} bytes at once: {:?}", flood.len(), started.elapsed());
+
+        let mut reader = flood.as_slice();
+        let mut slices = Vec::new();
+        while !reader.is_empty() {
+            let started = Instant::now();
+            client
+                .read_at_most(&mut reader, read_buf.as_mut_slice(), SLICE)
+                .unwrap();
+            client.drain_output(&mut handler);
+            slices.push(started.elapsed());
+        }
+        slices.sort_unstable();
+        println!(
+            "{} slices of {SLICE} bytes: median {:?}, max {:?}",
+            slices.len(),
+            slices[slices.len() / 2],
+            slices[slices.len() - 1],
+        );
+    }
+
+    /// A world that is fed from an in-memory stand-in for its server.
+    struct SimulatedWorld<'a> {
+        client: SmushClient,
+        server: &'a [u8],
+        handler: RecordingHandler<'static>,
+        read_buf: ReadBuffer,
+        first_output: Option<FirstOutput>,
+    }
+
+    /// When a world first displayed a line.
+    #[derive(Debug)]
+    struct FirstOutput {
+        /// Number of times every world had been given a turn to read.
+        pass: usize,
+        /// Bytes read by other worlds before the world's own read.
+        waited_bytes: usize,
+        waited: Duration,
+    }
+
+    /// Serves each world's server output in turn on one thread, the way the frontend's event loop
+    /// does, reading at most `limit` bytes per world per turn. Returns when each world first
+    /// displayed a line, and the most bytes read in a single turn.
+    fn serve_worlds(servers: &[&[u8]], limit: usize) -> Option<(Vec<FirstOutput>, usize)> {
+        let mut worlds = Vec::with_capacity(servers.len());
+        for server in servers {
+            worlds.push(SimulatedWorld {
+                client: client(Vec::new())?,
+                server: *server,
+                handler: RecordingHandler::new(),
+                read_buf: ReadBuffer::default(),
+                first_output: None,
+            });
+        }
+        let started = Instant::now();
+        let mut processed = 0;
+        let mut max_turn = 0;
+        let mut pass = 0;
+        while worlds.iter().any(|world| !world.server.is_empty()) {
+            for world in &mut worlds {
+                if world.server.is_empty() {
+                    continue;
+                }
+                let n = world
+                    .client
+                    .read_at_most(&mut world.server, world.read_buf.as_mut_slice(), limit)
+                    .unwrap();
+                world.read_buf.record(n);
+                world.client.drain_output(&mut world.handler);
+                if world.first_output.is_none() && world.handler.lines() != 0 {
+                    world.first_output = Some(FirstOutput {
+                        pass,
+                        waited_bytes: processed,
+                        waited: started.elapsed(),
+                    });
+                }
+                processed += n;
+                max_turn = max_turn.max(n);
+            }
+            pass += 1;
+        }
+        let first_outputs = worlds
+            .into_iter()
+            .map(|world| world.first_output.unwrap())
+            .collect();
+        Some((first_outputs, max_turn))
+    }
+
+    /// 19 worlds flood output while a 20th echoes a command the user just sent, and is the last
+    /// to be given a turn. With fair reads, the quiet world waits for one slice from each of the
+    /// others instead of for their whole floods.
+    #[test]
+    fn fair_reads_bound_quiet_world_latency() {
+        const NOISY: usize = 19;
+        const SLICE: usize = 16 * 1024;
+        let flood: Vec<u8> = (0..3000)
+            .flat_map(|i| format!("You hit the rat ({i}).\r\n").into_bytes())
+            .collect();
+        let echo = b"You say 'hi'.\r\n".as_slice();
+        let mut servers = vec![flood.as_slice(); NOISY];
+        servers.push(echo);
+
+        let Some((unfair, _)) = serve_worlds(&servers, usize::MAX) else {
+            return;
+        };
+        let (fair, max_turn) = serve_worlds(&servers, SLICE).unwrap();
+        for (i, (unfair, fair)) in unfair.iter().zip(&fair).enumerate() {
+            println!(
+                "world {i:2}: waited {:>8} bytes, {:?} unlimited; {:>8} bytes, {:?} fair",
+                unfair.waited_bytes, unfair.waited, fair.waited_bytes, fair.waited,
+            );
+        }
+
+        let quiet = &fair[NOISY];
+        assert_eq!(unfair[NOISY].waited_bytes, NOISY * flood.len());
+        assert_eq!(
+            quiet.pass, 0,
+            "quiet world should be served in the first pass"
+        );
+        assert!(max_turn < SLICE + ReadBuffer::DEFAULT_MAX_LEN / 2);
+        assert!(quiet.waited_bytes <= NOISY * max_turn);
+        assert!(quiet.waited_bytes < NOISY * flood.len() / 2);
+    }
+}
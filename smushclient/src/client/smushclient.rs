@@ -20,11 +20,12 @@ use smushclient_plugins::{
 use tokio::io::{AsyncRead, AsyncReadExt};
 
 use super::clipboard::Clipboard;
-use super::info::ClientInfo;
+use super::info::{ClientInfo, Throughput};
 use super::logger::Logger;
+use super::prematch;
 use super::variables::PluginVariables;
 use crate::LuaStr;
-use crate::audio::{AudioError, AudioSinkStatus, AudioSinks, PlayMode};
+use crate::audio::{AudioError, AudioSinkStatus, AudioSinks, PlayMode, StreamError};
 use crate::get_info::InfoVisitor;
 use crate::handler::Handler;
 use crate::import::{ImportedWorld, Imports};
@@ -48,6 +49,7 @@ pub struct SmushClient {
     audio: AudioSinks,
     output_buffer: RefCell<Vec<Output>>,
     info: ClientInfo,
+    match_threads: usize,
 }
 
 impl Default for SmushClient {
@@ -61,6 +63,16 @@ impl SmushClient {
     ///
     /// Panics if audio initialization fails.
     pub fn new(world: World<'static>, will: ByteSet, supported_tags: FlagSet<Tag>) -> Self {
+        Self::try_new(world, will, supported_tags).expect("audio initialization error")
+    }
+
+    /// Like [`new`](Self::new), but returns an error instead of panicking if audio initialization
+    /// fails, e.g. on a machine without an output device.
+    pub fn try_new(
+        world: World<'static>,
+        will: ByteSet,
+        supported_tags: FlagSet<Tag>,
+    ) -> Result<Self, StreamError> {
         let World {
             config,
             timers,
@@ -77,7 +89,7 @@ impl SmushClient {
             ..config.world_plugin()
         });
 
-        Self {
+        Ok(Self {
             logger: RefCell::new(Logger::new(&config)),
             plugins,
             supported_tags,
@@ -87,10 +99,11 @@ impl SmushClient {
             )),
             variables: RefCell::default(),
             world: RefCell::new(config),
-            audio: AudioSinks::try_default().expect("audio initialization error"),
+            audio: AudioSinks::try_default()?,
             output_buffer: RefCell::default(),
             info: ClientInfo::default(),
-        }
+            match_threads: 1,
+        })
     }
 
     pub fn import_world<R: Read>(
@@ -124,6 +137,16 @@ impl SmushClient {
         self.supported_tags = supported_tags;
     }
 
+    /// Sets the number of threads used to match lines against triggers and aliases. 0 uses the
+    /// number of available CPUs, up to 16. 1, the default, matches on the calling thread.
+    ///
+    /// Only matching is spread across threads, and only when there are enough patterns to make
+    /// it worthwhile. Effects are still applied on the calling thread, in plugin and sequence
+    /// order, with the same results as matching serially.
+    pub fn set_match_threads(&mut self, threads: usize) {
+        self.match_threads = prematch::resolve_threads(threads);
+    }
+
     pub fn all_senders<T: PluginSender>(&self) -> AllSendersIter<'_, T> {
         self.plugins.all_senders::<T>()
     }
@@ -221,6 +244,20 @@ impl SmushClient {
         self.logger.borrow().is_open()
     }
 
+    pub fn is_recording(&self) -> bool {
+        self.logger.borrow().is_recording()
+    }
+
+    /// Starts recording raw received bytes to `path` as a replayable [`SessionRecorder`] file,
+    /// replacing any recording already in progress.
+    pub fn start_recording(&self, path: &str) -> io::Result<()> {
+        self.logger.borrow_mut().start_recording(path)
+    }
+
+    pub fn stop_recording(&self) -> io::Result<()> {
+        self.logger.borrow_mut().stop_recording()
+    }
+
     pub fn reset_ansi(&self) {
         self.transformer.borrow_mut().reset_ansi();
     }
@@ -229,7 +266,18 @@ impl SmushClient {
         self.transformer.borrow_mut().reset_ansi();
     }
 
-    pub fn read<R: Read>(&self, mut reader: R, read_buf: &mut [u8]) -> io::Result<usize> {
+    pub fn read<R: Read>(&self, reader: R, read_buf: &mut [u8]) -> io::Result<usize> {
+        self.read_at_most(reader, read_buf, usize::MAX)
+    }
+
+    /// Like [`read`](Self::read), but returns once at least `limit` bytes have been read, leaving
+    /// anything else in the reader for a later call.
+    pub fn read_at_most<R: Read>(
+        &self,
+        mut reader: R,
+        read_buf: &mut [u8],
+        limit: usize,
+    ) -> io::Result<usize> {
         self.info.packets_received.update(|t| t + 1);
         let mut transformer = self.transformer.borrow_mut();
         let mut logger = self.logger.borrow_mut();
@@ -238,6 +286,7 @@ impl SmushClient {
         loop {
             let n = reader.read(&mut read_buf[..midpoint])?;
             if n == 0 {
+                self.info.sample_throughput();
                 return Ok(total_read);
             }
             total_read += n;
@@ -251,6 +300,10 @@ impl SmushClient {
             } else {
                 self.info.bytes_received_compressed.update(|t| t + n);
             }
+            if total_read >= limit {
+                self.info.sample_throughput();
+                return Ok(total_read);
+            }
         }
     }
 
@@ -271,7 +324,7 @@ impl SmushClient {
             total_read += n;
             self.info.bytes_received.update(|t| t + n as u64);
             let (received, buf) = read_buf.split_at_mut(n);
-            let _ = self.logger.borrow_mut().log_raw(buf);
+            let _ = self.logger.borrow_mut().log_raw(received);
             let n = self.transformer.borrow_mut().receive(received, buf) as u64;
             self.info.bytes_received_uncompressed.update(|t| t + n);
         }
@@ -308,6 +361,7 @@ impl SmushClient {
             if drain.len() == 0 {
                 return false;
             }
+            self.info.processing_passes.update(|t| t + 1);
             let mut output_buffer = self.output_buffer.borrow_mut();
             output_buffer.clear();
             output_buffer.extend(drain);
@@ -544,12 +598,16 @@ impl SmushClient {
         self.variables.borrow().count_variables(plugin_id)
     }
 
-    pub fn load_variables<R: Read>(&self, reader: R) -> Result<(), PersistError> {
-        *self.variables.borrow_mut() = PluginVariables::load(reader)?;
-        Ok(())
+    /// Loads variables from a file. Returns `false` if the file does not exist.
+    pub fn load_variables<P: AsRef<Path>>(&self, path: P) -> Result<bool, PersistError> {
+        let Some(variables) = PluginVariables::load(path)? else {
+            return Ok(false);
+        };
+        *self.variables.borrow_mut() = variables;
+        Ok(true)
     }
 
-    pub fn save_all_variables<W: Write>(&self, writer: W) -> Result<(), PersistError> {
+    pub fn save_all_variables<P: AsRef<Path>>(&self, path: P) -> Result<(), PersistError> {
         let plugins_to_save = self
             .plugins
             .iter()
@@ -558,17 +616,17 @@ impl SmushClient {
             .chain(iter::once(METAVARIABLES_KEY));
         self.variables
             .borrow_mut()
-            .save_all(writer, plugins_to_save)?;
+            .save_all(path, plugins_to_save)?;
         Ok(())
     }
 
-    pub fn save_variables_for<W: Write>(
+    pub fn save_variables_for<P: AsRef<Path>>(
         &self,
-        writer: W,
+        path: P,
         index: PluginIndex,
     ) -> Result<(), PersistError> {
-        let plugin_id = self.plugins[index].metadata.id.clone();
-        self.variables.borrow_mut().save_one(writer, plugin_id)
+        let plugin_id = &self.plugins[index].metadata.id;
+        self.variables.borrow_mut().save_one(path, plugin_id)
     }
 
     pub fn borrow_variables(
@@ -608,7 +666,7 @@ impl SmushClient {
             .set_variable(plugin_id, key, value);
     }
 
-    pub fn unset_variable(&self, index: PluginIndex, key: &str) -> Option<Vec<u8>> {
+    pub fn unset_variable(&self, index: PluginIndex, key: &str) -> bool {
         let plugin_id = &self.plugins[index].metadata.id;
         self.variables.borrow_mut().unset_variable(plugin_id, key)
     }
@@ -619,7 +677,7 @@ impl SmushClient {
             .set_variable(METAVARIABLES_KEY, key, value);
     }
 
-    pub fn unset_metavariable(&self, key: &str) -> Option<Vec<u8>> {
+    pub fn unset_metavariable(&self, key: &str) -> bool {
         self.variables
             .borrow_mut()
             .unset_variable(METAVARIABLES_KEY, key)
@@ -674,8 +732,7 @@ impl SmushClient {
         index: PluginIndex,
         label: &str,
     ) -> Option<Ref<'_, T>> {
-        self.senders::<T>(index)
-            .find(|sender| sender.as_ref().label == label)
+        self.senders::<T>(index).find_by_label(label)
     }
 
     pub fn borrow_sender_mut<T: PluginSender>(
@@ -684,7 +741,7 @@ impl SmushClient {
         label: &str,
     ) -> Result<RefMut<'_, T>, SenderAccessError> {
         self.senders::<T>(index)
-            .find_mut(|sender| sender.as_ref().label == label)
+            .find_by_label_mut(label)
             .ok_or(SenderAccessError::NotFound)
     }
 
@@ -694,7 +751,12 @@ impl SmushClient {
         label: &str,
         enabled: bool,
     ) -> Result<(), SenderAccessError> {
-        self.borrow_sender_mut::<T>(index, label)?.as_mut().enabled = enabled;
+        if !self
+            .senders::<T>(index)
+            .set_enabled_by_label(label, enabled)
+        {
+            return Err(SenderAccessError::NotFound);
+        }
         Ok(())
     }
 
@@ -704,17 +766,7 @@ impl SmushClient {
         group: &str,
         enabled: bool,
     ) -> usize {
-        self.senders::<T>(index)
-            .borrow_mut()
-            .iter_mut()
-            .fold(0, |acc, sender| {
-                let sender = sender.as_mut();
-                if sender.group != group {
-                    return acc;
-                }
-                sender.enabled = enabled;
-                acc + 1
-            })
+        self.senders::<T>(index).set_group_enabled(group, enabled)
     }
 
     pub fn senders<T: PluginSender>(&self, index: PluginIndex) -> &CursorVec<T> {
@@ -746,7 +798,7 @@ impl SmushClient {
     ) -> Result<(), SenderAccessError> {
         let senders = self.senders::<T>(index);
         let pos = senders
-            .position(|sender| sender.as_ref().label == label)
+            .position_by_label(label)
             .ok_or(SenderAccessError::NotFound)?;
         if !senders.remove(pos) {
             return Err(SenderAccessError::ItemInUse);
@@ -755,8 +807,7 @@ impl SmushClient {
     }
 
     pub fn remove_sender_group<T: PluginSender>(&self, index: PluginIndex, group: &str) -> usize {
-        self.senders::<T>(index)
-            .retain(|sender: &T| sender.as_ref().group != group)
+        self.senders::<T>(index).remove_group(group)
     }
 
     pub fn remove_temporary_senders<T: PluginSender>(&self) -> usize {
@@ -853,7 +904,8 @@ impl SmushClient {
             world_plugin.import_senders(triggers);
         }
         if !variables.is_empty() {
-            self.variables.borrow_mut().world_variables_mut().extend(
+            self.variables.borrow_mut().extend_variables(
+                "",
                 variables
                     .into_iter()
                     .map(|var| (var.name.into_owned(), var.value.into_owned().into_bytes())),
@@ -1077,6 +1129,16 @@ impl SmushClient {
         let mut has_style = false;
         let mut send_buffer = SendRequestBuffer::new(line, output);
         let mut clipboard = Clipboard::new();
+        let prematches = if self.match_threads > 1 {
+            let snapshots = self
+                .plugins
+                .iter()
+                .map(|plugin| (!plugin.disabled.get()).then(|| plugin.senders::<T>().matchers()))
+                .collect();
+            prematch::prematch(snapshots, line, self.match_threads)
+        } else {
+            Vec::new()
+        };
 
         for (plugin_index, plugin) in self.plugins.iter().enumerate() {
             if plugin.disabled.get() {
@@ -1088,94 +1150,127 @@ impl SmushClient {
             }
             let enable_scripts =
                 !plugin.metadata.is_world_plugin || self.world.borrow().enable_scripts;
-            for sender in senders.scan() {
-                let mut matched = false;
-                let mut keep_evaluating = true;
-                let regex = {
-                    let sender = sender.borrow();
-                    let reaction = sender.reaction();
-                    if !reaction.enabled {
+            // Patterns are tested against a snapshot of the enabled senders, so senders are only
+            // borrowed if they match. Patterns anchored to text the line does not start with are
+            // skipped without being run. If a handler adds, removes, enables or disables senders,
+            // the scan continues after the current sender in a new snapshot, so those changes
+            // apply to the rest of the line as they would to a scan of the senders themselves.
+            let mut matchers = senders.matchers();
+            let mut start = 0;
+            let scan = senders.scan();
+            loop {
+                let prematched = prematches
+                    .get(plugin_index)
+                    .and_then(Option::as_ref)
+                    .and_then(|prematch| prematch.get(&matchers));
+                let mut resume = None;
+                for (matcher_index, matcher) in matchers.candidates_from(line, start) {
+                    if prematched.is_some_and(|matched| !matched[matcher_index]) {
                         continue;
                     }
-                    reaction.regex.clone()
-                };
-                for (i, captures) in regex.captures_iter(line).filter_map(Result::ok).enumerate() {
-                    self.info.last_capture.set(i);
-                    if !matched {
-                        matched = true;
-                        let sender = sender.borrow();
-                        if can_echo && sender.echo_input() {
-                            handler.echo(line);
-                            can_echo = false;
+                    let mut captures_iter = matcher
+                        .regex()
+                        .captures_iter(line)
+                        .filter_map(Result::ok)
+                        .enumerate()
+                        .peekable();
+                    if captures_iter.peek().is_none() {
+                        continue;
+                    }
+                    // Fails if a handler has started another scan of these senders.
+                    let Some(sender) = scan.seek(&matchers, matcher) else {
+                        break;
+                    };
+                    let mut matched = false;
+                    let mut keep_evaluating = true;
+                    for (i, captures) in captures_iter {
+                        self.info.last_capture.set(i);
+                        if !matched {
+                            matched = true;
+                            let sender = sender.borrow();
+                            if can_echo && sender.echo_input() {
+                                handler.echo(line);
+                                can_echo = false;
+                            }
+                            if let Some(sound) = sender.sound()
+                                && self.world.borrow().enable_trigger_sounds
+                                && let Err(e) = self.play_file_raw(sound)
+                            {
+                                log::warn!(target: "smushclient.process_matches", "{e}");
+                            }
+                            if T::AFFECTS_STYLE {
+                                style = sender.style();
+                                has_style = !style.is_null();
+                            }
+                            sender.add_effects(effects);
+                            let reaction = sender.reaction();
+                            if reaction.one_shot {
+                                one_shots.insert(reaction.id);
+                            }
                         }
-                        if let Some(sound) = sender.sound()
-                            && self.world.borrow().enable_trigger_sounds
-                            && let Err(e) = self.play_file_raw(sound)
-                        {
-                            log::warn!(target: "smushclient.process_matches", "{e}");
+                        if has_style && let Some(capture) = captures.get(0) {
+                            handler.apply_styles(capture.start()..capture.end(), style);
                         }
-                        if T::AFFECTS_STYLE {
-                            style = sender.style();
-                            has_style = !style.is_null();
+                        if let Some(send_request) = {
+                            let sender = sender.borrow();
+                            if let Some(text) = sender.clipboard_text(&captures)
+                                && let Err(e) = clipboard.set_text(text)
+                            {
+                                log::warn!(target: "smushclient.process_matches", "{e}");
+                            }
+                            send_buffer.send_request(
+                                plugin_index,
+                                sender.reaction(),
+                                enable_scripts,
+                                Some(&captures),
+                            )
+                        } {
+                            self.handle_send_request(&send_request);
+                            handler.send(send_request);
                         }
-                        sender.add_effects(effects);
-                        let sender = sender.as_ref();
-                        if sender.one_shot {
-                            one_shots.insert(sender.id);
+                        // fresh borrow in case the handler changed the reaction's settings
+                        let sender = sender.borrow();
+                        let reaction = sender.reaction();
+                        keep_evaluating = reaction.keep_evaluating;
+                        if !reaction.repeats {
+                            break;
                         }
                     }
-                    if has_style && let Some(capture) = captures.get(0) {
-                        handler.apply_styles(capture.start()..capture.end(), style);
+                    if !matched {
+                        continue;
                     }
-                    if let Some(send_request) = {
-                        let sender = sender.borrow();
-                        if let Some(text) = sender.clipboard_text(&captures)
-                            && let Err(e) = clipboard.set_text(text)
+                    if enable_scripts
+                        && let Some(send_script_request) = send_buffer
+                            .send_script_request(plugin_index, sender.borrow().reaction())
+                    {
+                        for captures in send_script_request
+                            .regex
+                            .captures_iter(send_script_request.line)
+                            .filter_map(Result::ok)
                         {
-                            log::warn!(target: "smushclient.process_matches", "{e}");
+                            handler.send_script(SendScriptRequest {
+                                wildcards: Some(captures),
+                                ..send_script_request
+                            });
                         }
-                        send_buffer.send_request(
-                            plugin_index,
-                            sender.reaction(),
-                            enable_scripts,
-                            Some(&captures),
-                        )
-                    } {
-                        self.handle_send_request(&send_request);
-                        handler.send(send_request);
                     }
-                    // fresh borrow in case the handler changed the reaction's settings
-                    let sender = sender.borrow();
-                    let reaction = sender.reaction();
-                    keep_evaluating = reaction.keep_evaluating;
-                    if !reaction.repeats {
+                    if !keep_evaluating {
                         break;
                     }
-                }
-                if !matched {
-                    continue;
-                }
-                if enable_scripts
-                    && let Some(send_script_request) =
-                        send_buffer.send_script_request(plugin_index, sender.borrow().reaction())
-                {
-                    for captures in send_script_request
-                        .regex
-                        .captures_iter(send_script_request.line)
-                        .filter_map(Result::ok)
-                    {
-                        handler.send_script(SendScriptRequest {
-                            wildcards: Some(captures),
-                            ..send_script_request
-                        });
+                    resume = scan.resume(&matchers);
+                    if resume.is_some() {
+                        break;
                     }
                 }
-                if !keep_evaluating {
+                let Some((next, next_start)) = resume else {
                     break;
-                }
+                };
+                matchers = next;
+                start = next_start;
             }
+            drop(scan);
             if !one_shots.is_empty() {
-                senders.retain(|sender| !one_shots.contains(&sender.as_ref().id));
+                senders.retain(|sender| !one_shots.contains(&sender.reaction().id));
                 one_shots.clear();
             }
         }
@@ -1207,6 +1302,10 @@ impl SmushClient {
         self.plugins.all_senders::<T>().map(CursorVec::len).sum()
     }
 
+    pub fn throughput(&self) -> Throughput {
+        self.info.throughput()
+    }
+
     pub fn get_info<V: InfoVisitor>(&self, info_type: i64) -> V::Output {
         let info = &self.info;
         let world = self.world.borrow();
@@ -1260,6 +1359,15 @@ impl SmushClient {
             }),
             289 => V::visit(info.last_line_with_iac_ga.get()),
             310 => V::visit(info.lines_displayed.get()),
+            311 => V::visit(info.processing_passes.get()),
+            312..=314 => {
+                let throughput = self.throughput();
+                V::visit(match info_type {
+                    312 => throughput.packets_per_sec,
+                    313 => throughput.bytes_per_sec,
+                    _ => throughput.passes_per_sec,
+                })
+            }
             _ => V::visit_none(),
         }
     }
@@ -1274,3 +1382,248 @@ fn make_path_relative(path: &Path) -> &Path {
         }
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use smushclient_plugins::testing::{alias, wildcard_trigger};
+
+    use super::*;
+    use crate::testing::{Event, RecordingHandler, client, time};
+
+    fn script_alias(label: &str, sequence: i16) -> Alias {
+        let mut alias = alias(label, "go");
+        alias.sequence = sequence;
+        alias.keep_evaluating = true;
+        alias.send.script = "OnAlias".to_owned();
+        alias
+    }
+
+    fn alias_client(aliases: Vec<Alias>) -> Option<SmushClient> {
+        client(World {
+            aliases: Cow::Owned(aliases),
+            ..Default::default()
+        })
+    }
+
+    #[test]
+    fn handlers_change_senders_for_the_rest_of_the_line() {
+        let mut b = script_alias("b", 2);
+        b.enabled = false;
+        let aliases = vec![script_alias("a", 1), b, script_alias("c", 3)];
+        let Some(client) = alias_client(aliases) else {
+            return;
+        };
+        let mut handler = RecordingHandler::on_script(|request| {
+            if request.label == "a" {
+                client
+                    .set_sender_enabled::<Alias>(request.plugin, "b", true)
+                    .unwrap();
+                client
+                    .set_sender_enabled::<Alias>(request.plugin, "c", false)
+                    .unwrap();
+            }
+        });
+        client.alias("go", CommandSource::User, &mut handler);
+        assert_eq!(handler.scripts(), ["a", "b"]);
+    }
+
+    #[test]
+    fn handlers_add_and_remove_senders_for_the_rest_of_the_line() {
+        let aliases = vec![script_alias("a", 1), script_alias("c", 3)];
+        let Some(client) = alias_client(aliases) else {
+            return;
+        };
+        let mut handler = RecordingHandler::on_script(|request| {
+            if request.label == "a" {
+                let aliases = client.senders::<Alias>(request.plugin);
+                aliases.insert(script_alias("b", 2));
+                aliases.insert(script_alias("before", 0));
+                let c = aliases.position_by_label("c").unwrap();
+                assert!(aliases.remove(c));
+            }
+        });
+        client.alias("go", CommandSource::User, &mut handler);
+        assert_eq!(handler.scripts(), ["a", "b"]);
+    }
+
+    const BUSY_LEN: usize = 800;
+    const BUSY_LINE: &str = "go north past 3 orcs and 12 goblins";
+
+    /// Configures the `i`th of [`BUSY_LEN`] senders matched against [`BUSY_LINE`], enough that
+    /// matching is spread across threads when more than one is allowed. Most of them match, some
+    /// start disabled, those that match numbers repeat, every tenth calls a script, and the 520th
+    /// stops evaluation.
+    fn busy_reaction(reaction: &mut Reaction, i: usize) {
+        reaction.sequence = i16::try_from(i).unwrap();
+        reaction.keep_evaluating = i != 520;
+        reaction.enabled = i % 7 != 3;
+        reaction.one_shot = i == 40;
+        reaction.omit_from_output = i == 60;
+        match i % 4 {
+            0 => {
+                reaction.set_pattern(r"\d+".to_owned()).unwrap();
+                reaction.set_is_regex(true).unwrap();
+                reaction.repeats = true;
+            }
+            1 => reaction.set_pattern("go *".to_owned()).unwrap(),
+            2 => reaction.set_pattern("* goblins".to_owned()).unwrap(),
+            _ => reaction.set_pattern(format!("* {i} *")).unwrap(),
+        }
+        if i % 10 == 0 {
+            reaction.send.script = "OnBusy".to_owned();
+        } else {
+            reaction.send.text = format!("send {i}");
+        }
+    }
+
+    fn busy_alias(label: &str, i: usize) -> Alias {
+        let mut alias = alias(label, "go *");
+        busy_reaction(&mut alias, i);
+        alias
+    }
+
+    fn busy_trigger(label: &str, i: usize) -> Trigger {
+        let mut trigger = wildcard_trigger(label, "go *");
+        busy_reaction(&mut trigger, i);
+        trigger
+    }
+
+    fn busy_senders<T>(make: fn(&str, usize) -> T) -> Vec<T> {
+        (0..BUSY_LEN).map(|i| make(&format!("b{i}"), i)).collect()
+    }
+
+    type BusyRun<O> = (Vec<Event>, Vec<O>, Vec<String>);
+
+    /// Evaluates [`BUSY_LINE`] twice on up to `threads` threads, with scripts that enable,
+    /// disable, add and remove senders partway through. Returns what the handler was asked to
+    /// do, what `evaluate` returned each time, and the labels of the senders left afterward.
+    fn run_busy<T: PluginReaction, O>(
+        world: World<'static>,
+        threads: usize,
+        make: fn(&str, usize) -> T,
+        evaluate: fn(&SmushClient, &mut RecordingHandler) -> O,
+    ) -> Option<BusyRun<O>> {
+        let mut client = client(world)?;
+        client.set_match_threads(threads);
+        let mut handler = RecordingHandler::on_script(|request| {
+            let senders = client.senders::<T>(request.plugin);
+            match request.label {
+                "b100" => {
+                    senders.set_enabled_by_label("b110", false);
+                    senders.set_enabled_by_label("b101", true);
+                    senders.set_enabled_by_label("b3", true);
+                }
+                "b200" => {
+                    for label in ["b210", "b50"] {
+                        if let Some(i) = senders.position_by_label(label) {
+                            senders.remove(i);
+                        }
+                    }
+                    if senders.position_by_label("late").is_none() {
+                        senders.insert(make("late", 250));
+                    }
+                }
+                _ => (),
+            }
+        });
+        let outcomes = (0..2).map(|_| evaluate(&client, &mut handler)).collect();
+        let labels = client
+            .world_senders::<T>()
+            .borrow()
+            .iter()
+            .map(|sender| sender.reaction().label.clone())
+            .collect();
+        Some((handler.events, outcomes, labels))
+    }
+
+    fn assert_busy_run<O>(run: &BusyRun<O>) {
+        let (events, _, labels) = run;
+        let scripts: Vec<&str> = events
+            .iter()
+            .filter_map(|event| match event {
+                Event::Script { label, .. } => Some(label.as_str()),
+                _ => None,
+            })
+            .collect();
+        assert!(scripts.contains(&"late"));
+        assert!(!scripts.contains(&"b110"));
+        assert!(!scripts.contains(&"b530"));
+        assert_eq!(scripts.iter().filter(|label| **label == "b40").count(), 2);
+        assert!(events.iter().any(|event| matches!(
+            event,
+            Event::Send { text, .. } if text == "send 101"
+        )));
+        assert!(!labels.iter().any(|label| label == "b40" || label == "b210"));
+    }
+
+    #[test]
+    fn aliases_are_evaluated_the_same_on_any_number_of_threads() {
+        fn evaluate(client: &SmushClient, handler: &mut RecordingHandler) -> AliasOutcome {
+            client.alias(BUSY_LINE, CommandSource::User, handler)
+        }
+        let world = || World {
+            aliases: Cow::Owned(busy_senders(busy_alias)),
+            ..Default::default()
+        };
+        let Some(serial) = run_busy(world(), 1, busy_alias, evaluate) else {
+            return;
+        };
+        assert_busy_run(&serial);
+        for threads in [2, 4] {
+            let parallel = run_busy(world(), threads, busy_alias, evaluate).unwrap();
+            assert_eq!(parallel, serial);
+        }
+    }
+
+    #[test]
+    fn triggers_are_evaluated_the_same_on_any_number_of_threads() {
+        fn evaluate(client: &SmushClient, handler: &mut RecordingHandler) -> TriggerEffects {
+            client.trigger(BUSY_LINE, &[], handler)
+        }
+        let world = || World {
+            triggers: Cow::Owned(busy_senders(busy_trigger)),
+            ..Default::default()
+        };
+        let Some(serial) = run_busy(world(), 1, busy_trigger, evaluate) else {
+            return;
+        };
+        assert_busy_run(&serial);
+        assert!(serial.0.contains(&Event::EraseLastLine));
+        assert!(serial.1.iter().all(|effects| effects.omit_from_output));
+        for threads in [2, 4] {
+            let parallel = run_busy(world(), threads, busy_trigger, evaluate).unwrap();
+            assert_eq!(parallel, serial);
+        }
+    }
+
+    /// Compares commands sent through 1000 aliases that each start with a different word, when
+    /// the patterns are indexed by their literal prefix and when a group hides the prefix, so
+    /// that every pattern is run.
+    #[test]
+    #[ignore = "benchmark"]
+    fn alias_prefix_index() {
+        let patterns: [(&str, fn(usize) -> String); 2] = [
+            ("indexed", |i| format!("^a{i} (.*)$")),
+            ("not indexed", |i| format!("^(?:a{i}) (.*)$")),
+        ];
+        for (name, pattern) in patterns {
+            let aliases = (0..1000)
+                .map(|i| {
+                    let mut alias = alias(&format!("a{i}"), &pattern(i));
+                    alias.set_is_regex(true).unwrap();
+                    alias.send.text = "x".to_owned();
+                    alias
+                })
+                .collect();
+            let Some(client) = alias_client(aliases) else {
+                return;
+            };
+            let mut handler = RecordingHandler::new();
+            for command in ["a500 north", "say hello"] {
+                time(&format!("{name}, {command:?}"), 10_000, || {
+                    client.alias(command, CommandSource::User, &mut handler)
+                });
+            }
+        }
+    }
+}
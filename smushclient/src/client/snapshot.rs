@@ -0,0 +1,271 @@
+//! Snapshot format for plugin variables.
+//!
+//! A snapshot is a sequence of sections, one per plugin. Each section is the plugin ID followed by
+//! the length of its body, and the body is a sequence of keys and values. Every field is prefixed
+//! by its length as a little-endian u32, the same framing journal records use.
+//!
+//! Loading a snapshot only checks the framing of each section. Keys and values stay in the
+//! buffer the file was read into until a plugin's variables are first accessed, so opening a
+//! large file does not allocate every variable up front, and sections that are never changed are
+//! written back out by copying their bytes.
+
+use std::collections::HashMap;
+use std::fmt;
+use std::io::{self, Write};
+use std::ops::Range;
+use std::sync::{Arc, OnceLock};
+
+use super::journal::read_field;
+
+/// Variables of a single plugin, decoded on first access if they were loaded from a snapshot.
+#[derive(Clone, Default)]
+pub(crate) struct PluginSection {
+    /// Body of the section in the snapshot it was loaded from. Cleared once the variables are
+    /// modified.
+    encoded: Option<Encoded>,
+    decoded: OnceLock<HashMap<String, Vec<u8>>>,
+}
+
+impl PluginSection {
+    pub fn get(&self) -> &HashMap<String, Vec<u8>> {
+        self.decoded.get_or_init(|| match &self.encoded {
+            Some(encoded) => encoded.decode(),
+            None => HashMap::new(),
+        })
+    }
+
+    pub fn get_mut(&mut self) -> &mut HashMap<String, Vec<u8>> {
+        self.get();
+        self.encoded = None;
+        self.decoded.get_mut().expect("section should be decoded")
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    pub fn len(&self) -> usize {
+        match (self.decoded.get(), &self.encoded) {
+            (Some(variables), _) => variables.len(),
+            (None, Some(encoded)) => encoded.len,
+            (None, None) => 0,
+        }
+    }
+
+    /// Total size of every key and value.
+    pub fn byte_len(&self) -> u64 {
+        if let Some(encoded) = &self.encoded {
+            return encoded.byte_len;
+        }
+        self.get()
+            .iter()
+            .map(|(key, value)| (key.len() + value.len()) as u64)
+            .sum()
+    }
+
+    /// Writes the section for a plugin.
+    pub fn write(&self, writer: &mut dyn Write, plugin_id: &str) -> io::Result<()> {
+        write_field(writer, plugin_id.as_bytes())?;
+        if let Some(encoded) = &self.encoded {
+            write_len(writer, encoded.range.len())?;
+            return writer.write_all(encoded.bytes());
+        }
+        let variables = self.get();
+        let body_len = variables
+            .iter()
+            .map(|(key, value)| 8 + key.len() + value.len())
+            .sum();
+        write_len(writer, body_len)?;
+        for (key, value) in variables {
+            write_field(writer, key.as_bytes())?;
+            write_field(writer, value)?;
+        }
+        Ok(())
+    }
+}
+
+impl From<HashMap<String, Vec<u8>>> for PluginSection {
+    fn from(value: HashMap<String, Vec<u8>>) -> Self {
+        Self {
+            encoded: None,
+            decoded: OnceLock::from(value),
+        }
+    }
+}
+
+impl PartialEq for PluginSection {
+    fn eq(&self, other: &Self) -> bool {
+        self.get() == other.get()
+    }
+}
+
+impl Eq for PluginSection {}
+
+impl fmt::Debug for PluginSection {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        match (self.decoded.get(), &self.encoded) {
+            (None, Some(encoded)) => f
+                .debug_struct("PluginSection")
+                .field("len", &encoded.len)
+                .field("byte_len", &encoded.byte_len)
+                .finish_non_exhaustive(),
+            _ => self.get().fmt(f),
+        }
+    }
+}
+
+#[derive(Clone)]
+struct Encoded {
+    /// The whole snapshot, shared by every section read from it.
+    buf: Arc<Vec<u8>>,
+    range: Range<usize>,
+    /// Number of variables.
+    len: usize,
+    byte_len: u64,
+}
+
+impl Encoded {
+    fn bytes(&self) -> &[u8] {
+        &self.buf[self.range.clone()]
+    }
+
+    fn decode(&self) -> HashMap<String, Vec<u8>> {
+        let mut variables = HashMap::with_capacity(self.len);
+        let mut body = self.bytes();
+        while let Some((key, value, rest)) = read_variable(body) {
+            // Keys were validated when the snapshot was read.
+            let key = String::from_utf8_lossy(key).into_owned();
+            variables.insert(key, value.to_vec());
+            body = rest;
+        }
+        variables
+    }
+}
+
+/// Reads the sections of a snapshot, starting at `start`. Returns `None` if the snapshot is
+/// malformed.
+pub(crate) fn read(buf: &Arc<Vec<u8>>, start: usize) -> Option<HashMap<String, PluginSection>> {
+    let mut sections = HashMap::new();
+    let mut rest = buf.get(start..)?;
+    while !rest.is_empty() {
+        let (plugin_id, after_id) = read_field(rest)?;
+        let (body, after_body) = read_field(after_id)?;
+        let offset = buf.len() - after_body.len() - body.len();
+        let (len, byte_len) = validate(body)?;
+        let encoded = Encoded {
+            buf: buf.clone(),
+            range: offset..offset + body.len(),
+            len,
+            byte_len,
+        };
+        let section = PluginSection {
+            encoded: Some(encoded),
+            decoded: OnceLock::new(),
+        };
+        sections.insert(std::str::from_utf8(plugin_id).ok()?.to_owned(), section);
+        rest = after_body;
+    }
+    Some(sections)
+}
+
+/// Checks the framing of a section body without decoding it. Returns the number of variables and
+/// their total size. If a key appears more than once, only its last value is counted, since that
+/// is the value decoding keeps.
+fn validate(mut body: &[u8]) -> Option<(usize, u64)> {
+    let mut sizes = HashMap::new();
+    while !body.is_empty() {
+        let (key, value, rest) = read_variable(body)?;
+        std::str::from_utf8(key).ok()?;
+        sizes.insert(key, (key.len() + value.len()) as u64);
+        body = rest;
+    }
+    Some((sizes.len(), sizes.values().sum()))
+}
+
+fn read_variable(body: &[u8]) -> Option<(&[u8], &[u8], &[u8])> {
+    let (key, rest) = read_field(body)?;
+    let (value, rest) = read_field(rest)?;
+    Some((key, value, rest))
+}
+
+fn write_len(writer: &mut dyn Write, len: usize) -> io::Result<()> {
+    let len = u32::try_from(len).map_err(|_| io::Error::other("variables are too large"))?;
+    writer.write_all(&len.to_le_bytes())
+}
+
+fn write_field(writer: &mut dyn Write, field: &[u8]) -> io::Result<()> {
+    write_len(writer, field.len())?;
+    writer.write_all(field)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn encode(sections: &[(&str, &PluginSection)]) -> Arc<Vec<u8>> {
+        let mut buf = vec![0];
+        for (plugin_id, section) in sections {
+            section.write(&mut buf, plugin_id).unwrap();
+        }
+        Arc::new(buf)
+    }
+
+    #[test]
+    fn round_trip() {
+        let plugin = PluginSection::from(HashMap::from([
+            ("a".to_owned(), b"1".to_vec()),
+            ("b".to_owned(), Vec::new()),
+        ]));
+        let empty = PluginSection::default();
+        let buf = encode(&[("plugin", &plugin), ("", &empty)]);
+        let sections = read(&buf, 1).unwrap();
+        assert_eq!(sections.len(), 2);
+        let loaded = &sections["plugin"];
+        assert!(loaded.decoded.get().is_none());
+        assert_eq!(loaded.len(), 2);
+        assert_eq!(loaded.byte_len(), plugin.byte_len());
+        assert_eq!(loaded, &plugin);
+        assert!(sections[""].is_empty());
+        // Unmodified sections are written back out unchanged.
+        let reencoded = encode(&[("plugin", loaded), ("", &sections[""])]);
+        assert_eq!(reencoded, buf);
+    }
+
+    #[test]
+    fn modified_section_is_reencoded() {
+        let plugin = PluginSection::from(HashMap::from([("a".to_owned(), b"1".to_vec())]));
+        let mut sections = read(&encode(&[("plugin", &plugin)]), 1).unwrap();
+        let loaded = sections.get_mut("plugin").unwrap();
+        loaded.get_mut().insert("b".to_owned(), b"2".to_vec());
+        let sections = read(&encode(&[("plugin", loaded)]), 1).unwrap();
+        assert_eq!(sections["plugin"].get().get("b"), Some(&b"2".to_vec()));
+        assert_eq!(sections["plugin"].len(), 2);
+    }
+
+    #[test]
+    fn read_rejects_truncated_snapshot() {
+        let plugin = PluginSection::from(HashMap::from([("a".to_owned(), b"1".to_vec())]));
+        let buf = encode(&[("plugin", &plugin)]);
+        for end in 2..buf.len() {
+            assert!(read(&Arc::new(buf[..end].to_vec()), 1).is_none());
+        }
+    }
+
+    #[test]
+    fn duplicate_keys_count_once() {
+        let mut body = Vec::new();
+        for (key, value) in [("a", "1"), ("b", "2"), ("a", "333")] {
+            write_field(&mut body, key.as_bytes()).unwrap();
+            write_field(&mut body, value.as_bytes()).unwrap();
+        }
+        let mut buf = vec![0];
+        write_field(&mut buf, b"plugin").unwrap();
+        write_field(&mut buf, &body).unwrap();
+        let sections = read(&Arc::new(buf), 1).unwrap();
+        let loaded = &sections["plugin"];
+        assert_eq!(loaded.len(), 2);
+        assert_eq!(loaded.byte_len(), 6);
+        assert_eq!(loaded.get().len(), loaded.len());
+        assert_eq!(loaded.get().get("a"), Some(&b"333".to_vec()));
+    }
+}
@@ -1,62 +1,237 @@
 use std::borrow::Cow;
 use std::collections::HashMap;
 use std::fmt;
+use std::fs::{self, OpenOptions};
 use std::hash::BuildHasher;
-use std::io::{Read, Write};
-use std::ops::{Deref, DerefMut};
+use std::io::{self, Write};
+use std::ops::Deref;
+use std::path::Path;
+use std::sync::Arc;
 
 use serde::{Deserialize, Serialize};
 use smushclient_plugins::xml::XmlVec;
 
+use super::journal::{self, Record, VariableStore};
+use super::snapshot::{self, PluginSection};
 use crate::world::PersistError;
 
-const CURRENT_VERSION: u8 = 2;
+const CURRENT_VERSION: u8 = 3;
 
-#[derive(Clone, Debug, Default, PartialEq, Eq)]
+/// Journals shorter than this are never compacted.
+const MIN_COMPACT_LEN: u64 = 1 << 20;
+
+/// Plugin variables and their persistence.
+///
+/// Variables are saved to a file as a snapshot plus an append-only journal of changes made since
+/// the snapshot. Saving appends only the variables that changed, and the snapshot is rewritten in
+/// the background once the journal grows larger than it. Both are written by a background thread.
+#[derive(Debug, Default)]
 pub(crate) struct PluginVariables {
     live: PluginVariableMap,
-    persistent: PluginVariableMap,
+    /// For each variable that changed since it was last saved, its saved value, or `None` if it
+    /// was not saved.
+    unsaved: HashMap<String, HashMap<String, Option<Vec<u8>>>>,
+    store: Option<VariableStore>,
+    /// Approximate size of the last snapshot.
+    snapshot_len: u64,
 }
 
 impl PluginVariables {
-    pub fn load<R: Read>(reader: R) -> Result<Self, PersistError> {
-        PluginVariableMap::load(reader).map(Into::into)
+    /// Loads variables from a file, replaying its journal if it has one. Returns `None` if the
+    /// file does not exist.
+    pub fn load<P: AsRef<Path>>(path: P) -> Result<Option<Self>, PersistError> {
+        let path = path.as_ref();
+        let buf = match fs::read(path) {
+            Err(e) if e.kind() == io::ErrorKind::NotFound => return Ok(None),
+            buf => buf?,
+        };
+        let snapshot_len = buf.len() as u64;
+        let mut live = PluginVariableMap::load(buf)?;
+        let journal_path = journal::journal_path(path);
+        let journal = match fs::read(&journal_path) {
+            Err(e) if e.kind() == io::ErrorKind::NotFound => Vec::new(),
+            journal => journal?,
+        };
+        let valid = journal::replay(&journal, |record| live.apply(record));
+        if valid < journal.len() {
+            // Discard a record torn by a crash, so that new records are not appended after it.
+            OpenOptions::new()
+                .write(true)
+                .open(&journal_path)?
+                .set_len(valid as u64)?;
+        }
+        Ok(Some(Self {
+            live,
+            unsaved: HashMap::new(),
+            store: Some(VariableStore::new(path.to_owned(), valid as u64)),
+            snapshot_len,
+        }))
     }
 
     pub fn is_dirty(&self) -> bool {
-        self.live != self.persistent
+        !self.unsaved.is_empty()
+    }
+
+    pub fn set_variable(&mut self, plugin_id: &str, key: &str, value: &[u8]) {
+        if let Some(saved) = self.saved_value(plugin_id, key) {
+            let restored = saved.as_deref() == Some(value);
+            self.live.set_variable(plugin_id, key, value);
+            if restored {
+                self.forget_change(plugin_id, key);
+            }
+            return;
+        }
+        if self.live.get_variable(plugin_id, key) == Some(value) {
+            return;
+        }
+        let old = self.live.replace_variable(plugin_id, key, value.to_owned());
+        self.record_change(plugin_id, key, old);
+    }
+
+    /// Returns `true` if the variable existed.
+    pub fn unset_variable(&mut self, plugin_id: &str, key: &str) -> bool {
+        let Some(old) = self.live.unset_variable(plugin_id, key) else {
+            return false;
+        };
+        match self.saved_value(plugin_id, key) {
+            Some(None) => self.forget_change(plugin_id, key),
+            Some(Some(_)) => (),
+            None => self.record_change(plugin_id, key, Some(old)),
+        }
+        true
+    }
+
+    pub fn extend_variables<I>(&mut self, plugin_id: &str, iter: I)
+    where
+        I: IntoIterator<Item = (String, Vec<u8>)>,
+    {
+        for (key, value) in iter {
+            self.set_variable(plugin_id, &key, &value);
+        }
     }
 
-    pub fn save_all<W, I>(&mut self, writer: W, iter: I) -> Result<(), PersistError>
+    /// Saves the variables of several plugins to a file.
+    pub fn save_all<P, I>(&mut self, path: P, iter: I) -> Result<(), PersistError>
     where
-        W: Write,
+        P: AsRef<Path>,
         I: IntoIterator,
-        I::Item: Into<String>,
+        I::Item: AsRef<str>,
     {
+        let mut records = Vec::new();
         for plugin_id in iter {
-            self.copy_into_persist(plugin_id.into());
+            self.encode_changes(plugin_id.as_ref(), &mut records);
         }
-        self.persistent.save(writer)
+        self.persist(path.as_ref(), records)
+    }
+
+    /// Saves the variables of one plugin to a file.
+    pub fn save_one<P: AsRef<Path>>(
+        &mut self,
+        path: P,
+        plugin_id: &str,
+    ) -> Result<(), PersistError> {
+        let mut records = Vec::new();
+        self.encode_changes(plugin_id, &mut records);
+        self.persist(path.as_ref(), records)
     }
 
-    pub fn save_one<W: Write>(&mut self, writer: W, plugin_id: String) -> Result<(), PersistError> {
-        self.copy_into_persist(plugin_id);
-        self.persistent.save(writer)
+    fn saved_value(&self, plugin_id: &str, key: &str) -> Option<&Option<Vec<u8>>> {
+        self.unsaved.get(plugin_id)?.get(key)
     }
 
-    fn copy_into_persist(&mut self, plugin_id: String) {
-        match self.live.0.get(&plugin_id) {
-            Some(vars) => self.persistent.0.insert(plugin_id, vars.clone()),
-            None => self.persistent.0.remove(&plugin_id),
+    fn record_change(&mut self, plugin_id: &str, key: &str, saved: Option<Vec<u8>>) {
+        let Some(changes) = self.unsaved.get_mut(plugin_id) else {
+            let changes = HashMap::from([(key.to_owned(), saved)]);
+            self.unsaved.insert(plugin_id.to_owned(), changes);
+            return;
         };
+        changes.insert(key.to_owned(), saved);
+    }
+
+    fn forget_change(&mut self, plugin_id: &str, key: &str) {
+        let Some(changes) = self.unsaved.get_mut(plugin_id) else {
+            return;
+        };
+        changes.remove(key);
+        if changes.is_empty() {
+            self.unsaved.remove(plugin_id);
+        }
+    }
+
+    fn encode_changes(&mut self, plugin_id: &str, buf: &mut Vec<u8>) {
+        let Some(changes) = self.unsaved.remove(plugin_id) else {
+            return;
+        };
+        for key in changes.keys() {
+            Record {
+                plugin_id,
+                key,
+                value: self.live.get_variable(plugin_id, key),
+            }
+            .encode(buf);
+        }
+    }
+
+    /// Appends records to the journal of a file, or writes a full snapshot if the file is not the
+    /// one the journal belongs to or the journal has grown larger than the snapshot.
+    fn persist(&mut self, path: &Path, records: Vec<u8>) -> Result<(), PersistError> {
+        if let Some(store) = &mut self.store
+            && store.path() == path
+        {
+            if records.is_empty() {
+                return Ok(());
+            }
+            match store.append(records) {
+                Ok(()) if store.journal_len() <= self.snapshot_len.max(MIN_COMPACT_LEN) => {
+                    return Ok(());
+                }
+                Ok(()) => (),
+                // The journal may have been left with a partial record. Compacting empties it.
+                Err(e) => log::error!(target: "smushclient.variables", "{e}"),
+            }
+        }
+        if self
+            .store
+            .as_ref()
+            .is_some_and(|store| store.path() != path)
+        {
+            // Drop the old store first, so that it finishes writing before the new one starts.
+            self.store = None;
+        }
+        let snapshot = self.snapshot();
+        let store = self
+            .store
+            .get_or_insert_with(|| VariableStore::new(path.to_owned(), 0));
+        Ok(store.compact(snapshot)?)
+    }
+
+    /// Returns a function that writes the saved state of every variable. Sections are shared
+    /// with the live variables, so only plugins with unsaved changes, or that change before the
+    /// snapshot is written, are copied.
+    fn snapshot(&mut self) -> journal::Snapshot {
+        let mut saved = self.live.clone();
+        for (plugin_id, changes) in &self.unsaved {
+            for (key, value) in changes {
+                match value {
+                    Some(value) => saved.set_variable(plugin_id, key, value),
+                    None => {
+                        saved.unset_variable(plugin_id, key);
+                    }
+                }
+            }
+        }
+        self.snapshot_len = saved.byte_len();
+        Box::new(move |writer| saved.save(writer))
     }
 }
 
 impl From<PluginVariableMap> for PluginVariables {
     fn from(value: PluginVariableMap) -> Self {
         Self {
-            live: value.clone(),
-            persistent: value,
+            live: value,
+            unsaved: HashMap::new(),
+            store: None,
+            snapshot_len: 0,
         }
     }
 }
@@ -69,21 +244,19 @@ impl Deref for PluginVariables {
     }
 }
 
-impl DerefMut for PluginVariables {
-    fn deref_mut(&mut self) -> &mut Self::Target {
-        &mut self.live
-    }
-}
-
-#[derive(Clone, Debug, Default, PartialEq, Eq, Serialize, Deserialize)]
-#[serde(transparent)]
-pub(crate) struct PluginVariableMap(HashMap<String, HashMap<String, Vec<u8>>>);
+/// Variables of every plugin. Variables loaded from a file are decoded one plugin at a time, when
+/// they are first accessed.
+///
+/// Each plugin's section is shared between clones until one of them modifies it, so cloning the
+/// map only copies pointers.
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+pub(crate) struct PluginVariableMap(HashMap<String, Arc<PluginSection>>);
 
 impl fmt::Display for PluginVariableMap {
     fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
         for (id, vars) in &self.0 {
             writeln!(f, "{id}:")?;
-            for (key, val) in vars {
+            for (key, val) in vars.get() {
                 writeln!(f, "    {key}: {}", String::from_utf8_lossy(val))?;
             }
         }
@@ -93,11 +266,11 @@ impl fmt::Display for PluginVariableMap {
 
 impl PluginVariableMap {
     pub fn is_empty(&self) -> bool {
-        self.0.values().all(HashMap::is_empty)
+        self.0.values().all(|vars| vars.is_empty())
     }
 
     pub fn len(&self) -> usize {
-        self.0.values().map(HashMap::len).sum()
+        self.0.values().map(|vars| vars.len()).sum()
     }
 
     pub fn count_variables(&self, plugin_id: &str) -> usize {
@@ -108,26 +281,28 @@ impl PluginVariableMap {
     }
 
     pub fn get_variable(&self, plugin_id: &str, key: &str) -> Option<&[u8]> {
-        Some(self.0.get(plugin_id)?.get(key)?.as_slice())
+        Some(self.0.get(plugin_id)?.get().get(key)?.as_slice())
     }
 
     pub fn get_variables(&self, plugin_id: &str) -> Option<&HashMap<String, Vec<u8>>> {
-        self.0.get(plugin_id)
+        Some(self.0.get(plugin_id)?.get())
     }
 
     pub fn has_variable(&self, plugin_id: &str, key: &str) -> bool {
         self.0
             .get(plugin_id)
-            .is_some_and(|variables| variables.contains_key(key))
+            .is_some_and(|variables| variables.get().contains_key(key))
     }
 
     pub fn set_variable(&mut self, plugin_id: &str, key: &str, value: &[u8]) {
         let Some(variables) = self.0.get_mut(plugin_id) else {
             let mut variables = HashMap::new();
             variables.insert(key.to_owned(), value.to_owned());
-            self.0.insert(plugin_id.to_owned(), variables);
+            self.0
+                .insert(plugin_id.to_owned(), Arc::new(variables.into()));
             return;
         };
+        let variables = Arc::make_mut(variables).get_mut();
         match variables.get_mut(key) {
             Some(entry) => {
                 value.clone_into(entry);
@@ -138,8 +313,44 @@ impl PluginVariableMap {
         }
     }
 
+    /// Sets a variable, returning its previous value.
+    pub fn replace_variable(
+        &mut self,
+        plugin_id: &str,
+        key: &str,
+        value: Vec<u8>,
+    ) -> Option<Vec<u8>> {
+        let Some(variables) = self.0.get_mut(plugin_id) else {
+            let variables = HashMap::from([(key.to_owned(), value)]);
+            self.0
+                .insert(plugin_id.to_owned(), Arc::new(variables.into()));
+            return None;
+        };
+        Arc::make_mut(variables)
+            .get_mut()
+            .insert(key.to_owned(), value)
+    }
+
     pub fn unset_variable(&mut self, plugin_id: &str, key: &str) -> Option<Vec<u8>> {
-        self.0.get_mut(plugin_id)?.remove(key)
+        let variables = self.0.get_mut(plugin_id)?;
+        if !variables.get().contains_key(key) {
+            return None;
+        }
+        Arc::make_mut(variables).get_mut().remove(key)
+    }
+
+    /// Total size of every key and value.
+    pub fn byte_len(&self) -> u64 {
+        self.0.values().map(|vars| vars.byte_len()).sum()
+    }
+
+    fn apply(&mut self, record: Record) {
+        match record.value {
+            Some(value) => self.set_variable(record.plugin_id, record.key, value),
+            None => {
+                self.unset_variable(record.plugin_id, record.key);
+            }
+        }
     }
 
     pub fn export_variable(
@@ -156,24 +367,35 @@ impl PluginVariableMap {
         })
     }
 
-    pub(crate) fn world_variables_mut(&mut self) -> &mut HashMap<String, Vec<u8>> {
-        self.0.entry(String::new()).or_default()
-    }
-
-    fn save<W: Write>(&self, mut writer: W) -> Result<(), PersistError> {
+    fn save(&self, writer: &mut dyn Write) -> io::Result<()> {
         writer.write_all(&[CURRENT_VERSION])?;
-        postcard::to_io(self, writer)?;
+        for (plugin_id, variables) in &self.0 {
+            variables.write(writer, plugin_id)?;
+        }
         Ok(())
     }
 
-    fn load<R: Read>(mut reader: R) -> Result<Self, PersistError> {
-        let mut buf = Vec::new();
-        reader.read_to_end(&mut buf)?;
-        let [version, bytes @ ..] = &*buf else {
-            return Err(PersistError::Invalid);
-        };
-        match version {
-            2 => postcard::from_bytes(bytes).map_err(Into::into),
+    fn load(buf: Vec<u8>) -> Result<Self, PersistError> {
+        match buf.first() {
+            Some(2) => {
+                let map: HashMap<String, HashMap<String, Vec<u8>>> =
+                    postcard::from_bytes(&buf[1..])?;
+                Ok(Self(
+                    map.into_iter()
+                        .map(|(id, vars)| (id, Arc::new(vars.into())))
+                        .collect(),
+                ))
+            }
+            Some(3) => snapshot::read(&Arc::new(buf), 1)
+                .map(|sections| {
+                    Self(
+                        sections
+                            .into_iter()
+                            .map(|(id, vars)| (id, Arc::new(vars)))
+                            .collect(),
+                    )
+                })
+                .ok_or(PersistError::Invalid),
             _ => Err(PersistError::Invalid),
         }
     }
@@ -208,7 +430,89 @@ impl<'a, S: BuildHasher + Default> FromIterator<XmlVariable<'a>> for HashMap<Str
 impl From<XmlVec<XmlVariable<'_>>> for PluginVariableMap {
     fn from(value: XmlVec<XmlVariable>) -> Self {
         let mut vars = PluginVariableMap::default();
-        vars.0.insert(String::new(), value.into_iter().collect());
+        let variables: HashMap<_, _> = value.into_iter().collect();
+        vars.0.insert(String::new(), Arc::new(variables.into()));
         vars
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use std::path::PathBuf;
+    use std::{env, process};
+
+    use super::*;
+
+    fn temp_path(name: &str) -> PathBuf {
+        let dir = env::temp_dir().join(format!("smushclient-{name}-{}", process::id()));
+        let _ = fs::remove_dir_all(&dir);
+        fs::create_dir_all(&dir).unwrap();
+        dir.join("world.vars")
+    }
+
+    #[test]
+    fn restoring_value_is_not_dirty() {
+        let mut vars = PluginVariables::default();
+        vars.set_variable("plugin", "key", b"value");
+        assert!(vars.is_dirty());
+        vars.unset_variable("plugin", "key");
+        assert!(!vars.is_dirty());
+    }
+
+    #[test]
+    fn clone_shares_sections_until_modified() {
+        let mut live = PluginVariableMap::default();
+        live.set_variable("plugin", "a", b"1");
+        live.set_variable("other", "b", b"2");
+        let saved = live.clone();
+        live.set_variable("plugin", "a", b"3");
+        live.unset_variable("other", "missing");
+        assert!(Arc::ptr_eq(&live.0["other"], &saved.0["other"]));
+        assert!(!Arc::ptr_eq(&live.0["plugin"], &saved.0["plugin"]));
+        assert_eq!(saved.get_variable("plugin", "a"), Some(&b"1"[..]));
+        assert_eq!(live.get_variable("plugin", "a"), Some(&b"3"[..]));
+    }
+
+    #[test]
+    fn load_replays_journal() {
+        let path = temp_path("replay");
+        let mut vars = PluginVariables::default();
+        vars.set_variable("plugin", "a", b"1");
+        vars.set_variable("other", "b", b"2");
+        vars.save_all(&path, ["plugin"]).unwrap();
+        vars.set_variable("plugin", "a", b"3");
+        vars.set_variable("plugin", "c", b"4");
+        vars.save_one(&path, "plugin").unwrap();
+        vars.unset_variable("plugin", "c");
+        vars.save_one(&path, "plugin").unwrap();
+        drop(vars);
+        assert_ne!(fs::metadata(journal::journal_path(&path)).unwrap().len(), 0);
+        let vars = PluginVariables::load(&path).unwrap().unwrap();
+        assert_eq!(vars.get_variable("plugin", "a"), Some(&b"3"[..]));
+        assert_eq!(vars.get_variable("plugin", "c"), None);
+        assert_eq!(vars.get_variable("other", "b"), None);
+    }
+
+    #[test]
+    fn load_discards_torn_record() {
+        let path = temp_path("torn");
+        let mut vars = PluginVariables::default();
+        for value in [b"1", b"2", b"3"] {
+            vars.set_variable("plugin", "a", value);
+            vars.save_one(&path, "plugin").unwrap();
+        }
+        drop(vars);
+        let journal_path = journal::journal_path(&path);
+        let journal = OpenOptions::new().write(true).open(&journal_path).unwrap();
+        journal
+            .set_len(journal.metadata().unwrap().len() - 1)
+            .unwrap();
+        let mut vars = PluginVariables::load(&path).unwrap().unwrap();
+        assert_eq!(vars.get_variable("plugin", "a"), Some(&b"2"[..]));
+        vars.set_variable("plugin", "a", b"4");
+        vars.save_one(&path, "plugin").unwrap();
+        drop(vars);
+        let vars = PluginVariables::load(&path).unwrap().unwrap();
+        assert_eq!(vars.get_variable("plugin", "a"), Some(&b"4"[..]));
+    }
+}
@@ -1,5 +1,2 @@
-mod reuse_vec;
-pub(crate) use reuse_vec::ReuseVec;
-
 mod sort_on_drop;
 pub use sort_on_drop::SortOnDrop;
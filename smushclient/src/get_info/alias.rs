@@ -10,10 +10,7 @@ impl SmushClient {
         label: &str,
         info_type: i64,
     ) -> V::Output {
-        let Some(alias) = self
-            .senders::<Alias>(index)
-            .find(|alias| alias.label == label)
-        else {
+        let Some(alias) = self.senders::<Alias>(index).find_by_label(label) else {
             return V::visit_none();
         };
         match info_type {
@@ -3,20 +3,17 @@ use smushclient_plugins::{Occurrence, PluginIndex, SendTarget, Timer};
 
 use super::visitor::InfoVisitor;
 use crate::client::SmushClient;
-use crate::timer::Timers;
+use crate::timer::{TimerStats, Timers};
 
 impl SmushClient {
-    pub fn timer_info<V: InfoVisitor, T>(
+    pub fn timer_info<V: InfoVisitor>(
         &self,
         index: PluginIndex,
         label: &str,
         info_type: i64,
-        timers: &Timers<T>,
+        timers: &Timers,
     ) -> V::Output {
-        let Some(timer) = self
-            .senders::<Timer>(index)
-            .find(|timer| timer.label == label)
-        else {
+        let Some(timer) = self.senders::<Timer>(index).find_by_label(label) else {
             return V::visit_none();
         };
         match info_type {
@@ -32,7 +29,7 @@ impl SmushClient {
             7 => V::visit(timer.one_shot),
             8 => V::visit(matches!(timer.occurrence, Occurrence::Time(_))),
             // 9 => invocation count
-            // 10 => times matched
+            10 => V::visit(timers.stats(timer.id).map_or(0, |stats| stats.fired)),
             11 => V::visit(timers.last_occurrence(timer.id)),
             12 => V::visit(timers.next_occurrence(timer.id)),
             13 => V::visit(
@@ -53,6 +50,16 @@ impl SmushClient {
             24 => V::visit(timer.omit_from_log),
             // 25 => is executing
             // 26 => script is valid (handled by frontend)
+            27 => V::visit(
+                timers
+                    .stats(timer.id)
+                    .map_or(0, TimerStats::mean_lateness_ms),
+            ),
+            28 => V::visit(
+                timers
+                    .stats(timer.id)
+                    .map_or(0, |stats| stats.max_lateness_ms),
+            ),
             _ => V::visit_none(),
         }
     }
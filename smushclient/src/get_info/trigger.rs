@@ -10,10 +10,7 @@ impl SmushClient {
         label: &str,
         info_type: i64,
     ) -> V::Output {
-        let Some(trigger) = self
-            .senders::<Trigger>(index)
-            .find(|trigger| trigger.label == label)
-        else {
+        let Some(trigger) = self.senders::<Trigger>(index).find_by_label(label) else {
             return V::visit_none();
         };
         match info_type {
@@ -5,7 +5,10 @@ mod audio;
 pub use audio::{AudioError, AudioFilePlayback, AudioSinkStatus, PlayMode, StreamError};
 
 mod client;
-pub use client::SmushClient;
+pub use client::{
+    ReadBuffer, ReplayStats, SessionFrame, SessionReader, SessionRecorder, SmushClient, Throughput,
+    replay,
+};
 
 mod collections;
 pub use collections::SortOnDrop;
@@ -29,8 +32,11 @@ pub use plugins::{
 
 pub mod speedwalk;
 
+#[cfg(test)]
+mod testing;
+
 mod timer;
-pub use timer::{TimerConstructible, TimerFinish, TimerStart, Timers};
+pub use timer::{TimerConstructible, TimerStats, Timers};
 
 pub mod world;
-pub use world::{SenderMap, World, WorldConfig, fixup_html};
+pub use world::{SenderMap, SenderMapEdit, World, WorldConfig, fixup_html};
@@ -3,7 +3,7 @@ use smushclient_plugins::{Alias, Captures, PluginSender, Reaction, Trigger};
 use super::effects::{AliasEffects, SpanStyle, TriggerEffects};
 use crate::world::WorldConfig;
 
-pub(crate) trait PluginReaction: PluginSender {
+pub(crate) trait PluginReaction: PluginSender + AsRef<Reaction> {
     const AFFECTS_STYLE: bool;
     type Effects;
 
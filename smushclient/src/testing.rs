@@ -0,0 +1,141 @@
+//! Helpers for tests that drive a [`SmushClient`](crate::SmushClient) end to end.
+
+use std::ops::Range;
+
+use mud_transformer::output::{Output, OutputFragment};
+pub use smushclient_plugins::testing::time;
+
+use crate::SmushClient;
+use crate::handler::Handler;
+use crate::plugins::{SendRequest, SendScriptRequest, SpanStyle};
+use crate::world::World;
+
+/// Returns a client for a world, or `None` if audio cannot be initialized, e.g. on a machine
+/// without an output device.
+pub fn client(world: World<'static>) -> Option<SmushClient> {
+    match SmushClient::try_new(world, Default::default(), Default::default()) {
+        Ok(client) => Some(client),
+        Err(e) => {
+            eprintln!("skipping: {e}");
+            None
+        }
+    }
+}
+
+/// Something a client asked its [`Handler`] to do.
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub enum Event {
+    Text(String),
+    LineBreak,
+    Styles(Range<usize>),
+    Error(String),
+    Echo(String),
+    EraseLastLine,
+    Send {
+        plugin: usize,
+        text: String,
+    },
+    Script {
+        plugin: usize,
+        label: String,
+        wildcards: Vec<String>,
+    },
+}
+
+/// Handler that records everything it is asked to do, in order.
+#[derive(Default)]
+pub struct RecordingHandler<'a> {
+    pub events: Vec<Event>,
+    on_script: Option<Box<dyn FnMut(&SendScriptRequest) + 'a>>,
+}
+
+impl<'a> RecordingHandler<'a> {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Calls `f` for every script request after recording it, standing in for scripts that
+    /// change the client, e.g. by enabling or deleting senders.
+    pub fn on_script<F: FnMut(&SendScriptRequest) + 'a>(f: F) -> Self {
+        Self {
+            events: Vec::new(),
+            on_script: Some(Box::new(f)),
+        }
+    }
+
+    /// Labels of the senders that made script requests, in order.
+    pub fn scripts(&self) -> Vec<&str> {
+        self.events
+            .iter()
+            .filter_map(|event| match event {
+                Event::Script { label, .. } => Some(label.as_str()),
+                _ => None,
+            })
+            .collect()
+    }
+
+    pub fn lines(&self) -> usize {
+        self.events
+            .iter()
+            .filter(|event| **event == Event::LineBreak)
+            .count()
+    }
+}
+
+impl Handler for RecordingHandler<'_> {
+    fn apply_styles(&mut self, range: Range<usize>, _style: SpanStyle) {
+        self.events.push(Event::Styles(range));
+    }
+
+    fn display(&mut self, output: &Output) {
+        match &output.fragment {
+            OutputFragment::Text(fragment) => {
+                self.events.push(Event::Text(String::from(&*fragment.text)));
+            }
+            OutputFragment::LineBreak => self.events.push(Event::LineBreak),
+            _ => (),
+        }
+    }
+
+    fn display_error(&mut self, error: &str) {
+        self.events.push(Event::Error(error.to_owned()));
+    }
+
+    fn echo(&mut self, input: &str) {
+        self.events.push(Event::Echo(input.to_owned()));
+    }
+
+    fn erase_last_line(&mut self) {
+        self.events.push(Event::EraseLastLine);
+    }
+
+    fn send(&mut self, request: SendRequest) {
+        self.events.push(Event::Send {
+            plugin: request.plugin,
+            text: request.text.to_owned(),
+        });
+    }
+
+    fn send_script(&mut self, request: SendScriptRequest) {
+        let wildcards = match &request.wildcards {
+            Some(captures) => captures.iter().map(str::to_owned).collect(),
+            None => Vec::new(),
+        };
+        self.events.push(Event::Script {
+            plugin: request.plugin,
+            label: request.label.to_owned(),
+            wildcards,
+        });
+        if let Some(on_script) = &mut self.on_script {
+            on_script(&request);
+        }
+    }
+
+    fn permit_line(&mut self, _line: &str) -> bool {
+        true
+    }
+
+    fn permit_sound(&mut self, _file: &str) -> bool {
+        false
+    }
+}
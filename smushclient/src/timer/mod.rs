@@ -1,5 +1,8 @@
 mod send_timer;
 pub use send_timer::TimerConstructible;
 
+mod stats;
+pub use stats::TimerStats;
+
 mod timers;
-pub use timers::{TimerFinish, TimerStart, Timers};
+pub use timers::Timers;
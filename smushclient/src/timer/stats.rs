@@ -0,0 +1,29 @@
+use chrono::{DateTime, Utc};
+
+/// Firing statistics for a single timer, used to measure how late timers fire relative to their
+/// scheduled deadlines.
+#[derive(Copy, Clone, Debug, Default, PartialEq, Eq, Hash)]
+pub struct TimerStats {
+    pub fired: u64,
+    pub last_fired: Option<DateTime<Utc>>,
+    pub total_lateness_ms: u64,
+    pub max_lateness_ms: u64,
+}
+
+impl TimerStats {
+    pub fn record(&mut self, due: DateTime<Utc>, fired: DateTime<Utc>) {
+        let lateness = fired
+            .signed_duration_since(due)
+            .num_milliseconds()
+            .try_into()
+            .unwrap_or(0);
+        self.fired += 1;
+        self.last_fired = Some(fired);
+        self.total_lateness_ms = self.total_lateness_ms.saturating_add(lateness);
+        self.max_lateness_ms = self.max_lateness_ms.max(lateness);
+    }
+
+    pub fn mean_lateness_ms(&self) -> u64 {
+        self.total_lateness_ms.checked_div(self.fired).unwrap_or(0)
+    }
+}
@@ -1,243 +1,459 @@
-use std::collections::HashMap;
-use std::rc::Rc;
+use std::cmp::Reverse;
+use std::collections::{BinaryHeap, HashMap};
 
-use chrono::offset::LocalResult;
-use chrono::{DateTime, Days, Local, NaiveDate, NaiveTime, TimeDelta, Utc};
+use chrono::{
+    DateTime, Local, LocalResult, NaiveDateTime, NaiveTime, Offset, TimeDelta, TimeZone, Utc,
+};
 use smushclient_plugins::{Occurrence, PluginIndex, Timer};
 
-use super::send_timer::{RecurringTimer, ScheduledTimer, SendTimer, TimerConstructible};
+use super::send_timer::TimerConstructible;
+use super::stats::TimerStats;
 use crate::client::SmushClient;
-use crate::collections::ReuseVec;
-
-#[derive(Clone, Debug, PartialEq, Eq)]
-pub struct Timers<T> {
-    recurring: ReuseVec<RecurringTimer<T>>,
-    next_occurrences: HashMap<u16, DateTime<Utc>>,
-    scheduled: Vec<ScheduledTimer<T>>,
-    scheduled_times: HashMap<u16, NaiveTime>,
-    cursor_date: NaiveDate,
-    cursor_pos: usize,
-    last_occurrences: HashMap<u16, DateTime<Utc>>,
-}
 
-impl<T> Default for Timers<T> {
-    fn default() -> Self {
-        Self::new()
-    }
+#[derive(Copy, Clone, Debug, PartialEq, Eq, PartialOrd, Ord, Hash)]
+struct Deadline {
+    due: DateTime<Utc>,
+    id: u16,
 }
 
-impl<T> Timers<T> {
-    pub fn new() -> Self {
-        Self {
-            recurring: ReuseVec::new(),
-            next_occurrences: HashMap::new(),
-            scheduled: Vec::new(),
-            scheduled_times: HashMap::new(),
-            cursor_date: Local::now().date_naive(),
-            cursor_pos: 0,
-            last_occurrences: HashMap::new(),
-        }
-    }
+#[derive(Copy, Clone, Debug, PartialEq, Eq)]
+struct ScheduledTimer {
+    plugin: PluginIndex,
+    occurrence: Occurrence,
+    due: DateTime<Utc>,
 }
 
-#[derive(Copy, Clone, Debug, Default, PartialEq, Eq, PartialOrd, Ord, Hash)]
-pub struct TimerStart {
-    pub plugin: PluginIndex,
-    pub timer: u16,
-    pub milliseconds: u32,
+/// Deadline-ordered queue of enabled timers.
+///
+/// Only the earliest deadline needs to be armed by the frontend. Entries in the queue are
+/// invalidated lazily: when a timer is stopped or rescheduled, its old deadline is left in the
+/// heap and discarded when it reaches the front, because it no longer matches the timer's
+/// current deadline.
+#[derive(Clone, Debug, Default)]
+pub struct Timers {
+    scheduled: HashMap<u16, ScheduledTimer>,
+    queue: BinaryHeap<Reverse<Deadline>>,
+    stats: HashMap<u16, TimerStats>,
 }
 
-#[derive(Clone, Debug, Default, PartialEq, Eq, PartialOrd, Ord, Hash)]
-pub struct TimerFinish<T> {
-    pub done: bool,
-    pub timer: Option<Rc<T>>,
-}
+impl Timers {
+    pub fn new() -> Self {
+        Self::default()
+    }
 
-impl<T> Timers<T> {
     pub fn clear(&mut self) {
-        self.recurring.clear();
-        self.next_occurrences.clear();
         self.scheduled.clear();
-        self.scheduled_times.clear();
-        self.cursor_date = Local::now().date_naive();
-        self.cursor_pos = 0;
-        self.last_occurrences.clear();
+        self.queue.clear();
+        self.stats.clear();
     }
 
     pub fn reset_plugin(&mut self, index: PluginIndex) {
-        for timer in self.recurring.extract_if(|timer| timer.plugin == index) {
-            self.next_occurrences.remove(&timer.id);
-            self.last_occurrences.remove(&timer.id);
-        }
-        let scheduled_len = self.scheduled.len();
-        self.scheduled.retain(|timer| {
+        let stats = &mut self.stats;
+        self.scheduled.retain(|id, timer| {
             if timer.plugin != index {
                 return true;
             }
-            self.scheduled_times.remove(&timer.id);
+            stats.remove(id);
             false
         });
-        let scheduled_len_new = self.scheduled.len();
-        if scheduled_len_new == scheduled_len {
-            return;
+        self.compact();
+    }
+
+    /// Schedules a timer's next occurrence, replacing any existing deadline for it. Returns
+    /// `false` if the timer is disabled or can never fire, in which case it is unscheduled.
+    pub fn start(&mut self, index: PluginIndex, timer: &Timer) -> bool {
+        if !timer.enabled {
+            self.stop(timer.id);
+            return false;
         }
-        self.cursor_pos = match self
-            .scheduled
-            .binary_search_by_key(&Local::now().time(), |timer| timer.time)
-        {
-            Ok(pos) | Err(pos) => pos,
+        let Some(due) = next_due(timer.occurrence, Utc::now()) else {
+            self.stop(timer.id);
+            return false;
         };
+        self.schedule(
+            timer.id,
+            ScheduledTimer {
+                plugin: index,
+                occurrence: timer.occurrence,
+                due,
+            },
+        );
+        true
     }
 
-    pub fn last_occurrence(&self, timer_id: u16) -> Option<DateTime<Utc>> {
-        self.last_occurrences.get(&timer_id).copied()
+    /// Forgets a deleted timer, including its statistics.
+    pub fn remove(&mut self, timer_id: u16) {
+        self.stats.remove(&timer_id);
+        self.stop(timer_id);
     }
 
-    pub fn next_occurrence(&self, timer_id: u16) -> Option<DateTime<Utc>> {
-        if let Some(next) = self.next_occurrences.get(&timer_id) {
-            return Some(*next);
+    pub fn stop(&mut self, timer_id: u16) -> bool {
+        if self.scheduled.remove(&timer_id).is_none() {
+            return false;
         }
-        let next_time = *self.scheduled_times.get(&timer_id)?;
-        let now = Local::now();
-        let LocalResult::Single(next_date) = now.with_time(next_time) else {
-            return None;
-        };
-        if next_date < now
-            && let Some(next_date) = next_date.checked_add_days(Days::new(1))
-        {
-            return Some(next_date.to_utc());
-        }
-        Some(next_date.to_utc())
+        self.compact();
+        true
     }
-}
 
-impl<T: TimerConstructible> Timers<T> {
-    pub fn poll(&mut self, client: &SmushClient) -> Vec<Rc<T>> {
-        if self.scheduled.is_empty() {
-            return Vec::new();
-        }
-        let now = Local::now();
-        let today = now.date_naive();
-        let time = now.time();
-        let mut triggered = Vec::new();
-        loop {
-            if self.cursor_pos >= self.scheduled.len() {
-                if today > self.cursor_date {
-                    self.cursor_date = today;
-                    self.cursor_pos = 0;
-                } else {
-                    break;
-                }
+    /// Returns the earliest deadline that needs to be armed, if any timers are scheduled.
+    pub fn next_deadline(&mut self) -> Option<DateTime<Utc>> {
+        while let Some(&Reverse(deadline)) = self.queue.peek() {
+            if self.is_current(deadline) {
+                return Some(deadline.due);
             }
-            let send_timer = &self.scheduled[self.cursor_pos];
-            if send_timer.time > time {
+            self.queue.pop();
+        }
+        None
+    }
+
+    /// Pops every timer that is due at `now` and reschedules it for its next occurrence.
+    ///
+    /// Timers are revalidated against the client's current senders before firing, so timers
+    /// that were deleted or disabled since they were scheduled are dropped, and timers whose
+    /// occurrence was edited are rescheduled from `now` instead of firing.
+    pub fn poll<T: TimerConstructible>(
+        &mut self,
+        client: &SmushClient,
+        now: DateTime<Utc>,
+    ) -> Vec<T> {
+        let mut fired = Vec::new();
+        while let Some(&Reverse(deadline)) = self.queue.peek() {
+            if deadline.due > now {
                 break;
             }
-            self.cursor_pos += 1;
-            triggered.push(send_timer.timer.clone());
-            if send_timer.one_shot {
-                send_timer.remove(client);
-                self.cursor_pos -= 1;
-                self.scheduled_times.remove(&send_timer.id);
-                self.scheduled.remove(self.cursor_pos);
+            self.queue.pop();
+            if !self.is_current(deadline) {
+                continue;
+            }
+            let id = deadline.id;
+            let ScheduledTimer {
+                plugin, occurrence, ..
+            } = self.scheduled[&id];
+            if plugin >= client.plugins_len() {
+                self.scheduled.remove(&id);
+                continue;
             }
+            let senders = client.senders::<Timer>(plugin);
+            let one_shot = match senders.find(|timer| timer.id == id) {
+                Some(timer) if timer.enabled && timer.occurrence == occurrence => {
+                    fired.push(T::construct(plugin, &timer));
+                    timer.one_shot
+                }
+                Some(timer) if timer.enabled => {
+                    let occurrence = timer.occurrence;
+                    drop(timer);
+                    self.reschedule(id, plugin, occurrence, now, now);
+                    continue;
+                }
+                _ => {
+                    self.scheduled.remove(&id);
+                    continue;
+                }
+            };
+            self.stats.entry(id).or_default().record(deadline.due, now);
+            if one_shot {
+                self.scheduled.remove(&id);
+                self.stats.remove(&id);
+                if let Some(pos) = senders.position(|timer| timer.id == id) {
+                    senders.remove(pos);
+                }
+                continue;
+            }
+            self.reschedule(id, plugin, occurrence, deadline.due, now);
         }
-        triggered
+        fired
     }
 
-    pub fn start(&mut self, index: PluginIndex, timer: &Timer) -> Option<TimerStart> {
-        if !timer.enabled {
-            return None;
-        }
-        let occurrence = timer.occurrence;
-        let send_timer = SendTimer::new(index, timer);
-        match occurrence {
-            Occurrence::Time(time) => {
-                self.insert_scheduled(ScheduledTimer::new(send_timer, time));
-                None
-            }
-            Occurrence::Interval(duration) => {
-                let send_timer = RecurringTimer::new(send_timer, duration);
-                let start = TimerStart {
-                    plugin: index,
-                    timer: send_timer.id,
-                    milliseconds: send_timer.milliseconds,
-                };
-                self.insert_recurring(send_timer);
-                Some(start)
+    pub fn stats(&self, timer_id: u16) -> Option<&TimerStats> {
+        self.stats.get(&timer_id)
+    }
+
+    pub fn last_occurrence(&self, timer_id: u16) -> Option<DateTime<Utc>> {
+        self.stats.get(&timer_id)?.last_fired
+    }
+
+    pub fn next_occurrence(&self, timer_id: u16) -> Option<DateTime<Utc>> {
+        Some(self.scheduled.get(&timer_id)?.due)
+    }
+
+    fn is_current(&self, deadline: Deadline) -> bool {
+        self.scheduled
+            .get(&deadline.id)
+            .is_some_and(|timer| timer.due == deadline.due)
+    }
+
+    fn schedule(&mut self, id: u16, timer: ScheduledTimer) {
+        self.queue.push(Reverse(Deadline { due: timer.due, id }));
+        self.scheduled.insert(id, timer);
+    }
+
+    fn reschedule(
+        &mut self,
+        id: u16,
+        plugin: PluginIndex,
+        occurrence: Occurrence,
+        last_due: DateTime<Utc>,
+        now: DateTime<Utc>,
+    ) {
+        // Interval timers advance from their previous deadline so that lateness does not
+        // accumulate, unless they have fallen more than a whole interval behind.
+        let due = next_due(occurrence, last_due)
+            .filter(|&due| due > now)
+            .or_else(|| next_due(occurrence, now));
+        let Some(due) = due else {
+            self.scheduled.remove(&id);
+            return;
+        };
+        self.schedule(
+            id,
+            ScheduledTimer {
+                plugin,
+                occurrence,
+                due,
+            },
+        );
+    }
+
+    fn compact(&mut self) {
+        if self.queue.len() <= self.scheduled.len() * 2 + 16 {
+            return;
+        }
+        self.queue = self
+            .scheduled
+            .iter()
+            .map(|(&id, timer)| Reverse(Deadline { due: timer.due, id }))
+            .collect();
+    }
+}
+
+fn next_due(occurrence: Occurrence, after: DateTime<Utc>) -> Option<DateTime<Utc>> {
+    match occurrence {
+        Occurrence::Interval(interval) => {
+            let interval = TimeDelta::from_std(interval).ok()?;
+            if interval <= TimeDelta::zero() {
+                return None;
             }
+            after.checked_add_signed(interval)
         }
+        Occurrence::Time(time) => next_time_after(time, after, &Local),
     }
+}
 
-    pub fn finish(&mut self, id: usize, client: &SmushClient) -> TimerFinish<T> {
-        let Some(send_timer) = self.recurring.get(id) else {
-            return TimerFinish {
-                done: true,
-                timer: None,
-            };
-        };
-        self.next_occurrences.remove(&send_timer.id);
-        let timer = send_timer.timer.clone();
-        if !send_timer.one_shot {
-            self.last_occurrences.insert(send_timer.id, Utc::now());
-            return TimerFinish {
-                done: false,
-                timer: Some(timer),
-            };
+/// Returns the first moment after `after` at which clocks in `tz` read `time`.
+fn next_time_after<Tz: TimeZone>(
+    time: NaiveTime,
+    after: DateTime<Utc>,
+    tz: &Tz,
+) -> Option<DateTime<Utc>> {
+    let mut date = after.with_timezone(tz).date_naive();
+    loop {
+        let next = from_local(tz, date.and_time(time))?;
+        if next > after {
+            return Some(next);
         }
-        send_timer.remove(client);
-        self.recurring.remove(id);
-        TimerFinish {
-            done: true,
-            timer: Some(timer),
+        date = date.succ_opt()?;
+    }
+}
+
+/// Converts a local time to UTC. If clocks read the time twice, the earlier one is used. If
+/// clocks skip over it, e.g. when daylight saving time starts, it is read with the offset from
+/// before the skip, which lands as far past the skip as the time was into it.
+fn from_local<Tz: TimeZone>(tz: &Tz, local: NaiveDateTime) -> Option<DateTime<Utc>> {
+    match tz.from_local_datetime(&local) {
+        LocalResult::Single(time) | LocalResult::Ambiguous(time, _) => Some(time.to_utc()),
+        LocalResult::None => {
+            let day_before = local.checked_sub_signed(TimeDelta::days(1))?;
+            let offset = tz.offset_from_utc_datetime(&day_before).fix();
+            let utc =
+                local.checked_sub_signed(TimeDelta::seconds(offset.local_minus_utc().into()))?;
+            Some(utc.and_utc())
         }
     }
+}
 
-    fn insert_recurring(&mut self, timer: RecurringTimer<T>) -> usize {
-        let next_occurrence =
-            Utc::now().checked_add_signed(TimeDelta::milliseconds(timer.milliseconds.into()));
-        if let Some(next_occurrence) = next_occurrence {
-            self.next_occurrences.insert(timer.id, next_occurrence);
+#[cfg(test)]
+mod tests {
+    use std::borrow::Cow;
+    use std::time::Duration;
+
+    use chrono::{FixedOffset, NaiveDate};
+
+    use super::*;
+    use crate::testing;
+    use crate::world::World;
+
+    fn interval_timer(seconds: u64) -> Timer {
+        Timer {
+            occurrence: Occurrence::Interval(Duration::from_secs(seconds)),
+            ..Default::default()
         }
-        self.recurring.insert(timer)
     }
 
-    fn insert_scheduled(&mut self, timer: ScheduledTimer<T>) {
-        let time = timer.time;
-        self.scheduled_times.insert(timer.id, time);
-        let mut pos = match self.find_insert_index(&timer) {
-            Ok(pos) => pos,
-            Err(pos) => {
-                self.scheduled[pos] = timer;
-                return;
-            }
+    #[test]
+    fn next_deadline_skips_stale_entries() {
+        let mut timers = Timers::new();
+        let short = interval_timer(10);
+        let long = interval_timer(60);
+        assert!(timers.start(0, &short));
+        assert!(timers.start(0, &long));
+        assert_eq!(
+            timers.next_deadline(),
+            timers.next_occurrence(short.id),
+            "earliest timer should be armed"
+        );
+        assert!(timers.stop(short.id));
+        assert_eq!(timers.next_deadline(), timers.next_occurrence(long.id));
+        assert!(timers.stop(long.id));
+        assert_eq!(timers.next_deadline(), None);
+    }
+
+    #[test]
+    fn zero_interval_is_not_scheduled() {
+        let mut timers = Timers::new();
+        assert!(!timers.start(0, &interval_timer(0)));
+        assert_eq!(timers.next_deadline(), None);
+    }
+
+    #[derive(Debug, PartialEq, Eq)]
+    struct Fired(PluginIndex, u16);
+
+    impl TimerConstructible for Fired {
+        fn construct(index: PluginIndex, timer: &Timer) -> Self {
+            Self(index, timer.id)
+        }
+    }
+
+    /// Returns a client with one world timer, along with the world plugin's index and a copy of
+    /// the timer.
+    fn timer_client(timer: Timer) -> Option<(SmushClient, PluginIndex, Timer)> {
+        let client = testing::client(World {
+            timers: Cow::Owned(vec![timer]),
+            ..Default::default()
+        })?;
+        let index = client
+            .plugins()
+            .position(|plugin| plugin.metadata.is_world_plugin)
+            .unwrap();
+        let timer = client.senders::<Timer>(index).borrow()[0].clone();
+        Some((client, index, timer))
+    }
+
+    #[test]
+    fn interval_reschedule_does_not_drift() {
+        let Some((client, index, timer)) = timer_client(interval_timer(10)) else {
+            return;
         };
-        if let Some(old_pos) = self.find_index(&timer) {
-            if old_pos < pos {
-                pos -= 1;
-            }
-            if old_pos < self.cursor_pos {
-                self.cursor_pos -= 1;
+        let mut timers = Timers::new();
+        assert!(timers.start(index, &timer));
+        let due = timers.next_occurrence(timer.id).unwrap();
+        let fired: Vec<Fired> = timers.poll(&client, due + TimeDelta::seconds(3));
+        assert_eq!(fired, [Fired(index, timer.id)]);
+        assert_eq!(
+            timers.next_occurrence(timer.id),
+            Some(due + TimeDelta::seconds(10))
+        );
+        let fired: Vec<Fired> = timers.poll(&client, due + TimeDelta::seconds(25));
+        assert_eq!(fired.len(), 1);
+        assert_eq!(
+            timers.next_occurrence(timer.id),
+            Some(due + TimeDelta::seconds(35)),
+            "a timer more than an interval behind restarts from now"
+        );
+    }
+
+    #[test]
+    fn remove_forgets_deadline_and_stats() {
+        let Some((client, index, timer)) = timer_client(interval_timer(10)) else {
+            return;
+        };
+        let mut timers = Timers::new();
+        assert!(timers.start(index, &timer));
+        let due = timers.next_occurrence(timer.id).unwrap();
+        let _: Vec<Fired> = timers.poll(&client, due);
+        assert!(timers.stats(timer.id).is_some());
+        timers.remove(timer.id);
+        assert_eq!(timers.stats(timer.id), None);
+        assert_eq!(timers.next_occurrence(timer.id), None);
+        assert_eq!(timers.next_deadline(), None);
+    }
+
+    /// Time zone that moves its clocks from UTC to UTC+1 at 02:00 on 30 March 2025, so that
+    /// 02:00 to 03:00 never happens that day.
+    #[derive(Clone, Copy, Debug)]
+    struct SpringForward;
+
+    impl SpringForward {
+        fn shift() -> NaiveDateTime {
+            NaiveDateTime::parse_from_str("2025-03-30 02:00", "%Y-%m-%d %H:%M").unwrap()
+        }
+    }
+
+    impl TimeZone for SpringForward {
+        type Offset = FixedOffset;
+
+        fn from_offset(_: &FixedOffset) -> Self {
+            Self
+        }
+
+        fn offset_from_local_date(&self, local: &NaiveDate) -> LocalResult<FixedOffset> {
+            self.offset_from_local_datetime(&local.and_time(NaiveTime::MIN))
+        }
+
+        fn offset_from_local_datetime(&self, local: &NaiveDateTime) -> LocalResult<FixedOffset> {
+            let shift = Self::shift();
+            if *local < shift {
+                LocalResult::Single(FixedOffset::east_opt(0).unwrap())
+            } else if *local < shift + TimeDelta::hours(1) {
+                LocalResult::None
+            } else {
+                LocalResult::Single(FixedOffset::east_opt(3600).unwrap())
             }
-            self.scheduled.remove(old_pos);
         }
-        self.scheduled.insert(pos, timer);
 
-        if pos < self.cursor_pos || (pos == self.cursor_pos && time < Local::now().time()) {
-            self.cursor_pos += 1;
+        fn offset_from_utc_date(&self, utc: &NaiveDate) -> FixedOffset {
+            self.offset_from_utc_datetime(&utc.and_time(NaiveTime::MIN))
         }
-    }
 
-    fn find_insert_index(&self, timer: &ScheduledTimer<T>) -> Result<usize, usize> {
-        let id = timer.id;
-        match self.scheduled.binary_search(timer) {
-            Err(pos) if self.scheduled.get(pos).is_none_or(|timer| timer.id != id) => Ok(pos),
-            Err(pos) | Ok(pos) => Err(pos),
+        fn offset_from_utc_datetime(&self, utc: &NaiveDateTime) -> FixedOffset {
+            let offset = if *utc < Self::shift() { 0 } else { 3600 };
+            FixedOffset::east_opt(offset).unwrap()
         }
     }
 
-    fn find_index(&self, timer: &ScheduledTimer<T>) -> Option<usize> {
-        let id = timer.id;
-        self.scheduled.iter().position(|timer| timer.id == id)
+    fn utc(time: &str) -> DateTime<Utc> {
+        NaiveDateTime::parse_from_str(time, "%Y-%m-%d %H:%M")
+            .unwrap()
+            .and_utc()
+    }
+
+    #[test]
+    fn time_in_skipped_hour_fires_after_skip() {
+        let time = NaiveTime::from_hms_opt(2, 30, 0).unwrap();
+        assert_eq!(
+            next_time_after(time, utc("2025-03-29 12:00"), &SpringForward),
+            Some(utc("2025-03-30 02:30")),
+            "02:30 local, read as UTC, is 03:30 local"
+        );
+        assert_eq!(
+            next_time_after(time, utc("2025-03-30 03:00"), &SpringForward),
+            Some(utc("2025-03-31 01:30"))
+        );
+    }
+
+    #[test]
+    fn time_is_scheduled_for_next_day_once_passed() {
+        let time = NaiveTime::from_hms_opt(1, 0, 0).unwrap();
+        assert_eq!(
+            next_time_after(time, utc("2025-03-29 00:30"), &SpringForward),
+            Some(utc("2025-03-29 01:00"))
+        );
+        assert_eq!(
+            next_time_after(time, utc("2025-03-29 01:00"), &SpringForward),
+            Some(utc("2025-03-30 01:00"))
+        );
+        assert_eq!(
+            next_time_after(time, utc("2025-03-30 01:00"), &SpringForward),
+            Some(utc("2025-03-31 00:00"))
+        );
     }
 }
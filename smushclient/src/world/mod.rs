@@ -18,7 +18,7 @@ pub(crate) use numpad::XmlKey;
 pub use numpad::{Numpad, NumpadMapping};
 
 mod sender_map;
-pub use sender_map::SenderMap;
+pub use sender_map::{SenderMap, SenderMapEdit};
 
 mod serde_helpers;
 use serde_helpers::skip_temporary;
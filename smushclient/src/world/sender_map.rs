@@ -1,14 +1,47 @@
-use std::collections::HashMap;
+use std::collections::{HashMap, HashSet};
 use std::ops::Index;
 
 use smushclient_plugins::Sender;
 
+/// Index of a sender that has been removed, while a [`SenderMap`] is being edited.
+const REMOVED: usize = usize::MAX;
+
+/// A single step in transforming one [`SenderMap`] into another.
+///
+/// Steps returned by [`SenderMap::diff`] are applied in order, and the positions in each step
+/// refer to the map as it is after the steps before it, so that each step can be reported to a
+/// view as it is applied.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum SenderMapEdit {
+    /// Inserts the group at `source` in the target map at `index`.
+    InsertGroup {
+        index: usize,
+        source: usize,
+    },
+    RemoveGroup {
+        index: usize,
+    },
+    /// Inserts `count` rows of a group, starting from `source` in the target map, at `first`.
+    InsertRows {
+        group: usize,
+        first: usize,
+        source: usize,
+        count: usize,
+    },
+    RemoveRows {
+        group: usize,
+        first: usize,
+        count: usize,
+    },
+}
+
 #[derive(Clone, Debug, Default, PartialEq, Eq)]
 pub struct SenderMap {
     #[allow(clippy::vec_box)] // need static addresses for equality comparison
     group_names: Vec<Box<String>>,
     group_indices: HashMap<String, usize>,
     sender_indices: HashMap<String, Vec<usize>>,
+    sender_ids: HashMap<String, Vec<u16>>,
 }
 
 impl SenderMap {
@@ -43,7 +76,11 @@ impl SenderMap {
     }
 
     pub fn sender_index(&self, group: &str, index: usize) -> Option<usize> {
-        Some(*self.sender_indices.get(group)?.get(index)?)
+        let index = *self.sender_indices.get(group)?.get(index)?;
+        if index == REMOVED {
+            return None;
+        }
+        Some(index)
     }
 
     pub fn recalculate<I>(&mut self, iter: I)
@@ -54,17 +91,195 @@ impl SenderMap {
         for indices in self.sender_indices.values_mut() {
             indices.clear();
         }
+        for ids in self.sender_ids.values_mut() {
+            ids.clear();
+        }
         for (i, sender) in iter.into_iter().enumerate() {
-            let group = &sender.as_ref().group;
+            let sender = sender.as_ref();
+            let group = &sender.group;
             if let Some(present) = self.sender_indices.get_mut(group) {
                 present.push(i);
             } else {
                 self.sender_indices.insert(group.clone(), vec![i]);
             }
+            if let Some(present) = self.sender_ids.get_mut(group) {
+                present.push(sender.id);
+            } else {
+                self.sender_ids.insert(group.clone(), vec![sender.id]);
+            }
         }
         self.retain_nonempty();
     }
 
+    /// Returns the steps that transform this map into `target`. Senders are matched by ID, so
+    /// senders that were added to or removed from a list only insert or remove their own rows.
+    pub fn diff(&self, target: &Self) -> Vec<SenderMapEdit> {
+        let mut edits = Vec::new();
+        let old = &self.group_names;
+        let new = &target.group_names;
+        let (mut i, mut j, mut index) = (0, 0, 0);
+        while i < old.len() || j < new.len() {
+            match (old.get(i), new.get(j)) {
+                (Some(old_name), Some(new_name)) if old_name == new_name => {
+                    self.diff_group(old_name, index, target, &mut edits);
+                    i += 1;
+                    j += 1;
+                    index += 1;
+                }
+                (Some(old_name), new_name) if new_name.is_none_or(|name| old_name < name) => {
+                    edits.push(SenderMapEdit::RemoveGroup { index });
+                    i += 1;
+                }
+                _ => {
+                    edits.push(SenderMapEdit::InsertGroup { index, source: j });
+                    j += 1;
+                    index += 1;
+                }
+            }
+        }
+        edits
+    }
+
+    fn diff_group(&self, name: &str, group: usize, target: &Self, edits: &mut Vec<SenderMapEdit>) {
+        let old = &self.sender_ids[name];
+        let new = &target.sender_ids[name];
+        let old_set: HashSet<u16> = old.iter().copied().collect();
+        let new_set: HashSet<u16> = new.iter().copied().collect();
+        let (mut i, mut j) = (0, 0);
+        // Rows before this one are the same as in the target.
+        let mut first = 0;
+        while i < old.len() || j < new.len() {
+            if i < old.len() && !new_set.contains(&old[i]) {
+                let start = i;
+                while i < old.len() && !new_set.contains(&old[i]) {
+                    i += 1;
+                }
+                edits.push(SenderMapEdit::RemoveRows {
+                    group,
+                    first,
+                    count: i - start,
+                });
+            } else if j < new.len() && !old_set.contains(&new[j]) {
+                let source = j;
+                while j < new.len() && !old_set.contains(&new[j]) {
+                    j += 1;
+                }
+                let count = j - source;
+                edits.push(SenderMapEdit::InsertRows {
+                    group,
+                    first,
+                    source,
+                    count,
+                });
+                first += count;
+            } else if i < old.len() && j < new.len() && old[i] == new[j] {
+                i += 1;
+                j += 1;
+                first += 1;
+            } else {
+                // The remaining senders were reordered, so replace them.
+                if i < old.len() {
+                    edits.push(SenderMapEdit::RemoveRows {
+                        group,
+                        first,
+                        count: old.len() - i,
+                    });
+                }
+                if j < new.len() {
+                    edits.push(SenderMapEdit::InsertRows {
+                        group,
+                        first,
+                        source: j,
+                        count: new.len() - j,
+                    });
+                }
+                break;
+            }
+        }
+    }
+
+    /// Points every sender in the map at its index in `target`, in preparation for applying
+    /// edits. Senders that are not in `target` no longer have an index.
+    pub fn reindex(&mut self, target: &Self) {
+        let mut positions = HashMap::new();
+        for (group, ids) in &target.sender_ids {
+            let indices = &target.sender_indices[group];
+            positions.extend(ids.iter().copied().zip(indices.iter().copied()));
+        }
+        for (group, indices) in &mut self.sender_indices {
+            for (index, id) in indices.iter_mut().zip(&self.sender_ids[group]) {
+                *index = positions.get(id).copied().unwrap_or(REMOVED);
+            }
+        }
+    }
+
+    /// Applies a step returned by [`diff`](Self::diff) with the same `target`.
+    pub fn apply(&mut self, edit: SenderMapEdit, target: &Self) {
+        match edit {
+            SenderMapEdit::InsertGroup { index, source } => {
+                let name = &target.group_names[source];
+                self.group_names.insert(index, name.clone());
+                let name: &String = name;
+                self.sender_indices
+                    .insert(name.clone(), target.sender_indices[name].clone());
+                self.sender_ids
+                    .insert(name.clone(), target.sender_ids[name].clone());
+                self.renumber_groups(index);
+            }
+            SenderMapEdit::RemoveGroup { index } => {
+                let name = self.group_names.remove(index);
+                self.group_indices.remove(&*name);
+                self.sender_indices.remove(&*name);
+                self.sender_ids.remove(&*name);
+                self.renumber_groups(index);
+            }
+            SenderMapEdit::InsertRows {
+                group,
+                first,
+                source,
+                count,
+            } => {
+                let name: &String = &self.group_names[group];
+                let range = source..source + count;
+                let indices = &target.sender_indices[name][range.clone()];
+                let ids = &target.sender_ids[name][range];
+                let Some(present) = self.sender_indices.get_mut(name) else {
+                    return;
+                };
+                present.splice(first..first, indices.iter().copied());
+                let Some(present) = self.sender_ids.get_mut(name) else {
+                    return;
+                };
+                present.splice(first..first, ids.iter().copied());
+            }
+            SenderMapEdit::RemoveRows {
+                group,
+                first,
+                count,
+            } => {
+                let name: &String = &self.group_names[group];
+                let range = first..first + count;
+                if let Some(indices) = self.sender_indices.get_mut(name) {
+                    indices.drain(range.clone());
+                }
+                if let Some(ids) = self.sender_ids.get_mut(name) {
+                    ids.drain(range);
+                }
+            }
+        }
+    }
+
+    fn renumber_groups(&mut self, start: usize) {
+        for (i, group_name) in self.group_names.iter().enumerate().skip(start) {
+            let group_name: &String = group_name;
+            if let Some(entry) = self.group_indices.get_mut(group_name) {
+                *entry = i;
+            } else {
+                self.group_indices.insert(group_name.clone(), i);
+            }
+        }
+    }
+
     fn retain_nonempty(&mut self) {
         self.group_names.retain(|group| {
             self.sender_indices
@@ -83,14 +298,11 @@ impl SenderMap {
             }
             true
         });
-        for (i, group_name) in self.group_names.iter().enumerate() {
-            let group_name: &String = group_name;
-            if let Some(entry) = self.group_indices.get_mut(group_name) {
-                *entry = i;
-            } else {
-                self.group_indices.insert(group_name.clone(), i);
-            }
-        }
+        self.sender_ids
+            .retain(|group, _| self.sender_indices.contains_key(group));
+        self.group_indices
+            .retain(|group, _| self.sender_indices.contains_key(group));
+        self.renumber_groups(0);
     }
 }
 
@@ -122,3 +334,94 @@ where
         Self::from_iter(value)
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    struct TestSender(Sender);
+
+    impl AsRef<Sender> for TestSender {
+        fn as_ref(&self) -> &Sender {
+            &self.0
+        }
+    }
+
+    fn sender(group: &str, id: u16) -> TestSender {
+        TestSender(Sender {
+            group: group.to_owned(),
+            id,
+            ..Default::default()
+        })
+    }
+
+    fn assert_transforms(old: &[TestSender], new: &[TestSender]) -> Vec<SenderMapEdit> {
+        let mut map = SenderMap::from_iter(old);
+        let target = SenderMap::from_iter(new);
+        let edits = map.diff(&target);
+        map.reindex(&target);
+        for &edit in &edits {
+            map.apply(edit, &target);
+        }
+        assert_eq!(map, target);
+        edits
+    }
+
+    #[test]
+    fn diff_insert_into_group() {
+        let edits = assert_transforms(
+            &[sender("a", 1), sender("a", 2)],
+            &[sender("a", 1), sender("a", 3), sender("a", 2)],
+        );
+        assert_eq!(
+            edits,
+            [SenderMapEdit::InsertRows {
+                group: 0,
+                first: 1,
+                source: 1,
+                count: 1
+            }]
+        );
+    }
+
+    #[test]
+    fn diff_groups() {
+        let edits = assert_transforms(
+            &[sender("a", 1), sender("c", 2)],
+            &[sender("b", 3), sender("c", 2)],
+        );
+        assert_eq!(
+            edits,
+            [
+                SenderMapEdit::RemoveGroup { index: 0 },
+                SenderMapEdit::InsertGroup {
+                    index: 0,
+                    source: 0
+                },
+            ]
+        );
+    }
+
+    #[test]
+    fn diff_remove_and_reorder() {
+        assert_transforms(
+            &[
+                sender("", 1),
+                sender("", 2),
+                sender("", 3),
+                sender("", 4),
+                sender("x", 5),
+            ],
+            &[sender("", 1), sender("", 4), sender("", 3), sender("", 6)],
+        );
+    }
+
+    #[test]
+    fn reindex_hides_removed_senders() {
+        let mut map = SenderMap::from_iter(&[sender("", 1), sender("", 2)]);
+        let target = SenderMap::from_iter(&[sender("", 2)]);
+        map.reindex(&target);
+        assert_eq!(map.sender_index("", 0), None);
+        assert_eq!(map.sender_index("", 1), Some(0));
+    }
+}